@@ -0,0 +1,10 @@
+#include "ISpudObject.h"
+
+#include "SpudSubsystem.h"
+
+void ISpudObject::MarkSpudDirty()
+{
+	UObject* Obj = _getUObject();
+	if (auto SpudSystem = GetSpudSubsystem(Obj->GetWorld()))
+		SpudSystem->MarkSpudDirty(Obj);
+}
@@ -2,18 +2,61 @@
 
 #include <algorithm>
 #include "Async/Async.h"
+#include "Async/AsyncFileHandle.h"
+#include "Async/ParallelFor.h"
 #include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Compression.h"
 #include "Misc/Paths.h"
+#include "Misc/ScopeRWLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
 
 #include "SpudPropertyUtil.h"
 
 DEFINE_LOG_CATEGORY(LogSpudData)
 
-// System version covers our internal format changes
-#define SPUD_CURRENT_SYSTEM_VERSION 4
+// Maximum number of level files written at once when splitting a save into separate level files
+#define SPUD_MAX_CONCURRENT_LEVEL_WRITES 8
+// Block size & alignment for copying data between archives / files
+#define SPUD_COPY_BLOCK_SIZE (1024 * 1024)
+#define SPUD_COPY_BLOCK_ALIGNMENT 4096
 
 // int32 so that Blueprint-compatible. 2 billion should be enough anyway and you can always use the negatives
 int32 GCurrentUserDataModelVersion = 0;
+FName GSpudLevelDataCompressionFormat = NAME_None;
+FSpudEncodingProfile GSpudEncodingProfile;
+//------------------------------------------------------------------------------
+
+uint8 SpudCompressionFormatToCodec(FName Format)
+{
+	if (Format == NAME_Zlib)
+		return ESCC_Zlib;
+	if (Format == NAME_Gzip)
+		return ESCC_Gzip;
+	if (Format == NAME_LZ4)
+		return ESCC_LZ4;
+	if (Format == NAME_Oodle)
+		return ESCC_Oodle;
+	return ESCC_None;
+}
+
+FName SpudCompressionCodecToFormat(uint8 Codec)
+{
+	switch (Codec)
+	{
+	case ESCC_Zlib:
+		return NAME_Zlib;
+	case ESCC_Gzip:
+		return NAME_Gzip;
+	case ESCC_LZ4:
+		return NAME_LZ4;
+	case ESCC_Oodle:
+		return NAME_Oodle;
+	default:
+		return NAME_None;
+	}
+}
 //------------------------------------------------------------------------------
 
 bool FSpudChunkedDataArchive::PreviewNextChunk(FSpudChunkHeader& OutHeader, bool SeekBackToHeader)
@@ -167,6 +210,22 @@ void FSpudClassDef::WriteToArchive(FSpudChunkedDataArchive& Ar)
 			Ar << Def.PrefixID;
 			Ar << Def.DataType;
 		}
+		// Optional trailer, only present when not using the original encoding so that data is unchanged
+		if (Encoding.bCompact || Encoding.bIndexedObjectRefs)
+		{
+			uint8 Flags = ESCDF_None;
+			if (Encoding.bCompact)
+				Flags |= ESCDF_Compact;
+			if (Encoding.bIndexedObjectRefs)
+				Flags |= ESCDF_IndexedObjectRefs;
+			Ar << Flags;
+			if (Encoding.bCompact)
+			{
+				Ar << Encoding.PositionQuantum;
+				Ar << Encoding.RotationQuantum;
+				Ar << Encoding.ScaleQuantum;
+			}
+		}
 		ChunkEnd(Ar);
 	}	
 }
@@ -193,6 +252,22 @@ void FSpudClassDef::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSy
 
 			AddProperty(PropertyID, PrefixID, DataType);
 		}
+		// No trailer means the original encoding, which isn't the same as the default profile
+		Encoding = FSpudEncodingProfile();
+		Encoding.bIndexedObjectRefs = false;
+		if (IsStillInChunk(Ar))
+		{
+			uint8 Flags;
+			Ar << Flags;
+			if (Flags & ESCDF_Compact)
+			{
+				Encoding.bCompact = true;
+				Ar << Encoding.PositionQuantum;
+				Ar << Encoding.RotationQuantum;
+				Ar << Encoding.ScaleQuantum;
+			}
+			Encoding.bIndexedObjectRefs = (Flags & ESCDF_IndexedObjectRefs) != 0;
+		}
 		RuntimeMatchState.Empty();
 		ChunkEnd(Ar);
 	}	
@@ -282,6 +357,9 @@ void FSpudPropertyData::WriteToArchive(FSpudChunkedDataArchive& Ar)
 	{
 		Ar << PropertyOffsets;
 		Ar << Data;
+		// Optional, only present for archetype deltas
+		if (PresentProperties.Num() > 0)
+			Ar << PresentProperties;
 		ChunkEnd(Ar);
 	}
 }
@@ -297,10 +375,13 @@ void FSpudPropertyData::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 Stor
 
 	// Latest system version
 	PropertyOffsets.Empty();
+	PresentProperties.Empty();
 	if (ChunkStart(Ar))
 	{
 		Ar << PropertyOffsets;
 		Ar << Data;
+		if (IsStillInChunk(Ar))
+			Ar << PresentProperties;
 		ChunkEnd(Ar);
 	}
 }
@@ -312,6 +393,7 @@ void FSpudPropertyData::ReadFromArchiveV1(FSpudChunkedDataArchive& Ar)
 	// We need to read this back the old way for compatibility
 
 	PropertyOffsets.Empty();
+	PresentProperties.Empty();
 	Ar << PropertyOffsets;
 	// This bit used to be a call to inherited Read, hence wrapping incorrectly
 	if (ChunkStart(Ar))
@@ -325,6 +407,7 @@ void FSpudPropertyData::Reset()
 {
 	PropertyOffsets.Empty();
 	Data.Empty();
+	PresentProperties.Empty();
 }
 
 //------------------------------------------------------------------------------
@@ -441,10 +524,10 @@ void FSpudSpawnedActorData::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32
 bool FSpudNamedObjectMap::RenameObject(const FString& OldName, const FString& NewName)
 {
 	FSpudNamedObjectData ObjData;
-	if(Contents.RemoveAndCopyValue(OldName, ObjData))
+	if(Contents.RemoveAndCopyValue(FName(*OldName), ObjData))
 	{
 		ObjData.Name = NewName;
-		Contents.Add(NewName, ObjData);
+		Contents.Add(ObjData.Key(), ObjData);
 		return true;
 	}
 	return false;
@@ -470,6 +553,10 @@ void FSpudClassMetadata::WriteToArchive(FSpudChunkedDataArchive& Ar)
 		ClassNameIndex.WriteToArchive(Ar);
 		ClassDefinitions.WriteToArchive(Ar);
 		PropertyNameIndex.WriteToArchive(Ar);
+		if (ObjectRefIndex.UniqueValues.Num() > 0)
+			ObjectRefIndex.WriteToArchive(Ar);
+		if (AssetPathIndex.UniqueValues.Num() > 0)
+			AssetPathIndex.WriteToArchive(Ar);
 
 		ChunkEnd(Ar);
 	}
@@ -483,7 +570,11 @@ void FSpudClassMetadata::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 Sto
 		const uint32 ClassNameIndexID = FSpudChunkHeader::EncodeMagic(SPUDDATA_CLASSNAMEINDEX_MAGIC);
 		const uint32 ClassDefListID = FSpudChunkHeader::EncodeMagic(SPUDDATA_CLASSDEFINITIONLIST_MAGIC);
 		const uint32 PropertyNameIndexID = FSpudChunkHeader::EncodeMagic(SPUDDATA_PROPERTYNAMEINDEX_MAGIC);
+		const uint32 ObjectRefIndexID = FSpudChunkHeader::EncodeMagic(SPUDDATA_OBJECTREFINDEX_MAGIC);
+		const uint32 AssetPathIndexID = FSpudChunkHeader::EncodeMagic(SPUDDATA_ASSETPATHINDEX_MAGIC);
 		FSpudChunkHeader Hdr;
+		ObjectRefIndex.Empty();
+		AssetPathIndex.Empty();
 		while (IsStillInChunk(Ar))
 		{
 			Ar.PreviewNextChunk(Hdr, true);
@@ -495,6 +586,10 @@ void FSpudClassMetadata::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 Sto
 				ClassDefinitions.ReadFromArchive(Ar, StoredSystemVersion);
 			else if (Hdr.Magic == PropertyNameIndexID)
 				PropertyNameIndex.ReadFromArchive(Ar, StoredSystemVersion);
+			else if (Hdr.Magic == ObjectRefIndexID)
+				ObjectRefIndex.ReadFromArchive(Ar, StoredSystemVersion);
+			else if (Hdr.Magic == AssetPathIndexID)
+				AssetPathIndex.ReadFromArchive(Ar, StoredSystemVersion);
 			else
 				Ar.SkipNextChunk();
 		}
@@ -514,6 +609,8 @@ TSharedPtr<FSpudClassDef> FSpudClassMetadata::FindOrAddClassDef(const FString& C
 		for (int i = OldNum; i < Index + 1; ++i)
 		{
 			ClassDefinitions.Values[i] = MakeShareable(new FSpudClassDef());
+			// Encoding is fixed from here on, existing instance data must stay readable
+			ClassDefinitions.Values[i]->Encoding = GSpudEncodingProfile;
 		}
 		// Set ClassName to correct one
 		ClassDefinitions.Values[Index]->ClassName = ClassName;
@@ -596,6 +693,17 @@ void FSpudClassMetadata::Reset()
 	ClassDefinitions.Reset();
 	PropertyNameIndex.Empty();
 	ClassNameIndex.Empty();	
+	ObjectRefIndex.Empty();
+	AssetPathIndex.Empty();
+}
+
+void FSpudClassMetadata::DeepCopyClassDefinitions()
+{
+	for (auto& Def : ClassDefinitions.Values)
+	{
+		if (Def.IsValid())
+			Def = MakeShareable(new FSpudClassDef(*Def));
+	}
 }
 
 bool FSpudClassMetadata::RenameClass(const FString& OldClassName, const FString& NewClassName)
@@ -645,6 +753,15 @@ void FSpudLevelData::WriteToArchive(FSpudChunkedDataArchive& Ar)
 		return;
 	}
 
+	const FName CompressionFormat = GSpudLevelDataCompressionFormat;
+	if (!CompressionFormat.IsNone() && WriteCompressedToArchive(Ar, CompressionFormat))
+		return;
+
+	WriteUncompressedToArchive(Ar);
+}
+
+void FSpudLevelData::WriteUncompressedToArchive(FSpudChunkedDataArchive& Ar)
+{
 	if (ChunkStart(Ar))
 	{
 		Ar << Name;
@@ -656,6 +773,55 @@ void FSpudLevelData::WriteToArchive(FSpudChunkedDataArchive& Ar)
 	}
 }
 
+bool FSpudLevelData::WriteCompressedToArchive(FSpudChunkedDataArchive& Ar, FName Format)
+{
+	uint8 Codec = SpudCompressionFormatToCodec(Format);
+	if (Codec == ESCC_None)
+	{
+		UE_LOG(LogSpudData, Warning, TEXT("Unsupported level data compression format %s, writing %s uncompressed"), *Format.ToString(), *Name);
+		return false;
+	}
+
+	// Write the regular level chunk to memory, then compress the whole thing
+	TArray<uint8> UncompressedData;
+	FMemoryWriter MemWriter(UncompressedData);
+	FSpudChunkedDataArchive MemAr(MemWriter);
+	WriteUncompressedToArchive(MemAr);
+
+	uint32 UncompressedSize = UncompressedData.Num();
+	int32 CompressedSize = FCompression::CompressMemoryBound(Format, UncompressedSize);
+	TArray<uint8> CompressedData;
+	CompressedData.SetNumUninitialized(CompressedSize);
+	if (!FCompression::CompressMemory(Format, CompressedData.GetData(), CompressedSize, UncompressedData.GetData(), UncompressedSize))
+	{
+		UE_LOG(LogSpudData, Warning, TEXT("Failed to compress level data for %s with %s, writing uncompressed"), *Name, *Format.ToString());
+		return false;
+	}
+
+	FSpudAdhocWrapperChunk CompressedChunk(SPUDDATA_COMPRESSEDLEVELDATA_MAGIC);
+	if (CompressedChunk.ChunkStart(Ar))
+	{
+		Ar << Name;
+		Ar << Codec;
+		Ar << UncompressedSize;
+		Ar.Serialize(CompressedData.GetData(), CompressedSize);
+		CompressedChunk.ChunkEnd(Ar);
+
+		// Record where we actually were written rather than the in-memory copy
+		ChunkHeader = CompressedChunk.ChunkHeader;
+		ChunkHeaderStart = CompressedChunk.ChunkHeaderStart;
+		ChunkDataStart = CompressedChunk.ChunkDataStart;
+		ChunkDataEnd = CompressedChunk.ChunkDataEnd;
+	}
+	return true;
+}
+
+bool FSpudLevelData::IsLevelDataMagic(uint32 EncodedMagic)
+{
+	return EncodedMagic == FSpudChunkHeader::EncodeMagic(SPUDDATA_LEVELDATA_MAGIC) ||
+		EncodedMagic == FSpudChunkHeader::EncodeMagic(SPUDDATA_COMPRESSEDLEVELDATA_MAGIC);
+}
+
 bool FSpudLevelData::ReadLevelInfoFromArchive(FSpudChunkedDataArchive& Ar, bool bReturnToStart, FString& OutLevelName, int64& OutDataSize)
 {
 	// No lock needed as we're not populating anything, this method can  be static
@@ -670,7 +836,8 @@ bool FSpudLevelData::ReadLevelInfoFromArchive(FSpudChunkedDataArchive& Ar, bool
 	FSpudChunkHeader Hdr;
 	Ar << Hdr;
 
-	if (FSpudChunkHeader::EncodeMagic(SPUDDATA_LEVELDATA_MAGIC) != Hdr.Magic)
+	// Compressed level chunks also start with the uncompressed name
+	if (!IsLevelDataMagic(Hdr.Magic))
 	{
 		UE_LOG(LogSpudData, Error, TEXT("Cannot ReadLevelNameFromArchive from %s, next chunk is not a level"), *Ar.GetArchiveName())
 		if (bReturnToStart)
@@ -691,6 +858,12 @@ bool FSpudLevelData::ReadLevelInfoFromArchive(FSpudChunkedDataArchive& Ar, bool
 void FSpudLevelData::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSystemVersion)
 {
 	FScopeLock Lock(&Mutex);
+
+	if (Ar.NextChunkIs(SPUDDATA_COMPRESSEDLEVELDATA_MAGIC))
+	{
+		ReadCompressedFromArchive(Ar, StoredSystemVersion);
+		return;
+	}
 	
 	// Separate loading process since it's easier to deal with chunk robustness and versions
 	if (ChunkStart(Ar))
@@ -723,6 +896,59 @@ void FSpudLevelData::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredS
 	}
 }
 
+void FSpudLevelData::ReadCompressedFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSystemVersion)
+{
+	FSpudAdhocWrapperChunk CompressedChunk(SPUDDATA_COMPRESSEDLEVELDATA_MAGIC);
+	if (CompressedChunk.ChunkStart(Ar))
+	{
+		FString CompressedName;
+		uint8 Codec;
+		uint32 UncompressedSize;
+		Ar << CompressedName;
+		Ar << Codec;
+		Ar << UncompressedSize;
+
+		// Sizes come from the file, so make sure they're plausible before allocating anything from them.
+		// No codec we use gets better than about 1000:1 even on runs of zeroes
+		constexpr int64 MaxCompressionRatio = 1024;
+		const int64 CompressedSize64 = CompressedChunk.ChunkDataEnd - Ar.Tell();
+		if (Ar.IsError() ||
+			CompressedSize64 <= 0 || CompressedSize64 > MAX_int32 ||
+			UncompressedSize > MAX_int32 || UncompressedSize > CompressedSize64 * MaxCompressionRatio)
+		{
+			UE_LOG(LogSpudData, Error, TEXT("Compressed level data for %s in %s has invalid sizes (%lld compressed, %u uncompressed), the save file is corrupt"),
+				*CompressedName, *Ar.GetArchiveName(), CompressedSize64, UncompressedSize);
+			Ar.SetError();
+			CompressedChunk.ChunkEnd(Ar);
+			return;
+		}
+
+		const int32 CompressedSize = static_cast<int32>(CompressedSize64);
+		TArray<uint8> CompressedData;
+		CompressedData.SetNumUninitialized(CompressedSize);
+		Ar.Serialize(CompressedData.GetData(), CompressedSize);
+
+		const FName Format = SpudCompressionCodecToFormat(Codec);
+		TArray<uint8> UncompressedData;
+		UncompressedData.SetNumUninitialized(UncompressedSize);
+		if (Ar.IsError() || Format.IsNone() ||
+			!FCompression::UncompressMemory(Format, UncompressedData.GetData(), UncompressedSize, CompressedData.GetData(), CompressedSize))
+		{
+			UE_LOG(LogSpudData, Error, TEXT("Unable to decompress level data for %s (codec %d), level state will be missing"),
+				*CompressedName, Codec);
+		}
+		else
+		{
+			// The uncompressed data is a regular level chunk
+			FMemoryReader MemReader(UncompressedData);
+			FSpudChunkedDataArchive MemAr(MemReader);
+			ReadFromArchive(MemAr, StoredSystemVersion);
+		}
+		
+		CompressedChunk.ChunkEnd(Ar);
+	}
+}
+
 void FSpudLevelData::PreStoreWorld()
 {
 	FScopeLock Lock(&Mutex);
@@ -732,6 +958,39 @@ void FSpudLevelData::PreStoreWorld()
 	Metadata.Reset();
 	LevelActors.Reset();
 	SpawnedActors.Reset();
+	bModified = true;
+}
+
+void FSpudLevelData::PreIncrementalStoreWorld()
+{
+	FScopeLock Lock(&Mutex);
+
+	for (auto& Pair : LevelActors.Contents)
+		Pair.Value.bStored = false;
+	for (auto& Pair : SpawnedActors.Contents)
+		Pair.Value.bStored = false;
+}
+
+void FSpudLevelData::PostIncrementalStoreWorld()
+{
+	FScopeLock Lock(&Mutex);
+
+	for (auto It = LevelActors.Contents.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().bStored)
+		{
+			It.RemoveCurrent();
+			bModified = true;
+		}
+	}
+	for (auto It = SpawnedActors.Contents.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().bStored)
+		{
+			It.RemoveCurrent();
+			bModified = true;
+		}
+	}
 }
 
 void FSpudLevelData::Reset()
@@ -860,6 +1119,8 @@ void FSpudSaveInfo::Reset()
 {
 	Title = FText();
 	Screenshot.ImageData.Empty();
+	Screenshot.ImageDataOffset = -1;
+	Screenshot.ImageDataSize = 0;
 	CustomInfo.Reset();
 }
 
@@ -871,7 +1132,7 @@ void FSpudScreenshot::WriteToArchive(FSpudChunkedDataArchive& Ar)
 	{
 		if (ChunkStart(Ar))
 		{
-			// Don't use << operator, just write the PNG data directly
+			// Don't use << operator, just write the image data directly
 			// Chunk header already tells us how big it is since it's the only content
 			Ar.Serialize(ImageData.GetData(), ImageData.Num());
 			
@@ -884,9 +1145,19 @@ void FSpudScreenshot::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 Stored
 {
 	if (ChunkStart(Ar))
 	{
-		// This chunk ONLY contains PNG data so data size from header is this
-		ImageData.SetNum(ChunkHeader.Length);
-		Ar.Serialize(ImageData.GetData(), ChunkHeader.Length);
+		// This chunk ONLY contains image data so data size from header is this
+		ImageDataOffset = Ar.Tell();
+		ImageDataSize = ChunkHeader.Length;
+		if (bSkipImageData)
+		{
+			// ChunkEnd will skip over it
+			ImageData.Empty();
+		}
+		else
+		{
+			ImageData.SetNum(ChunkHeader.Length);
+			Ar.Serialize(ImageData.GetData(), ChunkHeader.Length);
+		}
 		ChunkEnd(Ar);
 	}
 }
@@ -926,6 +1197,106 @@ void FSpudSaveCustomInfo::Reset()
 	PropertyData.Empty();
 }
 
+//------------------------------------------------------------------------------
+void FSpudTableOfContents::WriteToArchive(FSpudChunkedDataArchive& Ar)
+{
+	if (ChunkStart(Ar))
+	{
+		Ar << Entries;
+		ChunkEnd(Ar);
+	}
+}
+
+void FSpudTableOfContents::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSystemVersion)
+{
+	if (ChunkStart(Ar))
+	{
+		Ar << Entries;
+		ChunkEnd(Ar);
+	}
+}
+
+FSpudTocEntry& FSpudTableOfContents::AddEntry(const FSpudChunk& Chunk, int64 InSaveStart)
+{
+	FSpudTocEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Magic = Chunk.ChunkHeader.Magic;
+	Entry.Offset = Chunk.ChunkHeaderStart - InSaveStart;
+	Entry.Length = Chunk.ChunkHeader.Length;
+	return Entry;
+}
+
+const FSpudTocEntry* FSpudTableOfContents::FindEntry(const char* Magic) const
+{
+	const uint32 EncodedMagic = FSpudChunkHeader::EncodeMagic(Magic);
+	return Entries.FindByPredicate([EncodedMagic](const FSpudTocEntry& Entry)
+	{
+		return Entry.Magic == EncodedMagic;
+	});
+}
+
+const FSpudTocEntry* FSpudTableOfContents::FindLevel(const FString& LevelName) const
+{
+	return Entries.FindByPredicate([&LevelName](const FSpudTocEntry& Entry)
+	{
+		return FSpudLevelData::IsLevelDataMagic(Entry.Magic) && Entry.Name == LevelName;
+	});
+}
+
+void FSpudTableOfContents::Reset()
+{
+	Entries.Empty();
+	SaveStart = 0;
+	SystemVersion = 0;
+}
+
+void FSpudTableOfContentsPointer::WriteToArchive(FSpudChunkedDataArchive& Ar)
+{
+	if (ChunkStart(Ar))
+	{
+		Ar << TocOffset;
+		ChunkEnd(Ar);
+	}
+}
+
+void FSpudTableOfContentsPointer::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSystemVersion)
+{
+	if (ChunkStart(Ar))
+	{
+		Ar << TocOffset;
+		ChunkEnd(Ar);
+	}
+}
+
+//------------------------------------------------------------------------------
+void FSpudSlotIndexEntry::WriteToArchive(FSpudChunkedDataArchive& Ar)
+{
+	if (ChunkStart(Ar))
+	{
+		Ar << SlotName;
+		Ar << FileSize;
+		Ar << FileTimestamp;
+		Ar << Info.Screenshot.ImageDataOffset;
+		Ar << Info.Screenshot.ImageDataSize;
+		// Info.Screenshot has no image data here, so only the location is stored
+		Info.WriteToArchive(Ar);
+		ChunkEnd(Ar);
+	}
+}
+
+void FSpudSlotIndexEntry::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSystemVersion)
+{
+	if (ChunkStart(Ar))
+	{
+		Ar << SlotName;
+		Ar << FileSize;
+		Ar << FileTimestamp;
+		Ar << Info.Screenshot.ImageDataOffset;
+		Ar << Info.Screenshot.ImageDataSize;
+		Info.ReadFromArchive(Ar, StoredSystemVersion);
+		ChunkEnd(Ar);
+	}
+}
+
 //------------------------------------------------------------------------------
 void FSpudSaveData::PrepareForWrite()
 {
@@ -937,21 +1308,247 @@ void FSpudSaveData::WriteToArchive(FSpudChunkedDataArchive& Ar)
 	WriteToArchive(Ar, "");
 }
 
+/// Writes level files on a few dedicated threads. Save files are read in the task pool (see USpudSubsystem::bAsyncLoadGame),
+/// so waiting for writes which were themselves pool tasks could starve a small pool. The queue is bounded so that
+/// only a few levels' data is held in memory while the reader is ahead of the writers.
+class FSpudLevelFileWriter
+{
+	FCriticalSection Mutex;
+	TArray<TPair<FString, TArray<uint8>>> Queue;
+	int32 MaxQueued;
+	bool bFinishing = false;
+	FEvent* WorkQueued;
+	FEvent* WorkTaken;
+	TArray<TFuture<void>> Threads;
+
+	void Run()
+	{
+		while (true)
+		{
+			TPair<FString, TArray<uint8>> Work;
+			{
+				FScopeLock Lock(&Mutex);
+				if (Queue.Num() > 0)
+				{
+					Work = MoveTemp(Queue[0]);
+					Queue.RemoveAt(0);
+				}
+				else if (bFinishing)
+				{
+					return;
+				}
+			}
+			if (Work.Key.IsEmpty())
+			{
+				// Timeout is just a backstop, the event is triggered for each file queued
+				WorkQueued->Wait(10);
+				continue;
+			}
+			WorkTaken->Trigger();
+			Write(Work.Key, Work.Value);
+		}
+	}
+
+	static void Write(const FString& Filename, const TArray<uint8>& Data)
+	{
+		IFileManager& FileMgr = IFileManager::Get();
+		auto OutLevelArchive = TUniquePtr<FArchive>(FileMgr.CreateFileWriter(*Filename));
+		if (!OutLevelArchive)
+		{
+			UE_LOG(LogSpudData, Error, TEXT("Error opening level data file for writing: %s"), *Filename);
+			return;
+		}
+		OutLevelArchive->Serialize(const_cast<uint8*>(Data.GetData()), Data.Num());
+		OutLevelArchive->Close();
+		if (OutLevelArchive->IsError() || OutLevelArchive->IsCriticalError())
+		{
+			UE_LOG(LogSpudData, Error, TEXT("Error while writing level data to %s"), *Filename);
+		}
+	}
+
+public:
+	FSpudLevelFileWriter(int32 NumThreads, int32 InMaxQueued) : MaxQueued(InMaxQueued)
+	{
+		WorkQueued = FPlatformProcess::GetSynchEventFromPool(false);
+		WorkTaken = FPlatformProcess::GetSynchEventFromPool(false);
+		for (int32 i = 0; i < NumThreads; ++i)
+		{
+			Threads.Add(Async(EAsyncExecution::Thread, [this]() { Run(); }));
+		}
+	}
+
+	~FSpudLevelFileWriter()
+	{
+		Finish();
+		FPlatformProcess::ReturnSynchEventToPool(WorkQueued);
+		FPlatformProcess::ReturnSynchEventToPool(WorkTaken);
+	}
+
+	/// Queue a level file to be written, waiting for the writers to catch up if the queue is full
+	void Add(const FString& Filename, TArray<uint8>&& Data)
+	{
+		while (true)
+		{
+			{
+				FScopeLock Lock(&Mutex);
+				if (Queue.Num() < MaxQueued)
+				{
+					Queue.Emplace(Filename, MoveTemp(Data));
+					break;
+				}
+			}
+			WorkTaken->Wait(10);
+		}
+		WorkQueued->Trigger();
+	}
+
+	/// Wait for all queued files to be written
+	void Finish()
+	{
+		{
+			FScopeLock Lock(&Mutex);
+			bFinishing = true;
+		}
+		for (auto& Thread : Threads)
+		{
+			WorkQueued->Trigger();
+			Thread.Wait();
+		}
+		Threads.Empty();
+	}
+};
+
+// Amount read from the start of a level chunk to find its name & metadata for the table of contents
+#define SPUD_LEVEL_PREVIEW_SIZE 4096
+
+static TUniquePtr<IAsyncReadFileHandle> SpudOpenAsyncRead(const FString& Filename, int64& OutFileSize);
+static int64 SpudCopyFileData(IAsyncReadFileHandle& Handle, int64 FileSize, const FString& Filename, int64 Offset, FArchive& OutArchive, int64 Length);
+
+/// Pipe a level chunk at a position in a file into a save being written, recording it in the TOC
+static bool SpudPipeLevelData(const FString& Filename, int64 Offset, FSpudChunkedDataArchive& OutAr, int64 SaveStart, TArray<FSpudTocEntry>& OutEntries)
+{
+	// One handle for the size, the preview & the copy
+	int64 FileSize;
+	auto Handle = SpudOpenAsyncRead(Filename, FileSize);
+	if (!Handle || Offset < 0 || Offset >= FileSize)
+		return false;
+	
+	// Just read enough of the level chunk for the table of contents before piping it
+	// Compressed data is piped as-is too
+	TArray<uint8> Preview;
+	Preview.SetNumUninitialized(static_cast<int32>(std::min(FileSize - Offset, static_cast<int64>(SPUD_LEVEL_PREVIEW_SIZE))));
+	{
+		TUniquePtr<IAsyncReadRequest> Request(Handle->ReadRequest(Offset, Preview.Num(), AIOP_Normal, nullptr, Preview.GetData()));
+		if (!Request)
+			return false;
+		Request->WaitCompletion();
+		if (!Request->GetReadResults())
+			return false;
+	}
+	FMemoryReader PreviewReader(Preview);
+	FSpudChunkedDataArchive InChunkedAr(PreviewReader);
+	FSpudChunkHeader Hdr;
+	FSpudTocEntry Entry;
+	int64 LevelDataSize;
+	if (!InChunkedAr.PreviewNextChunk(Hdr) ||
+		!FSpudLevelData::ReadLevelInfoFromArchive(InChunkedAr, false, Entry.Name, LevelDataSize) ||
+		InChunkedAr.IsError())
+		return false;
+
+	const int64 LevelStart = OutAr.Tell();
+	Entry.Magic = Hdr.Magic;
+	Entry.Offset = LevelStart - SaveStart;
+	Entry.Length = static_cast<uint32>(LevelDataSize);
+	// Metadata is always the first chunk after the name, unless it's compressed
+	if (Hdr.IsMagicEqual(SPUDDATA_LEVELDATA_MAGIC) && InChunkedAr.NextChunkIs(SPUDDATA_METADATA_MAGIC))
+		Entry.MetadataOffset = LevelStart + InChunkedAr.Tell() - SaveStart;
+
+	OutEntries.Add(Entry);
+
+	const int64 TotalSize = LevelDataSize + FSpudChunkHeader::GetHeaderSize();
+	return SpudCopyFileData(*Handle, FileSize, Filename, Offset, OutAr, TotalSize) == TotalSize;
+}
+
+/// Make a table of contents entry for level data which has just been written, with offsets relative to SaveStart
+static FSpudTocEntry SpudMakeLevelTocEntry(const FSpudLevelData& LevelData, int64 SaveStart)
+{
+	FSpudTocEntry Entry;
+	Entry.Magic = LevelData.ChunkHeader.Magic;
+	Entry.Offset = LevelData.ChunkHeaderStart - SaveStart;
+	Entry.Length = LevelData.ChunkHeader.Length;
+	Entry.Name = LevelData.Name;
+	// Metadata can't be located directly if the level was compressed
+	if (LevelData.ChunkHeader.IsMagicEqual(SPUDDATA_LEVELDATA_MAGIC))
+		Entry.MetadataOffset = LevelData.Metadata.ChunkHeaderStart - SaveStart;
+	return Entry;
+}
+
 void FSpudSaveData::WriteToArchive(FSpudChunkedDataArchive& Ar, const FString& LevelPath)
 {
 	if (ChunkStart(Ar))
 	{
+		// Record where everything goes so readers can seek straight to it later
+		FSpudTableOfContents Toc;
+		
 		Info.WriteToArchive(Ar);	
+		Toc.AddEntry(Info, ChunkHeaderStart);
 		GlobalData.WriteToArchive(Ar);
+		Toc.AddEntry(GlobalData, ChunkHeaderStart).MetadataOffset = GlobalData.Metadata.ChunkHeaderStart - ChunkHeaderStart;
 
 		// Manually write the level data because its source could be memory, or piped in from files
 		FSpudAdhocWrapperChunk LevelDataMapChunk(SPUDDATA_LEVELDATAMAP_MAGIC);
 		if (LevelDataMapChunk.ChunkStart(Ar))
 		{
+			TArray<FSpudTocEntry> LevelEntries;
 			FScopeLock MapLock(&LevelDataMapMutex);
-			for (auto&& KV : LevelDataMap)
+			TArray<TLevelDataPtr> Levels;
+			LevelDataMap.GenerateValueArray(Levels);
+
+			// Serializing levels which are in memory is the expensive part, so do that for all of them in parallel,
+			// each into its own buffer. Then we concatenate the buffers & data piped from files in map order.
+			struct FLevelBuffer
 			{
-				auto& LevelData = KV.Value;
+				TArray<uint8> Data;
+				FSpudTocEntry Entry;
+				bool bWritten = false;
+			};
+			TArray<FLevelBuffer> Buffers;
+			Buffers.SetNum(Levels.Num());
+			ParallelFor(Levels.Num(), [&Levels, &Buffers](int32 Index)
+			{
+				auto& LevelData = Levels[Index];
+				// Lock so the status check & write are locked together
+				FScopeLock LevelLock(&LevelData->Mutex);
+				// While awaiting background write, data is still in memory so same as loaded (locked by mutex)
+				if (LevelData->Status == LDS_Unloaded)
+					return;
+				
+				FLevelBuffer& Buffer = Buffers[Index];
+				FMemoryWriter MemWriter(Buffer.Data, true);
+				FSpudChunkedDataArchive MemAr(MemWriter);
+				LevelData->WriteToArchive(MemAr);
+				// Offsets relative to the start of the buffer for now
+				Buffer.Entry = SpudMakeLevelTocEntry(*LevelData, 0);
+				Buffer.bWritten = true;
+			});
+			
+			for (int32 Index = 0; Index < Levels.Num(); ++Index)
+			{
+				FLevelBuffer& Buffer = Buffers[Index];
+				if (Buffer.bWritten)
+				{
+					const int64 BufferOffset = Ar.Tell() - ChunkHeaderStart;
+					Buffer.Entry.Offset += BufferOffset;
+					if (Buffer.Entry.MetadataOffset >= 0)
+						Buffer.Entry.MetadataOffset += BufferOffset;
+					LevelEntries.Add(Buffer.Entry);
+					Ar.Serialize(Buffer.Data.GetData(), Buffer.Data.Num());
+					// Release memory as we go
+					Buffer.Data.Empty();
+					continue;
+				}
+				
+				auto& LevelData = Levels[Index];
 				// Lock outer so the status check write/copy are all locked together
 				// FCriticalSection is recursive (already locked by same thread is fine)
 				FScopeLock LevelLock(&LevelData->Mutex);
@@ -962,38 +1559,50 @@ void FSpudSaveData::WriteToArchive(FSpudChunkedDataArchive& Ar, const FString& L
 				default:
 				case LDS_BackgroundWriteAndUnload: // while awauting background write, data is still in memory so same as loaded (locked by mutex)
 				case LDS_Loaded:
-					// In memory, just write
+					// Only if it was loaded since the parallel write above; in memory, just write
 					LevelData->WriteToArchive(Ar);
+					LevelEntries.Add(SpudMakeLevelTocEntry(*LevelData, ChunkHeaderStart));
 					break;
 				case LDS_Unloaded:
-					// This level data is not in memory. We want to pipe level data directly from the level file into
-					// the combined archive so it doesn't have to go through memory
-					IFileManager& FileMgr = IFileManager::Get();
-					auto InLevelArchive = TUniquePtr<FArchive>(FileMgr.CreateFileReader(*GetLevelDataPath(LevelPath, LevelData->Name)));
-
-					if (!InLevelArchive)
+					// This level data is not in memory. We want to pipe level data directly from the level file (or
+					// the save file it's still in) into the combined archive so it doesn't have to go through memory
+					const bool bFromSource = LevelData->SourceOffset >= 0;
+					FString Filename = bFromSource ? SourceFilePath : GetLevelDataPath(LevelPath, LevelData->Name);
+					if (bFromSource && !IsSourceFileUnchanged())
 					{
-						UE_LOG(LogSpudData, Error, TEXT("Level %s is recorded as being present but unloaded, but level data is not in file cache. "
-						"This level will be missing from the save"), *LevelData->Name);
+						UE_LOG(LogSpudData, Error, TEXT("Level %s is recorded as being unloaded in %s, but that file has changed. "
+						"This level will be missing from the save"), *LevelData->Name, *Filename);
 					}
-					else
+					else if (bFromSource ?
+						!SpudPipeLevelData(Filename, LevelData->SourceOffset, Ar, ChunkHeaderStart, LevelEntries) :
+						!PipeUnloadedLevelData(*LevelData, LevelPath, Ar, ChunkHeaderStart, LevelEntries, Filename))
 					{
-						SpudCopyArchiveData(*InLevelArchive.Get(), Ar, InLevelArchive->TotalSize());
-						InLevelArchive->Close();
+						UE_LOG(LogSpudData, Error, TEXT("Level %s is recorded as being present but unloaded, but level data could not be "
+						"read from %s. This level will be missing from the save"), *LevelData->Name, *Filename);
 					}
 					break;
 				}
 			}
 			// Finish the level container
 			LevelDataMapChunk.ChunkEnd(Ar);
+			Toc.AddEntry(LevelDataMapChunk, ChunkHeaderStart);
+			Toc.Entries.Append(LevelEntries);
 		}
 
+		// Table of contents goes at the end, since we only know where everything is once it's written
+		// The pointer to it is a fixed size and always last, so readers can find it from the end of the save chunk
+		FSpudTableOfContentsPointer TocPointer;
+		TocPointer.TocOffset = Ar.Tell() - ChunkHeaderStart;
+		Toc.WriteToArchive(Ar);
+		TocPointer.WriteToArchive(Ar);
+
 		ChunkEnd(Ar);
 	}
 	
 }
 
-void FSpudSaveData::ReadFromArchive(FSpudChunkedDataArchive& Ar, bool bLoadAllLevels, const FString& LevelPath)
+void FSpudSaveData::ReadFromArchive(FSpudChunkedDataArchive& Ar, bool bLoadAllLevels, const FString& LevelPath,
+                                    const FSpudReadProgressCallback& ProgressCallback, const FString& InSourceFilePath)
 {
 	if (ChunkStart(Ar))
 	{
@@ -1020,13 +1629,35 @@ void FSpudSaveData::ReadFromArchive(FSpudChunkedDataArchive& Ar, bool bLoadAllLe
 			bLoadAllLevels = true;
 			bIsUpgrading = true;
 		}
+
+		SourceFilePath.Empty();
+		if (!bLoadAllLevels && !InSourceFilePath.IsEmpty())
+		{
+			// Levels will be paged in from the original file, remember what it looked like so we know if it changes
+			IFileManager& FileMgr = IFileManager::Get();
+			SourceFilePath = InSourceFilePath;
+			SourceFileSize = FileMgr.FileSize(*SourceFilePath);
+			SourceFileTimestamp = FileMgr.GetTimeStamp(*SourceFilePath);
+		}
+		const int64 TotalBytes = Ar.TotalSize();
+		int32 LevelsProcessed = 0;
+		auto ReportProgress = [&]()
+		{
+			if (ProgressCallback)
+				ProgressCallback(Ar.Tell(), TotalBytes, LevelsProcessed);
+		};
+		ReportProgress();
+
 		const uint32 GlobalDataID = FSpudChunkHeader::EncodeMagic(SPUDDATA_GLOBALDATA_MAGIC);
 		const uint32 LevelDataMapID = FSpudChunkHeader::EncodeMagic(SPUDDATA_LEVELDATAMAP_MAGIC);
 		while (IsStillInChunk(Ar))
 		{
 			Ar.PreviewNextChunk(Hdr, true);
 			if (Hdr.Magic == GlobalDataID)
+			{
 				GlobalData.ReadFromArchive(Ar, Info.SystemVersion);
+				ReportProgress();
+			}
 			else if (Hdr.Magic == LevelDataMapID)
 			{
 				// Read levels using adhoc wrapper so we can choose what to do for each
@@ -1038,11 +1669,13 @@ void FSpudSaveData::ReadFromArchive(FSpudChunkedDataArchive& Ar, bool bLoadAllLe
 						LevelDataMap.Empty();
 					}
 
+					// Level files being written in the background when splitting, created on first use
+					TUniquePtr<FSpudLevelFileWriter> LevelFileWriter;
+					
 					// Detect chunks & only load compatible
-					const uint32 LevelMagicID = FSpudChunkHeader::EncodeMagic(SPUDDATA_LEVELDATA_MAGIC);
 					while (IsStillInChunk(Ar))
 					{
-						if (Ar.NextChunkIs(LevelMagicID))
+						if (Ar.PreviewNextChunk(Hdr, true) && FSpudLevelData::IsLevelDataMagic(Hdr.Magic))
 						{
 							if (bLoadAllLevels)
 							{
@@ -1053,6 +1686,26 @@ void FSpudSaveData::ReadFromArchive(FSpudChunkedDataArchive& Ar, bool bLoadAllLe
 									LevelDataMap.Add(LvlData->Key(), LvlData);
 								}
 							}
+							else if (!SourceFilePath.IsEmpty())
+							{
+								// Leave level data in the source file and just remember where it is
+								FString LevelName;
+								int64 LevelDataSize;
+								const int64 LevelStart = Ar.Tell();
+								if (FSpudLevelData::ReadLevelInfoFromArchive(Ar, true, LevelName, LevelDataSize))
+								{
+									Ar.Seek(LevelStart + FSpudChunkHeader::GetHeaderSize() + LevelDataSize);
+
+									TLevelDataPtr LvlData(new FSpudLevelData());
+									LvlData->Name = LevelName;
+									LvlData->Status = LDS_Unloaded;
+									LvlData->SourceOffset = LevelStart;
+									{
+										FScopeLock MapMutex(&LevelDataMapMutex);					
+										LevelDataMap.Add(LvlData->Key(), LvlData);
+									}
+								}
+							}
 							else
 							{
 								// Pipe data for this level into its own file rather than load it
@@ -1061,12 +1714,25 @@ void FSpudSaveData::ReadFromArchive(FSpudChunkedDataArchive& Ar, bool bLoadAllLe
 								int64 LevelDataSize;
 								if (FSpudLevelData::ReadLevelInfoFromArchive(Ar, true, LevelName, LevelDataSize))
 								{
-									IFileManager& FileMgr = IFileManager::Get();
-									auto OutLevelArchive = TUniquePtr<FArchive>(FileMgr.CreateFileWriter(*GetLevelDataPath(LevelPath, LevelName)));
+									// The size comes from the file, so make sure it's sane before allocating for it
+									const int64 TotalSize = LevelDataSize + FSpudChunkHeader::GetHeaderSize();
+									if (TotalSize > MAX_int32 || TotalSize > TotalBytes - Ar.Tell())
+									{
+										UE_LOG(LogSpudData, Error, TEXT("Level %s in %s has an invalid size of %lld bytes, the save file is corrupt"),
+											*LevelName, *Ar.GetArchiveName(), TotalSize);
+										Ar.SetError();
+										break;
+									}
+
+									// Reading is sequential but writing the files is the slow part, so hand the data
+									// off to be written in parallel, with a limit on how many are waiting
+									TArray<uint8> LevelBytes;
+									LevelBytes.SetNumUninitialized(static_cast<int32>(TotalSize));
+									Ar.Serialize(LevelBytes.GetData(), TotalSize);
 
-									int64 TotalSize = LevelDataSize + FSpudChunkHeader::GetHeaderSize();
-									SpudCopyArchiveData(Ar, *OutLevelArchive.Get(), TotalSize);
-									OutLevelArchive->Close();
+									if (!LevelFileWriter)
+										LevelFileWriter = MakeUnique<FSpudLevelFileWriter>(SPUD_MAX_CONCURRENT_LEVEL_WRITES, SPUD_MAX_CONCURRENT_LEVEL_WRITES);
+									LevelFileWriter->Add(GetLevelDataPath(LevelPath, LevelName), MoveTemp(LevelBytes));
 									
                                     TLevelDataPtr LvlData(new FSpudLevelData());
 									LvlData->Name = LevelName;
@@ -1077,12 +1743,18 @@ void FSpudSaveData::ReadFromArchive(FSpudChunkedDataArchive& Ar, bool bLoadAllLe
 									}
 								}
 							}
+							++LevelsProcessed;
+							ReportProgress();
 						}
 						else
 						{
 							Ar.SkipNextChunk();
 						}
 					}
+
+					// Level files must all be there before anything tries to page them in
+					if (LevelFileWriter)
+						LevelFileWriter->Finish();
 					
 					LevelDataMapChunk.ChunkEnd(Ar);
 				}
@@ -1112,6 +1784,136 @@ void FSpudSaveData::ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSy
 	ReadFromArchive(Ar, true, "");
 }
 
+FSpudSnapshotLevelFiles::~FSpudSnapshotLevelFiles()
+{
+	IFileManager& FileMgr = IFileManager::Get();
+	for (const auto& KV : MovedLevels)
+	{
+		FileMgr.Delete(*KV.Value, false, true, true);
+	}
+}
+
+void FSpudSaveData::CreateSnapshot(FSpudSaveData& OutSnapshot, const FString& LevelPath)
+{
+	OutSnapshot.Reset();
+	OutSnapshot.Info = Info;
+	OutSnapshot.GlobalData = GlobalData;
+	OutSnapshot.GlobalData.Metadata.DeepCopyClassDefinitions();
+	OutSnapshot.SourceFilePath = SourceFilePath;
+	OutSnapshot.SourceFileSize = SourceFileSize;
+	OutSnapshot.SourceFileTimestamp = SourceFileTimestamp;
+
+	// Pin the level cache files the snapshot will pipe from. Registered before levels are added to it, so a level
+	// file can't change between its level being checked below and the snapshot knowing it needs it
+	const TSharedPtr<FSpudSnapshotLevelFiles, ESPMode::ThreadSafe> Pinned = MakeShared<FSpudSnapshotLevelFiles, ESPMode::ThreadSafe>();
+	Pinned->LevelFilesLock = &LevelFilesLock;
+	{
+		FWriteScopeLock FileLock(LevelFilesLock);
+		SnapshotsPinningLevelFiles.Add(Pinned);
+	}
+	OutSnapshot.PinnedLevelFiles = Pinned;
+
+	FScopeLock MapLock(&LevelDataMapMutex);
+	FScopeLock SnapshotMapLock(&OutSnapshot.LevelDataMapMutex);
+	for (auto&& KV : LevelDataMap)
+	{
+		auto& LevelData = KV.Value;
+		FScopeLock LevelLock(&LevelData->Mutex);
+
+		TLevelDataPtr Copy;
+		if (LevelData->Status == LDS_Unloaded)
+		{
+			// Just a placeholder, data will be piped from the level file
+			Copy = TLevelDataPtr(new FSpudLevelData());
+			Copy->Name = LevelData->Name;
+			Copy->Status = LDS_Unloaded;
+			Copy->SourceOffset = LevelData->SourceOffset;
+			if (Copy->SourceOffset < 0)
+			{
+				FScopeLock PinLock(&Pinned->Mutex);
+				Pinned->PendingLevels.Add(LevelData->Name);
+			}
+		}
+		else
+		{
+			// Pending background writes are still in memory, so same as loaded
+			Copy = TLevelDataPtr(new FSpudLevelData(*LevelData));
+			Copy->Metadata.DeepCopyClassDefinitions();
+			Copy->Status = LDS_Loaded;
+		}
+		OutSnapshot.LevelDataMap.Add(KV.Key, Copy);
+	}
+}
+
+void FSpudSaveData::PreserveLevelFileForSnapshots(const FString& LevelName, const FString& LevelPath)
+{
+	IFileManager& FileMgr = IFileManager::Get();
+	const FString Filename = GetLevelDataPath(LevelPath, LevelName);
+	FString MovedTo;
+	for (int32 i = SnapshotsPinningLevelFiles.Num() - 1; i >= 0; --i)
+	{
+		const auto Pinned = SnapshotsPinningLevelFiles[i].Pin();
+		if (!Pinned.IsValid())
+		{
+			// Snapshot has been written & discarded
+			SnapshotsPinningLevelFiles.RemoveAtSwap(i);
+			continue;
+		}
+
+		FScopeLock PinLock(&Pinned->Mutex);
+		if (Pinned->PendingLevels.Remove(LevelName) == 0)
+			continue;
+
+		// Not a .lvl file, so it's never mistaken for level data. The first snapshot gets the file itself, and any
+		// others (only possible if saves overlap) get a copy of it
+		const FString AsideFilename = FString::Printf(TEXT("%s%s.%s.snapshot"), *LevelPath, *LevelName, *FGuid::NewGuid().ToString());
+		const bool bOK = MovedTo.IsEmpty() ?
+			FileMgr.Move(*AsideFilename, *Filename, true, true) :
+			FileMgr.Copy(*AsideFilename, *MovedTo) == COPY_OK;
+		if (bOK)
+		{
+			Pinned->MovedLevels.Add(LevelName, AsideFilename);
+			if (MovedTo.IsEmpty())
+				MovedTo = AsideFilename;
+		}
+		else
+		{
+			UE_LOG(LogSpudData, Error, TEXT("Unable to keep level file %s for the save in progress, level %s will be missing from the save"),
+				*Filename, *LevelName);
+		}
+	}
+}
+
+bool FSpudSaveData::PipeUnloadedLevelData(const FSpudLevelData& LevelData, const FString& LevelPath, FSpudChunkedDataArchive& Ar,
+                                          int64 SaveStart, TArray<FSpudTocEntry>& OutEntries, FString& OutFilename)
+{
+	OutFilename = GetLevelDataPath(LevelPath, LevelData.Name);
+	// Saving the live data, or a snapshot
+	FRWLock& FilesLock = PinnedLevelFiles.IsValid() ? *PinnedLevelFiles->LevelFilesLock : LevelFilesLock;
+	{
+		// Level files can only be changed while no-one is reading one, so only hold this for a single level
+		FReadScopeLock FileLock(FilesLock);
+		bool bInCache = true;
+		if (PinnedLevelFiles.IsValid())
+		{
+			FScopeLock PinLock(&PinnedLevelFiles->Mutex);
+			// Once it's not pending, the live data can change the file without preserving it
+			bInCache = PinnedLevelFiles->PendingLevels.Remove(LevelData.Name) > 0;
+			if (!bInCache)
+			{
+				const FString* Moved = PinnedLevelFiles->MovedLevels.Find(LevelData.Name);
+				if (!Moved)
+					return false;
+				OutFilename = *Moved;
+			}
+		}
+		if (bInCache)
+			return SpudPipeLevelData(OutFilename, 0, Ar, SaveStart, OutEntries);
+	}
+	// Moved aside for this snapshot, so nothing else will touch it
+	return SpudPipeLevelData(OutFilename, 0, Ar, SaveStart, OutEntries);
+}
+
 
 void FSpudSaveData::Reset()
 {
@@ -1121,6 +1923,107 @@ void FSpudSaveData::Reset()
 		FScopeLock MapMutex(&LevelDataMapMutex);
 		LevelDataMap.Empty();
 	}
+	SourceFilePath.Empty();
+	PinnedLevelFiles.Reset();
+}
+
+bool FSpudSaveData::IsSourceFileUnchanged() const
+{
+	if (SourceFilePath.IsEmpty())
+		return false;
+	
+	IFileManager& FileMgr = IFileManager::Get();
+	return FileMgr.FileSize(*SourceFilePath) == SourceFileSize &&
+		FileMgr.GetTimeStamp(*SourceFilePath) == SourceFileTimestamp;
+}
+
+bool FSpudSaveData::ReleaseSourceFile(const FString& LevelPath)
+{
+	if (SourceFilePath.IsEmpty())
+		return true;
+
+	// Levels which couldn't be copied are still paged from the file, so it mustn't be let go of
+	if (!ExtractLevelsFromSourceFile(LevelPath))
+		return false;
+
+	SourceFilePath.Empty();
+	return true;
+}
+
+bool FSpudSaveData::ExtractLevelsFromSourceFile(const FString& LevelPath)
+{
+	if (SourceFilePath.IsEmpty())
+		return true;
+
+	IFileManager& FileMgr = IFileManager::Get();
+	// If something else has replaced the file since it was read, the levels in it are already gone
+	const bool bSourceUnchanged = IsSourceFileUnchanged();
+	TUniquePtr<FArchive> SourceArchive;
+	if (bSourceUnchanged)
+		SourceArchive.Reset(FileMgr.CreateFileReader(*SourceFilePath));
+
+	// Only hold the map lock while gathering, so other threads can still look up levels while these are copied
+	TArray<TLevelDataPtr> Levels;
+	{
+		FScopeLock MapLock(&LevelDataMapMutex);
+		LevelDataMap.GenerateValueArray(Levels);
+	}
+	bool bAllExtracted = true;
+	for (auto& LevelData : Levels)
+	{
+		FScopeLock LevelLock(&LevelData->Mutex);
+		if (LevelData->Status != LDS_Unloaded || LevelData->SourceOffset < 0)
+			continue;
+
+		if (!bSourceUnchanged)
+		{
+			UE_LOG(LogSpudData, Error, TEXT("Unable to copy level %s from %s to the level cache, the file has changed since it was loaded. Its state will be lost"),
+				*LevelData->Name, *SourceFilePath);
+			LevelData->SourceOffset = -1;
+			continue;
+		}
+
+		// Copy this level out into the level cache like we would have done at load
+		const FString Filename = GetLevelDataPath(LevelPath, LevelData->Name);
+		FWriteScopeLock FileLock(LevelFilesLock);
+		PreserveLevelFileForSnapshots(LevelData->Name, LevelPath);
+		bool bCopied = false;
+		auto OutLevelArchive = TUniquePtr<FArchive>(SourceArchive ? FileMgr.CreateFileWriter(*Filename) : nullptr);
+		if (OutLevelArchive)
+		{
+			FSpudChunkHeader Hdr;
+			SourceArchive->Seek(LevelData->SourceOffset);
+			*SourceArchive << Hdr;
+			if (!SourceArchive->IsError())
+			{
+				const int64 Length = Hdr.Length + FSpudChunkHeader::GetHeaderSize();
+				bCopied = SpudCopyFileData(SourceFilePath, LevelData->SourceOffset, *OutLevelArchive, Length) == Length;
+			}
+			// Always explicitly close to catch errors from flush/close
+			OutLevelArchive->Close();
+			bCopied = bCopied && !OutLevelArchive->IsError();
+			if (!bCopied)
+			{
+				OutLevelArchive.Reset();
+				FileMgr.Delete(*Filename, false, true, true);
+			}
+		}
+
+		if (!bCopied)
+		{
+			// Still paged from the source file, which is why that mustn't be replaced now
+			UE_LOG(LogSpudData, Error, TEXT("Unable to copy level %s from %s to the level cache"), *LevelData->Name, *SourceFilePath);
+			bAllExtracted = false;
+			continue;
+		}
+		// Levels are only paged from the source while this is set, under the level lock
+		LevelData->SourceOffset = -1;
+	}
+
+	if (SourceArchive)
+		SourceArchive->Close();
+
+	return bAllExtracted;
 }
 
 FSpudSaveData::TLevelDataPtr FSpudSaveData::CreateLevelData(const FString& LevelName)
@@ -1131,7 +2034,7 @@ FSpudSaveData::TLevelDataPtr FSpudSaveData::CreateLevelData(const FString& Level
 
 	{
 		FScopeLock MapMutex(&LevelDataMapMutex);
-		LevelDataMap.Add(LevelName, NewLevelData);
+		LevelDataMap.Add(NewLevelData->Key(), NewLevelData);
 	}
 	
 	return NewLevelData;
@@ -1175,6 +2078,10 @@ void FSpudSaveData::WriteLevelData(FSpudLevelData& LevelData, const FString& Lev
 		{
 			UE_LOG(LogSpudData, Error, TEXT("Error while writing level data to %s"), *Filename);
 		}
+		else
+		{
+			LevelData.bModified = false;
+		}
 	}
 	else
 	{
@@ -1183,7 +2090,7 @@ void FSpudSaveData::WriteLevelData(FSpudLevelData& LevelData, const FString& Lev
 	
 }
 
-bool FSpudSaveData::ReadSaveInfoFromArchive(FSpudChunkedDataArchive& Ar, FSpudSaveInfo& OutInfo)
+bool FSpudSaveData::ReadSaveInfoFromArchive(FSpudChunkedDataArchive& Ar, FSpudSaveInfo& OutInfo, bool bIncludeScreenshot)
 {
 	// Read manually, no stateful ChunkStart/End
 	FSpudChunkHeader Hdr;
@@ -1200,13 +2107,155 @@ bool FSpudSaveData::ReadSaveInfoFromArchive(FSpudChunkedDataArchive& Ar, FSpudSa
 		UE_LOG(LogSpudData, Error, TEXT("Cannot get info for save game, INFO chunk isn't present at start"))
 		return false;		
 	}
+	OutInfo.Screenshot.bSkipImageData = !bIncludeScreenshot;
 	OutInfo.ReadFromArchive(Ar, 0);
+	OutInfo.Screenshot.bSkipImageData = false;
 
 	return true;
 	
 }
 
 
+/// Find the position of the class metadata chunk within a chunk, starting from the current position, or -1 if not found
+static int64 SpudFindMetadataChunk(FSpudChunkedDataArchive& Ar, int64 ChunkDataEnd)
+{
+	const uint32 MetadataID = FSpudChunkHeader::EncodeMagic(SPUDDATA_METADATA_MAGIC);
+	FSpudChunkHeader Hdr;
+	while (Ar.Tell() < ChunkDataEnd && Ar.PreviewNextChunk(Hdr, true))
+	{
+		if (Hdr.Magic == MetadataID)
+			return Ar.Tell();
+		Ar.SkipNextChunk();
+	}
+	return -1;
+}
+
+bool FSpudSaveData::ReadTableOfContents(FSpudChunkedDataArchive& Ar, FSpudTableOfContents& OutToc)
+{
+	OutToc.Reset();
+	
+	const int64 SaveStart = Ar.Tell();
+	FSpudChunkHeader SaveHdr;
+	if (!Ar.PreviewNextChunk(SaveHdr, false) || !SaveHdr.IsMagicEqual(SPUDDATA_SAVEGAME_MAGIC))
+	{
+		UE_LOG(LogSpudData, Error, TEXT("Cannot read table of contents from %s, not a save game"), *Ar.GetArchiveName())
+		Ar.Seek(SaveStart);
+		return false;
+	}
+	const int64 SaveDataStart = Ar.Tell();
+	const int64 SaveDataEnd = SaveDataStart + SaveHdr.Length;
+	OutToc.SaveStart = SaveStart;
+
+	// System version is the first thing in the info chunk, which is always first
+	if (!Ar.NextChunkIs(SPUDDATA_SAVEINFO_MAGIC))
+	{
+		UE_LOG(LogSpudData, Error, TEXT("Cannot read table of contents from %s, INFO chunk isn't present at start"), *Ar.GetArchiveName())
+		Ar.Seek(SaveStart);
+		return false;
+	}
+	Ar.Seek(SaveDataStart + FSpudChunkHeader::GetHeaderSize());
+	Ar << OutToc.SystemVersion;
+
+	// Look for the pointer to the TOC at the end of the save
+	if (SaveHdr.Length >= FSpudTableOfContentsPointer::GetTotalSize())
+	{
+		Ar.Seek(SaveDataEnd - FSpudTableOfContentsPointer::GetTotalSize());
+		FSpudTableOfContentsPointer TocPointer;
+		if (Ar.NextChunkIs(TocPointer.GetMagic()))
+		{
+			TocPointer.ReadFromArchive(Ar, OutToc.SystemVersion);
+			const int64 TocStart = SaveStart + TocPointer.TocOffset;
+			if (TocStart > SaveDataStart && TocStart < SaveDataEnd)
+			{
+				Ar.Seek(TocStart);
+				if (Ar.NextChunkIs(OutToc.GetMagic()))
+				{
+					OutToc.ReadFromArchive(Ar, OutToc.SystemVersion);
+					Ar.Seek(SaveStart);
+					return !Ar.IsError();
+				}
+			}
+			UE_LOG(LogSpudData, Warning, TEXT("Table of contents pointer in %s is invalid, falling back on scanning"), *Ar.GetArchiveName())
+		}
+	}
+
+	// No TOC (older save), so build the same thing by scanning through the chunks
+	const uint32 GlobalDataID = FSpudChunkHeader::EncodeMagic(SPUDDATA_GLOBALDATA_MAGIC);
+	const uint32 LevelDataMapID = FSpudChunkHeader::EncodeMagic(SPUDDATA_LEVELDATAMAP_MAGIC);
+	const uint32 LevelDataID = FSpudChunkHeader::EncodeMagic(SPUDDATA_LEVELDATA_MAGIC);
+	FSpudChunkHeader Hdr;
+	FSpudChunkHeader LevelHdr;
+	Ar.Seek(SaveDataStart);
+	while (Ar.Tell() < SaveDataEnd)
+	{
+		const int64 HeaderPos = Ar.Tell();
+		if (!Ar.PreviewNextChunk(Hdr, false))
+			break;
+		const int64 DataEndPos = Ar.Tell() + Hdr.Length;
+
+		FSpudTocEntry& Entry = OutToc.Entries.AddDefaulted_GetRef();
+		Entry.Magic = Hdr.Magic;
+		Entry.Offset = HeaderPos - SaveStart;
+		Entry.Length = Hdr.Length;
+
+		if (Hdr.Magic == GlobalDataID)
+		{
+			FString CurrentLevel;
+			Ar << CurrentLevel;
+			const int64 MetaPos = SpudFindMetadataChunk(Ar, DataEndPos);
+			if (MetaPos >= 0)
+				Entry.MetadataOffset = MetaPos - SaveStart;
+		}
+		else if (Hdr.Magic == LevelDataMapID)
+		{
+			while (Ar.Tell() < DataEndPos)
+			{
+				const int64 LevelStart = Ar.Tell();
+				if (Ar.PreviewNextChunk(LevelHdr, true) && FSpudLevelData::IsLevelDataMagic(LevelHdr.Magic))
+				{
+					FSpudTocEntry LevelEntry;
+					int64 LevelDataSize;
+					FSpudLevelData::ReadLevelInfoFromArchive(Ar, false, LevelEntry.Name, LevelDataSize);
+					const int64 LevelEnd = LevelStart + FSpudChunkHeader::GetHeaderSize() + LevelDataSize;
+					LevelEntry.Magic = LevelHdr.Magic;
+					LevelEntry.Offset = LevelStart - SaveStart;
+					LevelEntry.Length = static_cast<uint32>(LevelDataSize);
+					// Can't look inside compressed levels without decompressing them
+					if (LevelHdr.Magic == LevelDataID)
+					{
+						const int64 MetaPos = SpudFindMetadataChunk(Ar, LevelEnd);
+						if (MetaPos >= 0)
+							LevelEntry.MetadataOffset = MetaPos - SaveStart;
+					}
+					OutToc.Entries.Add(LevelEntry);
+					Ar.Seek(LevelEnd);
+				}
+				else
+				{
+					Ar.SkipNextChunk();
+				}
+			}
+		}
+		Ar.Seek(DataEndPos);
+	}
+
+	Ar.Seek(SaveStart);
+	return !Ar.IsError();
+}
+
+bool FSpudSaveData::ReadLevelFromArchive(FSpudChunkedDataArchive& Ar, const FSpudTableOfContents& Toc,
+                                         const FString& LevelName, FSpudLevelData& OutLevelData)
+{
+	const FSpudTocEntry* Entry = Toc.FindLevel(LevelName);
+	if (!Entry)
+		return false;
+
+	Ar.Seek(Toc.SaveStart + Entry->Offset);
+	OutLevelData.ReadFromArchive(Ar, Toc.SystemVersion);
+
+	return !Ar.IsError() && OutLevelData.Name == LevelName;
+}
+
 FSpudSaveData::TLevelDataPtr FSpudSaveData::GetLevelData(const FString& LevelName, bool bLoadIfNeeded, const FString& LevelPath)
 {
 	TLevelDataPtr Ret;
@@ -1214,7 +2263,7 @@ FSpudSaveData::TLevelDataPtr FSpudSaveData::GetLevelData(const FString& LevelNam
 		// Only lock the map while looking up
 		// We get a shared pointer back (threadsafe) and lock its own mutex before changing the instance state
 		FScopeLock MapMutex(&LevelDataMapMutex);
-		const auto Found = LevelDataMap.Find(LevelName);
+		const auto Found = LevelDataMap.Find(FName(*LevelName));
 		if (Found)
 			Ret = *Found;
 	}
@@ -1225,14 +2274,18 @@ FSpudSaveData::TLevelDataPtr FSpudSaveData::GetLevelData(const FString& LevelNam
 		{
 		case LDS_Unloaded:
 			{
-				// Load individual level file back into memory
+				// Load individual level file back into memory, or page it from the save file if it's still there
 				IFileManager& FileMgr = IFileManager::Get();
-				const auto Filename = GetLevelDataPath(LevelPath, LevelName);
-				const auto Archive = TUniquePtr<FArchive>(FileMgr.CreateFileReader(*Filename));
+				const bool bFromSource = Ret->SourceOffset >= 0;
+				const auto Filename = bFromSource ? SourceFilePath : GetLevelDataPath(LevelPath, LevelName);
+				const bool bCanRead = !bFromSource || IsSourceFileUnchanged();
+				const auto Archive = TUniquePtr<FArchive>(bCanRead ? FileMgr.CreateFileReader(*Filename) : nullptr);
 
 				if (Archive)
 				{
 					FSpudChunkedDataArchive ChunkedAr(*Archive);
+					if (bFromSource)
+						ChunkedAr.Seek(Ret->SourceOffset);
 
 					// We have to assume that leveldata has been upgraded at load time if system version was incorrect
 					Ret->ReadFromArchive(ChunkedAr, SPUD_CURRENT_SYSTEM_VERSION);
@@ -1242,6 +2295,15 @@ FSpudSaveData::TLevelDataPtr FSpudSaveData::GetLevelData(const FString& LevelNam
 					{
 						UE_LOG(LogSpudData, Error, TEXT("Error while loading active game level file from %s"), *Filename);
 					}
+					else
+					{
+						// Level cache already has these contents, unless they came from the save file
+						Ret->bModified = bFromSource;
+						// Memory is now the only up to date copy, and it'll go to the level cache when released.
+						// Left alone on failure so the level can still be paged from the save file
+						if (bFromSource)
+							Ret->SourceOffset = -1;
+					}
 				}
 				else
 				{
@@ -1270,7 +2332,7 @@ void FSpudSaveData::WriteAndReleaseAllLevelData(const FString& LevelPath)
 	FScopeLock MapLock(&LevelDataMapMutex);
 	for (auto && Pair : LevelDataMap)
 	{
-		WriteAndReleaseLevelData(Pair.Key, LevelPath, true);
+		WriteAndReleaseLevelData(Pair.Value->Name, LevelPath, true);
 	}
 }
 
@@ -1285,8 +2347,16 @@ bool FSpudSaveData::WriteAndReleaseLevelData(const FString& LevelName, const FSt
 			// should upgrade it and do it NOW. When the status is changed to LDS_Unloaded the background worker will ignore it
 			(LevelData->Status == LDS_BackgroundWriteAndUnload && bBlocking))
 		{
-			if (bBlocking)
+			if (!LevelData->bModified)
 			{
+				// Level cache already has the same contents, nothing to write
+				UE_LOG(LogSpudData, Verbose, TEXT("Level data for %s is unchanged, releasing without writing"), *LevelName);
+				LevelData->ReleaseMemory();
+			}
+			else if (bBlocking)
+			{
+				FWriteScopeLock FileLock(LevelFilesLock);
+				PreserveLevelFileForSnapshots(LevelName, LevelPath);
 				WriteLevelData(*LevelData, LevelName, LevelPath);
 				LevelData->ReleaseMemory();
 			}
@@ -1318,6 +2388,8 @@ bool FSpudSaveData::WriteAndReleaseLevelData(const FString& LevelName, const FSt
                         FScopeLock LevelLock(&LevelData->Mutex);
                         if (LevelData->Status == LDS_BackgroundWriteAndUnload)
                         {
+                            FWriteScopeLock FileLock(LevelFilesLock);
+                            PreserveLevelFileForSnapshots(LevelName, LevelPath);
                             WriteLevelData(*LevelData, LevelName, LevelPath);
                             LevelData->ReleaseMemory();
                         }
@@ -1333,9 +2405,11 @@ void FSpudSaveData::DeleteLevelData(const FString& LevelName, const FString& Lev
 {
 	{
 		FScopeLock MapMutex(&LevelDataMapMutex);
-		LevelDataMap.Remove(LevelName);
+		LevelDataMap.Remove(FName(*LevelName));
 	}
 
+	FWriteScopeLock FileLock(LevelFilesLock);
+	PreserveLevelFileForSnapshots(LevelName, LevelPath);
 	IFileManager& FileMgr = IFileManager::Get();
 	const FString Filename = GetLevelDataPath(LevelPath, LevelName);
 	FileMgr.Delete(*Filename, false, true, true);
@@ -1345,16 +2419,17 @@ void FSpudSaveData::DeleteLevelData(const FString& LevelName, const FString& Lev
 //------------------------------------------------------------------------------
 int64 SpudCopyArchiveData(FArchive& InArchive, FArchive& OutArchive, int64 Length)
 {
-	// file read / write archives have their own buffers too but I can't assume
-	constexpr int BufferLen = 4096;
-	uint8 TempBuffer[BufferLen];
+	// Use big blocks; file archives bypass their own (smaller) buffers for reads / writes this size, so this avoids
+	// both extra copying and lots of small virtual calls
+	const int64 BufferLen = std::min(Length, static_cast<int64>(SPUD_COPY_BLOCK_SIZE));
+	uint8* TempBuffer = static_cast<uint8*>(FMemory::Malloc(std::max(BufferLen, static_cast<int64>(1)), SPUD_COPY_BLOCK_ALIGNMENT));
 
 	int64 BytesCopied = 0;
 	if (InArchive.IsLoading() && OutArchive.IsSaving())
 	{
 		while (BytesCopied < Length)
 		{
-			int64 BytesToRequest = std::min(Length - BytesCopied, static_cast<int64>(BufferLen));
+			int64 BytesToRequest = std::min(Length - BytesCopied, BufferLen);
 			InArchive.Serialize(TempBuffer, BytesToRequest);
 			if (InArchive.IsError())
 			{
@@ -1377,5 +2452,104 @@ int64 SpudCopyArchiveData(FArchive& InArchive, FArchive& OutArchive, int64 Lengt
 	{
 		UE_LOG(LogSpudData, Error, TEXT("Cannot copy archive data from %s to %s, mismatched loading/saving status"), *InArchive.GetArchiveName(), *OutArchive.GetArchiveName());
 	}
+	FMemory::Free(TempBuffer);
+	return BytesCopied;
+}
+
+/// Open a file for async reads, and get its size (-1 if it can't be read) from the same handle
+static TUniquePtr<IAsyncReadFileHandle> SpudOpenAsyncRead(const FString& Filename, int64& OutFileSize)
+{
+	OutFileSize = -1;
+	TUniquePtr<IAsyncReadFileHandle> Handle(FPlatformFileManager::Get().GetPlatformFile().OpenAsyncRead(*Filename));
+	if (Handle)
+	{
+		TUniquePtr<IAsyncReadRequest> SizeRequest(Handle->SizeRequest());
+		if (SizeRequest)
+		{
+			SizeRequest->WaitCompletion();
+			OutFileSize = SizeRequest->GetSizeResults();
+		}
+	}
+	return Handle;
+}
+
+int64 SpudCopyFileData(const FString& Filename, int64 Offset, FArchive& OutArchive, int64 Length)
+{
+	int64 FileSize;
+	auto Handle = SpudOpenAsyncRead(Filename, FileSize);
+	if (!Handle)
+	{
+		UE_LOG(LogSpudData, Error, TEXT("Unable to open %s to copy data from"), *Filename);
+		return 0;
+	}
+	return SpudCopyFileData(*Handle, FileSize, Filename, Offset, OutArchive, Length);
+}
+
+static int64 SpudCopyFileData(IAsyncReadFileHandle& Handle, int64 FileSize, const FString& Filename, int64 Offset, FArchive& OutArchive, int64 Length)
+{
+	if (!OutArchive.IsSaving())
+	{
+		UE_LOG(LogSpudData, Error, TEXT("Cannot copy file data from %s to %s, destination is not saving"), *Filename, *OutArchive.GetArchiveName());
+		return 0;
+	}
+	// Async read results don't include a byte count, so make sure up front that every block can be read in full
+	if (Offset < 0 || Length < 0 || Offset + Length > FileSize)
+	{
+		UE_LOG(LogSpudData, Error, TEXT("Cannot copy %lld bytes at offset %lld from %s, file size is %lld"), Length, Offset, *Filename, FileSize);
+		return 0;
+	}
+
+	// Double buffered; the read of the next block is in flight while the current one is written
+	const int64 BlockSize = std::min(Length, static_cast<int64>(SPUD_COPY_BLOCK_SIZE));
+	uint8* Buffers[2];
+	for (auto& Buffer : Buffers)
+		Buffer = static_cast<uint8*>(FMemory::Malloc(std::max(BlockSize, static_cast<int64>(1)), SPUD_COPY_BLOCK_ALIGNMENT));
+
+	auto StartRead = [&](int64 CopyOffset, int32 BufferIndex)
+	{
+		IAsyncReadRequest* Request = Handle.ReadRequest(Offset + CopyOffset, std::min(Length - CopyOffset, BlockSize), AIOP_Normal, nullptr, Buffers[BufferIndex]);
+		if (!Request)
+			UE_LOG(LogSpudData, Error, TEXT("Unable to start read while copying file data from %s"), *Filename);
+		return Request;
+	};
+
+	int64 BytesCopied = 0;
+	int32 CurrentBuffer = 0;
+	IAsyncReadRequest* Request = Length > 0 ? StartRead(0, CurrentBuffer) : nullptr;
+	while (Request)
+	{
+		Request->WaitCompletion();
+		const bool bReadOK = Request->GetReadResults() != nullptr;
+		delete Request;
+		Request = nullptr;
+		if (!bReadOK)
+		{
+			UE_LOG(LogSpudData, Error, TEXT("Error during read while copying file data from %s to %s"), *Filename, *OutArchive.GetArchiveName());
+			break;
+		}
+
+		const int64 BytesRead = std::min(Length - BytesCopied, BlockSize);
+		if (BytesCopied + BytesRead < Length)
+			Request = StartRead(BytesCopied + BytesRead, 1 - CurrentBuffer);
+
+		OutArchive.Serialize(Buffers[CurrentBuffer], BytesRead);
+		if (OutArchive.IsError())
+		{
+			UE_LOG(LogSpudData, Error, TEXT("Error during write while copying file data from %s to %s"), *Filename, *OutArchive.GetArchiveName());
+			break;
+		}
+		BytesCopied += BytesRead;
+		CurrentBuffer = 1 - CurrentBuffer;
+	}
+
+	// Must not free the buffers or handle with a read outstanding
+	if (Request)
+	{
+		Request->WaitCompletion();
+		delete Request;
+	}
+	for (auto& Buffer : Buffers)
+		FMemory::Free(Buffer);
+	
 	return BytesCopied;
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "SpudModule.h"
 
+#include "SpudPropertyUtil.h"
+#include "UObject/UObjectGlobals.h"
+
 #define LOCTEXT_NAMESPACE "FSpud"
 
 DEFINE_LOG_CATEGORY(LogSpudModule)
@@ -8,12 +11,31 @@ void FSpudModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
 	UE_LOG(LogSpudModule, Log, TEXT("SPUD Module Started"))
+
+	// Cached property plans hold FProperty pointers & layouts, which are invalid once classes are reloaded or
+	// Blueprints are recompiled (which reinstances objects)
+	ReloadCompleteHandle = FCoreUObjectDelegates::ReloadCompleteDelegate.AddLambda([](EReloadCompleteReason)
+	{
+		SpudPropertyUtil::FlushPropertyPlans();
+	});
+#if WITH_EDITOR
+	ObjectsReplacedHandle = FCoreUObjectDelegates::OnObjectsReplaced.AddLambda([](const TMap<UObject*, UObject*>&)
+	{
+		SpudPropertyUtil::FlushPropertyPlans();
+	});
+#endif
 }
 
 void FSpudModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FCoreUObjectDelegates::ReloadCompleteDelegate.Remove(ReloadCompleteHandle);
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectsReplaced.Remove(ObjectsReplacedHandle);
+#endif
+	SpudPropertyUtil::FlushPropertyPlans();
+
 	UE_LOG(LogSpudModule, Log, TEXT("SPUD Module Stopped"))
 }
 
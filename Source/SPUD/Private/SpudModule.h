@@ -12,4 +12,10 @@ public:
 	/** IModuleInterface implementation */
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
+
+protected:
+	FDelegateHandle ReloadCompleteHandle;
+#if WITH_EDITOR
+	FDelegateHandle ObjectsReplacedHandle;
+#endif
 };
@@ -12,6 +12,11 @@
 
 DEFINE_LOG_CATEGORY(LogSpudProps)
 
+// Property plans are shared by every object of a class and used from save / load worker threads too
+// TObjectKey means a class which was garbage collected and had its memory reused can't match a stale plan
+static TMap<TObjectKey<UStruct>, FSpudPropertyPlanPtr> GSpudPropertyPlans;
+static FRWLock GSpudPropertyPlansLock;
+
 bool SpudPropertyUtil::ShouldPropertyBeIncluded(FProperty* Property, bool IsChildOfSaveGame)
 {
 	if (Property->HasAnyPropertyFlags(CPF_Deprecated))
@@ -37,11 +42,11 @@ bool SpudPropertyUtil::IsPropertyNativelySupported(FProperty* Property)
 	}
 	else if (const auto MProp = CastField<FMapProperty>(Property))
 	{
-		return false;
+		return IsNativelySupportedMapType(MProp);
 	}
 	else if (const auto SProp = CastField<FSetProperty>(Property))
 	{
-		return false;
+		return IsNativelySupportedSetType(SProp);
 	}
 
 	return true;
@@ -73,6 +78,19 @@ bool SpudPropertyUtil::IsNativelySupportedArrayType(const FArrayProperty* AProp)
 
 }
 
+bool SpudPropertyUtil::IsNativelySupportedSetType(const FSetProperty* SProp)
+{
+	// Elements have to be primitives or builtin structs, everything else falls back to an opaque record
+	return GetPropertyCodec(SProp->ElementProp) != ESpudPropertyCodec::None;
+}
+
+bool SpudPropertyUtil::IsNativelySupportedMapType(const FMapProperty* MProp)
+{
+	// Keys & values have to be primitives or builtin structs, everything else falls back to an opaque record
+	return GetPropertyCodec(MProp->KeyProp) != ESpudPropertyCodec::None &&
+		GetPropertyCodec(MProp->ValueProp) != ESpudPropertyCodec::None;
+}
+
 bool SpudPropertyUtil::IsBuiltInStructProperty(const FStructProperty* SProp)
 {
 	return SProp->Struct == TBaseStructure<FVector>::Get() ||
@@ -146,6 +164,19 @@ uint16 SpudPropertyUtil::GetPropertyDataType(const FProperty* Prop)
 	// Use this for arrays of custom structs, maps etc
 	uint16 Ret = ESST_OpaqueRecord;
 
+	if (const auto SetProp = CastField<FSetProperty>(Prop))
+	{
+		if (IsNativelySupportedSetType(SetProp))
+			return ESST_SetOf | ESST_VarCount | GetPropertyDataType(SetProp->ElementProp);
+		return Ret;
+	}
+	if (const auto MProp = CastField<FMapProperty>(Prop))
+	{
+		if (IsNativelySupportedMapType(MProp))
+			return SpudMakeMapDataType(GetPropertyDataType(MProp->KeyProp), GetPropertyDataType(MProp->ValueProp));
+		return Ret;
+	}
+
 	if (const auto AProp = CastField<FArrayProperty>(Prop))
 	{
 		// Only natively supported array types will be stored natively
@@ -229,12 +260,194 @@ uint16 SpudPropertyUtil::GetPropertyDataType(const FProperty* Prop)
 
 	if (bIsArray)
 	{
-		Ret |= ESST_ArrayOf;
+		Ret |= ESST_ArrayOf | ESST_VarCount;
 	}
 	return Ret;
 	
 }
 
+ESpudPropertyCodec SpudPropertyUtil::GetPropertyCodec(const FProperty* Prop)
+{
+	// Must agree with GetPropertyDataType, and with what IsPropertyNativelySupported lets through to the TryWrite chain
+	if (const auto SProp = CastField<FStructProperty>(Prop))
+	{
+		if (SProp->Struct == TBaseStructure<FVector>::Get())
+			return ESpudPropertyCodec::Vector;
+		if (SProp->Struct == TBaseStructure<FRotator>::Get())
+			return ESpudPropertyCodec::Rotator;
+		if (SProp->Struct == TBaseStructure<FTransform>::Get())
+			return ESpudPropertyCodec::Transform;
+		if (SProp->Struct == TBaseStructure<FGuid>::Get())
+			return ESpudPropertyCodec::Guid;
+		return ESpudPropertyCodec::None;
+	}
+
+	if (CastField<FBoolProperty>(Prop))
+		return ESpudPropertyCodec::Bool;
+	if (CastField<FByteProperty>(Prop))
+		return ESpudPropertyCodec::Byte;
+	if (CastField<FUInt16Property>(Prop))
+		return ESpudPropertyCodec::UInt16;
+	if (CastField<FUInt32Property>(Prop))
+		return ESpudPropertyCodec::UInt32;
+	if (CastField<FUInt64Property>(Prop))
+		return ESpudPropertyCodec::UInt64;
+	if (CastField<FInt8Property>(Prop))
+		return ESpudPropertyCodec::Int8;
+	if (CastField<FInt16Property>(Prop))
+		return ESpudPropertyCodec::Int16;
+	if (CastField<FIntProperty>(Prop))
+		return ESpudPropertyCodec::Int32;
+	if (CastField<FInt64Property>(Prop))
+		return ESpudPropertyCodec::Int64;
+	if (CastField<FFloatProperty>(Prop))
+		return ESpudPropertyCodec::Float;
+	if (CastField<FDoubleProperty>(Prop))
+		return ESpudPropertyCodec::Double;
+	if (CastField<FStrProperty>(Prop))
+		return ESpudPropertyCodec::String;
+	if (CastField<FNameProperty>(Prop))
+		return ESpudPropertyCodec::Name;
+	if (CastField<FTextProperty>(Prop))
+		return ESpudPropertyCodec::Text;
+	if (CastField<FEnumProperty>(Prop))
+		return ESpudPropertyCodec::Enum;
+
+	return ESpudPropertyCodec::None;
+}
+
+const SpudPropertyUtil::FCodecFuncs& SpudPropertyUtil::GetCodecFuncs(ESpudPropertyCodec Codec)
+{
+	// Order must match ESpudPropertyCodec
+	static const FCodecFuncs Table[] =
+	{
+		{ ESST_Unknown, nullptr, nullptr },
+		{ SpudTypeInfo<bool>::EnumType,		&WritePropertyCodec<FBoolProperty, bool>,		&ReadPropertyCodec<FBoolProperty, bool> },
+		{ SpudTypeInfo<uint8>::EnumType,	&WritePropertyCodec<FByteProperty, uint8>,		&ReadPropertyCodec<FByteProperty, uint8> },
+		{ SpudTypeInfo<uint16>::EnumType,	&WritePropertyCodec<FUInt16Property, uint16>,	&ReadPropertyCodec<FUInt16Property, uint16> },
+		{ SpudTypeInfo<uint32>::EnumType,	&WritePropertyCodec<FUInt32Property, uint32>,	&ReadPropertyCodec<FUInt32Property, uint32> },
+		{ SpudTypeInfo<uint64>::EnumType,	&WritePropertyCodec<FUInt64Property, uint64>,	&ReadPropertyCodec<FUInt64Property, uint64> },
+		{ SpudTypeInfo<int8>::EnumType,		&WritePropertyCodec<FInt8Property, int8>,		&ReadPropertyCodec<FInt8Property, int8> },
+		{ SpudTypeInfo<int16>::EnumType,	&WritePropertyCodec<FInt16Property, int16>,		&ReadPropertyCodec<FInt16Property, int16> },
+		{ SpudTypeInfo<int>::EnumType,		&WritePropertyCodec<FIntProperty, int>,			&ReadPropertyCodec<FIntProperty, int> },
+		{ SpudTypeInfo<int64>::EnumType,	&WritePropertyCodec<FInt64Property, int64>,		&ReadPropertyCodec<FInt64Property, int64> },
+		{ SpudTypeInfo<float>::EnumType,	&WritePropertyCodec<FFloatProperty, float>,		&ReadPropertyCodec<FFloatProperty, float> },
+		{ SpudTypeInfo<double>::EnumType,	&WritePropertyCodec<FDoubleProperty, double>,	&ReadPropertyCodec<FDoubleProperty, double> },
+		{ SpudTypeInfo<FString>::EnumType,	&WritePropertyCodec<FStrProperty, FString>,		&ReadPropertyCodec<FStrProperty, FString> },
+		{ SpudTypeInfo<FName>::EnumType,	&WritePropertyCodec<FNameProperty, FName>,		&ReadPropertyCodec<FNameProperty, FName> },
+		{ SpudTypeInfo<FText>::EnumType,	&WritePropertyCodec<FTextProperty, FText>,		&ReadPropertyCodec<FTextProperty, FText> },
+		{ SpudTypeInfo<SpudAnyEnum>::EnumType,	&WriteEnumCodec,							&ReadEnumCodec },
+		{ SpudTypeInfo<FVector>::EnumType,	&WriteBuiltinStructCodec<FVector>,				&ReadBuiltinStructCodec<FVector> },
+		{ SpudTypeInfo<FRotator>::EnumType,	&WriteBuiltinStructCodec<FRotator>,				&ReadBuiltinStructCodec<FRotator> },
+		{ SpudTypeInfo<FTransform>::EnumType,	&WriteBuiltinStructCodec<FTransform>,		&ReadBuiltinStructCodec<FTransform> },
+		{ SpudTypeInfo<FGuid>::EnumType,	&WriteBuiltinStructCodec<FGuid>,				&ReadBuiltinStructCodec<FGuid> },
+	};
+	static_assert(UE_ARRAY_COUNT(Table) == static_cast<int>(ESpudPropertyCodec::Count), "Codec table out of sync with ESpudPropertyCodec");
+
+	return Table[static_cast<int>(Codec)];
+}
+
+const SpudPropertyUtil::FCodecFuncs* SpudPropertyUtil::GetCompactCodecFuncs(ESpudPropertyCodec Codec)
+{
+	// Order must match ESpudPropertyCodec. Empty entries are written the same as the standard table
+	// Bool arrays are bit-packed by StoreArrayProperty / RestoreArrayProperty instead
+	static const FCodecFuncs Table[] =
+	{
+		{ ESST_Unknown, nullptr, nullptr },
+		{ ESST_Unknown, nullptr, nullptr }, // Bool
+		{ ESST_Unknown, nullptr, nullptr }, // Byte
+		{ SpudTypeInfo<uint16>::EnumType,	&WriteVarIntCodec<FUInt16Property, uint16>,		&ReadVarIntCodec<FUInt16Property, uint16> },
+		{ SpudTypeInfo<uint32>::EnumType,	&WriteVarIntCodec<FUInt32Property, uint32>,		&ReadVarIntCodec<FUInt32Property, uint32> },
+		{ SpudTypeInfo<uint64>::EnumType,	&WriteVarIntCodec<FUInt64Property, uint64>,		&ReadVarIntCodec<FUInt64Property, uint64> },
+		{ ESST_Unknown, nullptr, nullptr }, // Int8
+		{ SpudTypeInfo<int16>::EnumType,	&WriteVarIntCodec<FInt16Property, int16>,		&ReadVarIntCodec<FInt16Property, int16> },
+		{ SpudTypeInfo<int>::EnumType,		&WriteVarIntCodec<FIntProperty, int>,			&ReadVarIntCodec<FIntProperty, int> },
+		{ SpudTypeInfo<int64>::EnumType,	&WriteVarIntCodec<FInt64Property, int64>,		&ReadVarIntCodec<FInt64Property, int64> },
+		{ ESST_Unknown, nullptr, nullptr }, // Float
+		{ ESST_Unknown, nullptr, nullptr }, // Double
+		{ ESST_Unknown, nullptr, nullptr }, // String
+		{ ESST_Unknown, nullptr, nullptr }, // Name
+		{ ESST_Unknown, nullptr, nullptr }, // Text
+		{ ESST_Unknown, nullptr, nullptr }, // Enum
+		{ SpudTypeInfo<FVector>::EnumType,	&WriteQuantizedStructCodec<FVector>,			&ReadQuantizedStructCodec<FVector> },
+		{ SpudTypeInfo<FRotator>::EnumType,	&WriteQuantizedStructCodec<FRotator>,			&ReadQuantizedStructCodec<FRotator> },
+		{ SpudTypeInfo<FTransform>::EnumType,	&WriteQuantizedStructCodec<FTransform>,		&ReadQuantizedStructCodec<FTransform> },
+		{ ESST_Unknown, nullptr, nullptr }, // Guid
+	};
+	static_assert(UE_ARRAY_COUNT(Table) == static_cast<int>(ESpudPropertyCodec::Count), "Compact codec table out of sync with ESpudPropertyCodec");
+
+	const FCodecFuncs& Funcs = Table[static_cast<int>(Codec)];
+	return Funcs.Write ? &Funcs : nullptr;
+}
+
+const SpudPropertyUtil::FCodecFuncs& SpudPropertyUtil::GetCodecFuncs(ESpudPropertyCodec Codec,
+                                                                     const FSpudEncodingProfile& Encoding)
+{
+	if (Encoding.bCompact)
+	{
+		if (const FCodecFuncs* CompactFuncs = GetCompactCodecFuncs(Codec))
+			return *CompactFuncs;
+	}
+	return GetCodecFuncs(Codec);
+}
+
+bool SpudPropertyUtil::CanBulkSerializeArray(ESpudPropertyCodec ElementCodec, const FSpudEncodingProfile& Encoding,
+                                             const FArchive& Ar)
+{
+	// Values are always stored little-endian, so memory only matches the stored bytes if we're not swapping
+	if (Ar.IsByteSwapping())
+		return false;
+
+	// Compact encoding re-encodes these element by element
+	if (Encoding.bCompact && GetCompactCodecFuncs(ElementCodec))
+		return false;
+
+	switch (ElementCodec)
+	{
+	// Stored exactly as in memory
+	// Not bool (stored as uint8 but must be 0/1 in memory), or enums (stored as uint16 whatever the underlying type)
+	case ESpudPropertyCodec::Byte:
+	case ESpudPropertyCodec::UInt16:
+	case ESpudPropertyCodec::UInt32:
+	case ESpudPropertyCodec::UInt64:
+	case ESpudPropertyCodec::Int8:
+	case ESpudPropertyCodec::Int16:
+	case ESpudPropertyCodec::Int32:
+	case ESpudPropertyCodec::Int64:
+	case ESpudPropertyCodec::Float:
+	case ESpudPropertyCodec::Double:
+		return true;
+	case ESpudPropertyCodec::Guid:
+		// A, B, C, D
+		return sizeof(FGuid) == 4 * sizeof(uint32);
+	case ESpudPropertyCodec::Vector:
+	case ESpudPropertyCodec::Rotator:
+		// 3 components, only written at full precision with large world coordinates. Not FTransform, which
+		// is padded / SIMD aligned in memory
+		return sizeof(FVector) == 3 * sizeof(FVector::FReal) &&
+			sizeof(FRotator) == 3 * sizeof(FRotator::FReal) &&
+			Ar.UEVer() >= EUnrealEngineObjectUE5Version::LARGE_WORLD_COORDINATES;
+	default:
+		return false;
+	}
+}
+
+void SpudPropertyUtil::WriteEnumCodec(FProperty* Prop, uint32 PrefixID, const void* Data, bool bIsArrayElement,
+                                      int Depth, const TSharedPtr<FSpudClassDef>& ClassDef,
+                                      TArray<uint32>& PropertyOffsets, FSpudClassMetadata& Meta, FArchive& Out)
+{
+	const uint16 Val = WriteEnumPropertyData(static_cast<FEnumProperty*>(Prop), PrefixID, Data, bIsArrayElement,
+	                                         ClassDef, PropertyOffsets, Meta, Out);
+	UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(Val));
+}
+
+void SpudPropertyUtil::ReadEnumCodec(FProperty* Prop, void* Data, int Depth, const FSpudEncodingProfile& Encoding,
+                                     FArchive& In)
+{
+	const uint16 Val = ReadEnumPropertyData(static_cast<FEnumProperty*>(Prop), Data, In);
+	UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(Val));
+}
+
 FString SpudPropertyUtil::GetNestedPrefix(uint32 PrefixIDSoFar, FProperty* Prop, const FSpudClassMetadata& Meta)
 {
 	return (PrefixIDSoFar == SPUDDATA_PREFIXID_NONE) ? Prop->GetNameCPP() :
@@ -255,7 +468,7 @@ uint32 SpudPropertyUtil::GetNestedPrefixID(uint32 PrefixIDSoFar, FProperty* Prop
 	
 }
 
-void SpudPropertyUtil::RegisterProperty(uint32 PropNameID,
+uint16 SpudPropertyUtil::RegisterProperty(uint32 PropNameID,
                                         uint32 PrefixID,
                                         uint16 DataType,
                                         TSharedPtr<FSpudClassDef> ClassDef,
@@ -266,9 +479,10 @@ void SpudPropertyUtil::RegisterProperty(uint32 PropNameID,
 	if (PropertyOffsets.Num() < Index + 1)
 		PropertyOffsets.SetNum(Index + 1);
 	PropertyOffsets[Index] = Out.Tell();
+	return ClassDef->Properties[Index].DataType;
 }
 
-void SpudPropertyUtil::RegisterProperty(const FString& Name,
+uint16 SpudPropertyUtil::RegisterProperty(const FString& Name,
                                         uint32 PrefixID,
                                         uint16 DataType,
                                         TSharedPtr<FSpudClassDef> ClassDef,
@@ -279,7 +493,7 @@ void SpudPropertyUtil::RegisterProperty(const FString& Name,
 	return RegisterProperty(Meta.FindOrAddPropertyIDFromName(Name), PrefixID, DataType, ClassDef, PropertyOffsets, Out);
 }
 
-void SpudPropertyUtil::RegisterProperty(FProperty* Prop,
+uint16 SpudPropertyUtil::RegisterProperty(FProperty* Prop,
                                         uint32 PrefixID,
                                         TSharedPtr<FSpudClassDef> ClassDef,
                                         TArray<uint32>& PropertyOffsets,
@@ -289,16 +503,197 @@ void SpudPropertyUtil::RegisterProperty(FProperty* Prop,
 	return RegisterProperty(Meta.FindOrAddPropertyIDFromProperty(Prop), PrefixID, GetPropertyDataType(Prop), ClassDef, PropertyOffsets, Out);
 }
 
+int SpudPropertyUtil::RegisterUnchangedProperty(FProperty* Prop,
+                                               uint32 PrefixID,
+                                               TSharedPtr<FSpudClassDef> ClassDef,
+                                               TArray<uint32>& PropertyOffsets,
+                                               FSpudClassMetadata& Meta,
+                                               FArchive& Out)
+{
+	// Same as RegisterProperty, the property still needs to be in the class def so the fast path stays valid
+	const int Index = ClassDef->FindOrAddPropertyIndex(Meta.FindOrAddPropertyIDFromProperty(Prop), PrefixID, GetPropertyDataType(Prop));
+	if (PropertyOffsets.Num() < Index + 1)
+		PropertyOffsets.SetNum(Index + 1);
+	PropertyOffsets[Index] = Out.Tell();
+	return Index;
+}
+
+bool SpudPropertyUtil::CanStoreAsArchetypeDelta(const FSpudPropertyPlanStep& Step)
+{
+	// Codec is only set for values, or native arrays / sets / maps of values
+	return Step.Codec != ESpudPropertyCodec::None &&
+		!Step.bIsCustomStruct &&
+		Step.Property->ArrayDim == 1;
+}
+
+const void* SpudPropertyUtil::GetEquivalentContainerPtr(const UObject* RootObject, const void* ContainerPtr, const UObject* Other)
+{
+	if (!Other || Other->GetClass() != RootObject->GetClass())
+		return nullptr;
+
+	const UPTRINT Root = reinterpret_cast<UPTRINT>(RootObject);
+	const UPTRINT Container = reinterpret_cast<UPTRINT>(ContainerPtr);
+	if (Container < Root || Container - Root >= static_cast<UPTRINT>(RootObject->GetClass()->GetPropertiesSize()))
+		return nullptr;
+
+	return reinterpret_cast<const uint8*>(Other) + (Container - Root);
+}
+
 void SpudPropertyUtil::VisitPersistentProperties(UObject* RootObject, PropertyVisitor& Visitor, int StartDepth)
 {
-	VisitPersistentProperties(RootObject, RootObject->GetClass(), SPUDDATA_PREFIXID_NONE, RootObject,
-	                          false, StartDepth, Visitor);
+	const auto Plan = GetPropertyPlan(RootObject->GetClass());
+	VisitPlannedProperties(RootObject, *Plan, 0, Plan->Steps.Num(), SPUDDATA_PREFIXID_NONE, RootObject,
+	                       StartDepth, Visitor);
 }
 
 void SpudPropertyUtil::VisitPersistentProperties(const UStruct* Definition, PropertyVisitor& Visitor)
 {
-	VisitPersistentProperties(nullptr, Definition, SPUDDATA_PREFIXID_NONE, nullptr,
-	                          false, 0, Visitor);
+	const auto Plan = GetPropertyPlan(Definition);
+	VisitPlannedProperties(nullptr, *Plan, 0, Plan->Steps.Num(), SPUDDATA_PREFIXID_NONE, nullptr,
+	                       0, Visitor);
+}
+
+FSpudPropertyPlanPtr SpudPropertyUtil::GetPropertyPlan(const UStruct* Definition)
+{
+	const TObjectKey<UStruct> Key(Definition);
+	{
+		FReadScopeLock ReadLock(GSpudPropertyPlansLock);
+		if (const auto Existing = GSpudPropertyPlans.Find(Key))
+			return *Existing;
+	}
+
+	// Build outside the lock, another thread building the same plan at the same time is harmless
+	const auto Plan = MakeShared<FSpudPropertyPlan, ESPMode::ThreadSafe>();
+	BuildPropertyPlan(Definition, false, *Plan);
+
+	UE_LOG(LogSpudProps, Verbose, TEXT("Built property plan for %s, %d steps"), *Definition->GetName(), Plan->Steps.Num());
+
+	FWriteScopeLock WriteLock(GSpudPropertyPlansLock);
+	return GSpudPropertyPlans.FindOrAdd(Key, Plan);
+}
+
+void SpudPropertyUtil::FlushPropertyPlans()
+{
+	FWriteScopeLock WriteLock(GSpudPropertyPlansLock);
+	GSpudPropertyPlans.Empty();
+}
+
+void SpudPropertyUtil::BuildPropertyPlan(const UStruct* Definition, bool IsChildOfSaveGame, FSpudPropertyPlan& Plan)
+{
+	// Must produce exactly the same sequence as the reflective VisitPersistentProperties below
+	for (TFieldIterator<FProperty>PIT(Definition, EFieldIteratorFlags::IncludeSuper); PIT; ++PIT)
+	{
+		FProperty* Property = *PIT;
+
+		if (!ShouldPropertyBeIncluded(Property, IsChildOfSaveGame))
+			continue;
+
+		const int32 StepIndex = Plan.Steps.AddDefaulted();
+		{
+			auto& Step = Plan.Steps[StepIndex];
+			Step.Property = Property;
+			Step.bUnsupported = !IsPropertySupported(Property);
+			if (Step.bUnsupported)
+				continue;
+
+			Step.DataType = GetPropertyDataType(Property);
+			Step.bIsNestedUObject = IsNestedUObjectProperty(Property);
+			if (const auto AProp = CastField<FArrayProperty>(Property))
+			{
+				Step.bIsNativeArray = IsNativelySupportedArrayType(AProp);
+				if (Step.bIsNativeArray)
+					Step.Codec = GetPropertyCodec(AProp->Inner);
+			}
+			else if (const auto SetProp = CastField<FSetProperty>(Property))
+			{
+				Step.bIsNativeSet = IsNativelySupportedSetType(SetProp);
+				if (Step.bIsNativeSet)
+					Step.Codec = GetPropertyCodec(SetProp->ElementProp);
+			}
+			else if (const auto MProp = CastField<FMapProperty>(Property))
+			{
+				Step.bIsNativeMap = IsNativelySupportedMapType(MProp);
+				if (Step.bIsNativeMap)
+				{
+					Step.Codec = GetPropertyCodec(MProp->KeyProp);
+					Step.ValueCodec = GetPropertyCodec(MProp->ValueProp);
+				}
+			}
+			else
+			{
+				Step.Codec = GetPropertyCodec(Property);
+			}
+			if (const auto SProp = CastField<FStructProperty>(Property))
+			{
+				if (!IsBuiltInStructProperty(SProp))
+				{
+					Step.bIsCustomStruct = true;
+					// Instanced structs are resolved per instance at visit time
+					Step.bIsInstancedStruct = SProp->Struct->IsChildOf(FInstancedStruct::StaticStruct());
+				}
+			}
+		}
+
+		// Careful, adding nested steps can reallocate
+		if (Plan.Steps[StepIndex].bIsCustomStruct && !Plan.Steps[StepIndex].bIsInstancedStruct)
+		{
+			BuildPropertyPlan(CastFieldChecked<FStructProperty>(Property)->Struct, true, Plan);
+		}
+		Plan.Steps[StepIndex].NestedEnd = Plan.Steps.Num();
+	}
+}
+
+bool SpudPropertyUtil::VisitPlannedProperties(UObject* RootObject, const FSpudPropertyPlan& Plan, int32 BeginStep,
+                                              int32 EndStep, uint32 PrefixID, void* ContainerPtr, int Depth,
+                                              PropertyVisitor& Visitor)
+{
+	// NOTE: RootObject and ContainerPtr can be null (when parsing just definitions without instances)
+	int32 StepIndex = BeginStep;
+	while (StepIndex < EndStep)
+	{
+		const auto& Step = Plan.Steps[StepIndex];
+
+		if (Step.bUnsupported)
+		{
+			Visitor.UnsupportedProperty(RootObject, Step.Property, PrefixID, Depth);
+			++StepIndex;
+			continue;
+		}
+
+		// Visitor can early-out
+		if (!Visitor.VisitPlannedProperty(RootObject, Step, PrefixID, ContainerPtr, Depth))
+			return false;
+
+		if (Step.bIsInstancedStruct)
+		{
+			// Contents depend on the instance, fall back on reflection
+			if (!VisitNestedStructProperties(RootObject, CastFieldChecked<FStructProperty>(Step.Property), PrefixID,
+			                                 ContainerPtr, Depth, Visitor))
+				return false;
+		}
+		else if (Step.bIsCustomStruct)
+		{
+			const auto SProp = CastFieldChecked<FStructProperty>(Step.Property);
+			// Everything underneath a custom struct is recorded with a nested prefix
+			const uint32 NewPrefixID = Visitor.GetNestedPrefix(SProp, PrefixID);
+			// Should never have no prefix, if none skip the members
+			if (NewPrefixID != SPUDDATA_PREFIXID_NONE)
+			{
+				void* StructPtr = ContainerPtr ? SProp->ContainerPtrToValuePtr<void>(ContainerPtr) : nullptr;
+				const int NewDepth = Depth + 1;
+
+				Visitor.StartNestedStruct(RootObject, SProp, NewPrefixID, NewDepth);
+				if (!VisitPlannedProperties(RootObject, Plan, StepIndex + 1, Step.NestedEnd, NewPrefixID, StructPtr,
+				                            NewDepth, Visitor))
+					return false;
+				Visitor.EndNestedStruct(RootObject, SProp, NewPrefixID, NewDepth);
+			}
+		}
+
+		StepIndex = Step.NestedEnd;
+	}
+
+	return true;
 }
 
 bool SpudPropertyUtil::VisitPersistentProperties(UObject* RootObject, const UStruct* Definition, uint32 PrefixID,
@@ -328,45 +723,8 @@ bool SpudPropertyUtil::VisitPersistentProperties(UObject* RootObject, const UStr
 		{
 			if (!IsBuiltInStructProperty(SProp))
 			{
-				const UScriptStruct* StructDefinition = nullptr;
-				void* StructPtr = nullptr;
-
-				// Check if it's a InstancedStruct
-             	if(SProp->Struct->IsChildOf(FInstancedStruct::StaticStruct()))
-             	{
-             		// If it is, we need to get the actual struct from the property
-             		const FInstancedStruct* InstancedStruct = ContainerPtr ? SProp->ContainerPtrToValuePtr<FInstancedStruct>(ContainerPtr) : nullptr;
-
-             		if(InstancedStruct)
-             		{
-             			if(!InstancedStruct->IsValid())
-             			{
-             				// If it's not valid, ignore it
-			 				continue;
-             			}
-
-             			StructDefinition = InstancedStruct->GetScriptStruct();
-			 			StructPtr = (void*)InstancedStruct->GetMemory();
-             		}
-             	}
-                else
-                {
-                	StructDefinition = SProp->Struct;
-                	StructPtr = ContainerPtr ? SProp->ContainerPtrToValuePtr<void>(ContainerPtr) : nullptr;
-                }
-
-				// Everything underneath a custom struct is recorded with a nested prefix
-				const uint32 NewPrefixID = Visitor.GetNestedPrefix(SProp, PrefixID);
-				// Should never have no prefix, if none abort
-				if (NewPrefixID == SPUDDATA_PREFIXID_NONE)
-					continue;
-
-				const int NewDepth = Depth + 1;
-		
-				Visitor.StartNestedStruct(RootObject, SProp, NewPrefixID, NewDepth);
-				if (!VisitPersistentProperties(RootObject, StructDefinition, NewPrefixID, StructPtr, true, NewDepth, Visitor))
-					return false;				
-				Visitor.EndNestedStruct(RootObject, SProp, NewPrefixID, NewDepth);
+				if (!VisitNestedStructProperties(RootObject, SProp, PrefixID, ContainerPtr, Depth, Visitor))
+					return false;
 			}
 		}
 
@@ -377,6 +735,52 @@ bool SpudPropertyUtil::VisitPersistentProperties(UObject* RootObject, const UStr
 	return true;
 }
 
+bool SpudPropertyUtil::VisitNestedStructProperties(UObject* RootObject, FStructProperty* SProp, uint32 PrefixID,
+                                                   void* ContainerPtr, int Depth, PropertyVisitor& Visitor)
+{
+	const UScriptStruct* StructDefinition = nullptr;
+	void* StructPtr = nullptr;
+
+	// Check if it's a InstancedStruct
+	if(SProp->Struct->IsChildOf(FInstancedStruct::StaticStruct()))
+	{
+		// If it is, we need to get the actual struct from the property
+		const FInstancedStruct* InstancedStruct = ContainerPtr ? SProp->ContainerPtrToValuePtr<FInstancedStruct>(ContainerPtr) : nullptr;
+
+		if(InstancedStruct)
+		{
+			if(!InstancedStruct->IsValid())
+			{
+				// If it's not valid, ignore it
+				return true;
+			}
+
+			StructDefinition = InstancedStruct->GetScriptStruct();
+			StructPtr = (void*)InstancedStruct->GetMemory();
+		}
+	}
+	else
+	{
+		StructDefinition = SProp->Struct;
+		StructPtr = ContainerPtr ? SProp->ContainerPtrToValuePtr<void>(ContainerPtr) : nullptr;
+	}
+
+	// Everything underneath a custom struct is recorded with a nested prefix
+	const uint32 NewPrefixID = Visitor.GetNestedPrefix(SProp, PrefixID);
+	// Should never have no prefix, if none abort
+	if (NewPrefixID == SPUDDATA_PREFIXID_NONE)
+		return true;
+
+	const int NewDepth = Depth + 1;
+
+	Visitor.StartNestedStruct(RootObject, SProp, NewPrefixID, NewDepth);
+	if (!VisitPersistentProperties(RootObject, StructDefinition, NewPrefixID, StructPtr, true, NewDepth, Visitor))
+		return false;
+	Visitor.EndNestedStruct(RootObject, SProp, NewPrefixID, NewDepth);
+
+	return true;
+}
+
 uint16 SpudPropertyUtil::WriteEnumPropertyData(FEnumProperty* EProp,
                                                uint32 PrefixID,
                                                const void* Data,
@@ -395,27 +799,6 @@ uint16 SpudPropertyUtil::WriteEnumPropertyData(FEnumProperty* EProp,
 	return Val;
 }
 
-bool SpudPropertyUtil::TryWriteEnumPropertyData(FProperty* Property,
-                                                uint32 PrefixID,
-                                                const void* Data,
-                                                bool bIsArrayElement,
-                                                int Depth,
-                                                TSharedPtr<FSpudClassDef> ClassDef,
-                                                TArray<uint32>& PropertyOffsets,
-                                                FSpudClassMetadata& Meta,
-                                                FArchive& Out)
-{
-	if (const auto EProp = CastField<FEnumProperty>(Property))
-	{
-		// Enums as 16-bit numbers, that should be large enough!
-		const uint16 Val = WriteEnumPropertyData(EProp, PrefixID, Data, bIsArrayElement, ClassDef, PropertyOffsets,
-		                                         Meta, Out);
-		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Property, Depth), *ToString(Val));
-		return true;
-	}
-	return false;
-}
-
 uint16 SpudPropertyUtil::ReadEnumPropertyData(FEnumProperty* EProp, void* Data, FArchive& In)
 {
 	uint16 Val;
@@ -426,22 +809,6 @@ uint16 SpudPropertyUtil::ReadEnumPropertyData(FEnumProperty* EProp, void* Data,
 	return Val;
 }
 
-bool SpudPropertyUtil::TryReadEnumPropertyData(FProperty* Prop, void* Data,
-                                                     const FSpudPropertyDef& StoredProperty,
-                                                     int Depth, FArchive& In)
-{
-	auto EProp = CastField<FEnumProperty>(Prop);
-	if (EProp && StoredPropertyTypeMatchesRuntime(Prop, StoredProperty, true))
-		// we ignore array flag since we could be processing inner
-	{
-		// Enums as 16-bit numbers, that should be large enough!
-		const uint16 Val = ReadEnumPropertyData(EProp, Data, In);
-		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(Val));
-		return true;
-	}
-	return false;
-}
-
 FString SpudPropertyUtil::WriteActorRefPropertyData(FProperty* OProp,
                                                     AActor* Actor,
                                                     uint32 PrefixID,
@@ -456,6 +823,7 @@ FString SpudPropertyUtil::WriteActorRefPropertyData(FProperty* OProp,
 		RegisterProperty(OProp, PrefixID, ClassDef, PropertyOffsets, Meta, Out);
 
 	FString RefString;
+	FGuid Guid;
 	// We already have the Actor so no need to get property value
 	if (Actor)
 	{
@@ -484,7 +852,7 @@ FString SpudPropertyUtil::WriteActorRefPropertyData(FProperty* OProp,
 			}
 			else
 			{
-				FGuid Guid = GetGuidProperty(Actor, GuidProperty);
+				Guid = GetGuidProperty(Actor, GuidProperty);
 				if (!Guid.IsValid())
 				{
 					// We automatically generate a Guid for any referenced object if it doesn't have one already
@@ -505,8 +873,25 @@ FString SpudPropertyUtil::WriteActorRefPropertyData(FProperty* OProp,
 	}
 	else
 		RefString = FString();
-	
-	Out << RefString;
+
+	if (ClassDef->Encoding.bIndexedObjectRefs)
+	{
+		// Index + 1 into the reference table, so that 0 can be null
+		uint32 StoredIndex = 0;
+		if (!RefString.IsEmpty())
+		{
+			const FSpudObjectRef Ref = Guid.IsValid() ? FSpudObjectRef(Guid) : FSpudObjectRef(RefString);
+			StoredIndex = Meta.ObjectRefIndex.FindOrAddIndex(Ref) + 1;
+		}
+		if (ClassDef->Encoding.bCompact)
+			WriteVarInt(StoredIndex, Out);
+		else
+			Out << StoredIndex;
+	}
+	else
+	{
+		Out << RefString;
+	}
 	return RefString;
 }
 
@@ -652,8 +1037,50 @@ FString SpudPropertyUtil::ReadActorRefPropertyData(FProperty* OProp,
                                                    void* Data,
                                                    const RuntimeObjectMap* RuntimeObjects,
                                                    ULevel* Level,
+                                                   const FSpudClassMetadata& Meta,
+                                                   const FSpudEncodingProfile& Encoding,
                                                    FArchive& In)
 {
+	if (Encoding.bIndexedObjectRefs)
+	{
+		// Index + 1 into the reference table, 0 is null
+		uint32 StoredIndex;
+		if (Encoding.bCompact)
+			StoredIndex = static_cast<uint32>(ReadVarInt(In));
+		else
+			In << StoredIndex;
+
+		if (StoredIndex == 0)
+		{
+			SetObjectPropertyValue(OProp, Data, nullptr);
+			return FString();
+		}
+		const uint32 RefIndex = StoredIndex - 1;
+		if (RefIndex >= static_cast<uint32>(Meta.ObjectRefIndex.UniqueValues.Num()))
+		{
+			UE_LOG(LogSpudProps, Error, TEXT("Invalid object reference index %u for property %s"), RefIndex, *OProp->GetName());
+			return FString();
+		}
+
+		const FSpudObjectRef& Ref = Meta.ObjectRefIndex.GetValue(RefIndex);
+		UObject* Obj = nullptr;
+		// Only successful resolves are remembered; runtime objects are still being added while a level restores
+		const TWeakObjectPtr<UObject>* Resolved = RuntimeObjects ? RuntimeObjects->ResolvedRefs.Find(RefIndex) : nullptr;
+		if (Resolved && Resolved->IsValid())
+		{
+			Obj = Resolved->Get();
+		}
+		else
+		{
+			Obj = ResolveActorRef(OProp, Ref, RuntimeObjects, Level);
+			if (Obj && RuntimeObjects)
+				RuntimeObjects->ResolvedRefs.Add(RefIndex, Obj);
+		}
+		if (Obj)
+			SetObjectPropertyValue(OProp, Data, Obj);
+		return Ref.ToString();
+	}
+
 	FString RefString;
 	In << RefString;
 
@@ -666,72 +1093,88 @@ FString SpudPropertyUtil::ReadActorRefPropertyData(FProperty* OProp,
 	{
 		// Runtime object, identified by GUID
 		// We used the braces-format GUID for runtime objects so that it's easy to identify
-		if (RuntimeObjects)
+		FGuid Guid;
+		if (FGuid::ParseExact(RefString, EGuidFormats::DigitsWithHyphensInBraces, Guid))
 		{
-			FGuid Guid;
-			if (FGuid::ParseExact(RefString, EGuidFormats::DigitsWithHyphensInBraces, Guid))
-			{
-				auto ObjPtr = RuntimeObjects->Find(Guid);
-				if (ObjPtr)
-				{
-					SetObjectPropertyValue(OProp, Data, *ObjPtr);
-				}
-				else
-				{
-					UE_LOG(LogSpudProps, Error, TEXT("Could not locate runtime object for property %s, GUID was %s"), *OProp->GetName(), *RefString);	
-				}			
-			}
-			else
-			{
-				UE_LOG(LogSpudProps, Error, TEXT("Error parsing GUID %s for property %s"), *RefString, *OProp->GetName());
-			}
+			if (UObject* Obj = ResolveActorRef(OProp, FSpudObjectRef(Guid), RuntimeObjects, Level))
+				SetObjectPropertyValue(OProp, Data, Obj);
 		}
 		else
-			UE_LOG(LogSpudProps, Error, TEXT("Found property reference to runtime object %s->%s but no RuntimeObjects passed (global object?)"), *OProp->GetName(), *RefString);
+		{
+			UE_LOG(LogSpudProps, Error, TEXT("Error parsing GUID %s for property %s"), *RefString, *OProp->GetName());
+		}
 	}
 	else
 	{
-		// Level object, identified by name. Level is the package
-		if (Level)
+		if (UObject* Obj = ResolveActorRef(OProp, FSpudObjectRef(RefString), RuntimeObjects, Level))
+			SetObjectPropertyValue(OProp, Data, Obj);
+	}
+	return RefString;
+}
+
+UObject* SpudPropertyUtil::ResolveActorRef(const FProperty* OProp,
+                                           const FSpudObjectRef& Ref,
+                                           const RuntimeObjectMap* RuntimeObjects,
+                                           ULevel* Level)
+{
+	if (Ref.Type == ESpudObjectRefType::Guid)
+	{
+		// Runtime object, identified by GUID
+		if (!RuntimeObjects)
 		{
-			const auto World = Level->GetWorld();
+			UE_LOG(LogSpudProps, Error, TEXT("Found property reference to runtime object %s->%s but no RuntimeObjects passed (global object?)"), *OProp->GetName(), *Ref.ToString());
+			return nullptr;
+		}
 
-			auto Obj = StaticFindObjectFast(AActor::StaticClass(), Level, *RefString);
-			if (!Obj)
-			{
-				// Not found in owning level, search all
-				for (const auto OtherLevel : World->GetLevels())
-				{
-					if (OtherLevel == Level)
-						continue;
-					Obj = StaticFindObjectFast(AActor::StaticClass(), OtherLevel, *RefString);
-					if (Obj)
-						break;
-				}
-			}
+		auto ObjPtr = RuntimeObjects->ObjectsByGuid.Find(Ref.ActorGuid);
+		if (!ObjPtr || !ObjPtr->IsValid())
+		{
+			UE_LOG(LogSpudProps, Error, TEXT("Could not locate runtime object for property %s, GUID was %s"), *OProp->GetName(), *Ref.ToString());
+			return nullptr;
+		}
+		return ObjPtr->Get();
+	}
 
-			if (!Obj)
-			{
-				// some actors might override their name, which is not taken into account above
-				Obj = FindObjectWithOverridenName(World, RefString);
-			}
+	// Level object, identified by name. Level is the package
+	if (!Level)
+	{
+		UE_LOG(LogSpudProps, Error, TEXT("Level object for property %s cannot be resolved, null parent Level"), *OProp->GetName());
+		return nullptr;
+	}
+
+	const auto World = Level->GetWorld();
+	const FString& RefString = Ref.Name;
 
+	UObject* Obj = StaticFindObjectFast(AActor::StaticClass(), Level, *RefString);
+	if (!Obj && RuntimeObjects)
+	{
+		// Not found in owning level, use the index shared by this restore for other levels & overridden names
+		Obj = RuntimeObjects->FindActorInWorld(World, RefString);
+	}
+	else if (!Obj)
+	{
+		// Not found in owning level, search all
+		for (const auto OtherLevel : World->GetLevels())
+		{
+			if (OtherLevel == Level)
+				continue;
+			Obj = StaticFindObjectFast(AActor::StaticClass(), OtherLevel, *RefString);
 			if (Obj)
-			{
-				SetObjectPropertyValue(OProp, Data, Obj);
-			}
-			else
-			{
-				UE_LOG(LogSpudProps, Error, TEXT("Could not locate level object for property %s, name was %s"), *OProp->GetName(), *RefString);
-			}
+				break;
 		}
-		else
+
+		if (!Obj)
 		{
-			UE_LOG(LogSpudProps, Error, TEXT("Level object for property %s cannot be resolved, null parent Level"), *OProp->GetName());	
+			// some actors might override their name, which is not taken into account above
+			Obj = FindObjectWithOverridenName(World, RefString);
 		}
-		
 	}
-	return RefString;
+
+	if (!Obj)
+	{
+		UE_LOG(LogSpudProps, Error, TEXT("Could not locate level object for property %s, name was %s"), *OProp->GetName(), *RefString);
+	}
+	return Obj;
 }
 
 FString SpudPropertyUtil::ReadNestedUObjectPropertyData(FObjectProperty* OProp,
@@ -837,7 +1280,8 @@ FString SpudPropertyUtil::ReadSubclassOfPropertyData(FClassProperty* CProp,
 
 bool SpudPropertyUtil::TryReadUObjectPropertyData(FProperty* Prop, void* Data,
                                                   const FSpudPropertyDef& StoredProperty, const RuntimeObjectMap* RuntimeObjects, ULevel* Level, UObject* Outer,
-                                                  const FSpudClassMetadata& Meta, int Depth, FArchive& In)
+                                                  const FSpudClassMetadata& Meta, const FSpudEncodingProfile& Encoding,
+                                                  int Depth, FArchive& In)
 {
 	FObjectProperty* StrongProp = CastField<FObjectProperty>(Prop);
 	FWeakObjectProperty* WeakProp = CastField<FWeakObjectProperty>(Prop);
@@ -849,7 +1293,7 @@ bool SpudPropertyUtil::TryReadUObjectPropertyData(FProperty* Prop, void* Data,
 		// Actor refs supports both strong & weak object refs
 		if (IsActorObjectProperty(Prop))
 		{
-			const FString Val = ReadActorRefPropertyData(Prop, Data, RuntimeObjects, Level, In);
+			const FString Val = ReadActorRefPropertyData(Prop, Data, RuntimeObjects, Level, Meta, Encoding, In);
 			UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *Val);
 		}
 		else if (auto CProp = CastField<FClassProperty>(Prop))
@@ -887,6 +1331,45 @@ void SpudPropertyUtil::SetObjectPropertyValue(FProperty* Property, void* Data, U
 	}
 }
 
+AActor* SpudPropertyUtil::RuntimeObjectMap::FindActorInWorld(const UWorld* World, const FString& Name) const
+{
+	if (!bActorIndexBuilt && World)
+	{
+		// Index every loaded level once; earlier levels win, same as searching them in order
+		for (const auto Level : World->GetLevels())
+		{
+			if (!IsValid(Level))
+				continue;
+
+			for (const auto Actor : Level->Actors)
+			{
+				if (!IsValid(Actor))
+					continue;
+
+				if (!ActorsByName.Contains(Actor->GetFName()))
+					ActorsByName.Add(Actor->GetFName(), Actor);
+
+				if (Actor->Implements<USpudObject>())
+				{
+					const FString OverrideName = ISpudObject::Execute_OverrideName(Actor);
+					if (!OverrideName.IsEmpty() && !ActorsByOverrideName.Contains(OverrideName))
+						ActorsByOverrideName.Add(OverrideName, Actor);
+				}
+			}
+		}
+		bActorIndexBuilt = true;
+	}
+
+	// FNAME_Find so we don't add names to the table just to look them up; no FName means no actor with that name
+	const FName ActorName(*Name, FNAME_Find);
+	const TWeakObjectPtr<AActor>* Found = ActorName.IsNone() ? nullptr : ActorsByName.Find(ActorName);
+	if (!Found)
+		Found = ActorsByOverrideName.Find(Name);
+
+	// Actors can be destroyed during the restore after the index was built
+	return Found ? Found->Get() : nullptr;
+}
+
 UObject* SpudPropertyUtil::FindObjectWithOverridenName(const UWorld* World, const FString& RefString)
 {
 	for (TActorIterator<AActor> It(World); It; ++It)
@@ -913,21 +1396,58 @@ void SpudPropertyUtil::StoreProperty(const UObject* RootObject,
                                      FSpudClassMetadata& Meta,
                                      FSpudMemoryWriter& Out)
 {
-	// Arrays supported, but not maps / sets yet
 	if (const auto AProp = CastField<FArrayProperty>(Property))
 	{
 		if (IsNativelySupportedArrayType(AProp))
 		{
-			StoreArrayProperty(AProp, RootObject, PrefixID, ContainerPtr, Depth, ClassDef, PropertyOffsets, Meta, Out);
+			StoreArrayProperty(AProp, GetPropertyCodec(AProp->Inner), RootObject, PrefixID, ContainerPtr, Depth, ClassDef, PropertyOffsets, Meta, Out);
+			return;
+		}
+	}
+	else if (const auto SetProp = CastField<FSetProperty>(Property))
+	{
+		if (IsNativelySupportedSetType(SetProp))
+		{
+			StoreSetProperty(SetProp, GetPropertyCodec(SetProp->ElementProp), PrefixID, ContainerPtr, Depth, ClassDef, PropertyOffsets, Meta, Out);
+			return;
+		}
+	}
+	else if (const auto MProp = CastField<FMapProperty>(Property))
+	{
+		if (IsNativelySupportedMapType(MProp))
+		{
+			StoreMapProperty(MProp, GetPropertyCodec(MProp->KeyProp), GetPropertyCodec(MProp->ValueProp), PrefixID, ContainerPtr, Depth, ClassDef, PropertyOffsets, Meta, Out);
 			return;
 		}
 	}
 
-	// Includes arrays of custom structs, maps etc
-	StoreContainerProperty(Property, RootObject, PrefixID, ContainerPtr, false, Depth, ClassDef, PropertyOffsets, Meta, Out);
+	// Includes arrays of custom structs, unsupported maps etc
+	StoreContainerProperty(Property, GetPropertyCodec(Property), RootObject, PrefixID, ContainerPtr, false, Depth, ClassDef, PropertyOffsets, Meta, Out);
+}
+
+void SpudPropertyUtil::StoreProperty(const UObject* RootObject,
+                                     const FSpudPropertyPlanStep& Step,
+                                     uint32 PrefixID,
+                                     const void* ContainerPtr,
+                                     int Depth,
+                                     TSharedPtr<FSpudClassDef> ClassDef,
+                                     TArray<uint32>& PropertyOffsets,
+                                     FSpudClassMetadata& Meta,
+                                     FSpudMemoryWriter& Out)
+{
+	// Same as above but type was resolved when the plan was built
+	if (Step.bIsNativeArray)
+		StoreArrayProperty(CastFieldChecked<FArrayProperty>(Step.Property), Step.Codec, RootObject, PrefixID, ContainerPtr, Depth, ClassDef, PropertyOffsets, Meta, Out);
+	else if (Step.bIsNativeSet)
+		StoreSetProperty(CastFieldChecked<FSetProperty>(Step.Property), Step.Codec, PrefixID, ContainerPtr, Depth, ClassDef, PropertyOffsets, Meta, Out);
+	else if (Step.bIsNativeMap)
+		StoreMapProperty(CastFieldChecked<FMapProperty>(Step.Property), Step.Codec, Step.ValueCodec, PrefixID, ContainerPtr, Depth, ClassDef, PropertyOffsets, Meta, Out);
+	else
+		StoreContainerProperty(Step.Property, Step.Codec, RootObject, PrefixID, ContainerPtr, false, Depth, ClassDef, PropertyOffsets, Meta, Out);
 }
 
 void SpudPropertyUtil::StoreArrayProperty(FArrayProperty* AProp,
+                                          ESpudPropertyCodec ElementCodec,
                                           const UObject* RootObject,
                                           uint32 PrefixID,
                                           const void* ContainerPtr,
@@ -941,28 +1461,154 @@ void SpudPropertyUtil::StoreArrayProperty(FArrayProperty* AProp,
 	// Use helper to get number, ArrayDim doesn't seem to work?
 	const void* DataPtr = AProp->ContainerPtrToValuePtr<void>(ContainerPtr);
 	FScriptArrayHelper ArrayHelper(AProp, DataPtr);
-	const int32 NumElements = ArrayHelper.Num();
+	int32 NumElements = ArrayHelper.Num();
 
-	if (NumElements > std::numeric_limits<uint16>::max())
+	// Class def may have come from older data which still has 16-bit counts, must stay consistent with that
+	const uint16 StoredType = RegisterProperty(AProp, PrefixID, ClassDef, PropertyOffsets, Meta, Out);
+	
+	// Data is count first, then elements
+	if (StoredType & ESST_VarCount)
+	{
+		WriteVarUInt(static_cast<uint64>(NumElements), Out);
+	}
+	else
 	{
-		UE_LOG(LogSpudProps, Error, TEXT("Array property %s/%s has %d elements, exceeds maximum of %d, will be truncated"),
-			*RootObject->GetName(), *AProp->GetName(), NumElements, std::numeric_limits<uint16>::max());
+		if (NumElements > std::numeric_limits<uint16>::max())
+		{
+			UE_LOG(LogSpudProps, Error, TEXT("Array property %s/%s has %d elements, exceeds maximum of %d for data from an older save, will be truncated"),
+				*RootObject->GetName(), *AProp->GetName(), NumElements, std::numeric_limits<uint16>::max());
+			NumElements = std::numeric_limits<uint16>::max();
+		}
+		uint16 ShortElems = static_cast<uint16>(NumElements);
+		Out << ShortElems;
 	}
 
-	RegisterProperty(AProp, PrefixID, ClassDef, PropertyOffsets, Meta, Out);
+	const FSpudEncodingProfile& Encoding = ClassDef->Encoding;
+	if (NumElements > 0 && CanBulkSerializeArray(ElementCodec, Encoding, Out))
+	{
+		// Stored bytes are identical to the in-memory elements, write them as one block
+		const int64 NumBytes = static_cast<int64>(NumElements) * AProp->Inner->GetElementSize();
+		Out.Serialize(ArrayHelper.GetRawPtr(0), NumBytes);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = [%d elements, %lld bytes]"), *GetLogPrefix(AProp, Depth), NumElements, NumBytes);
+	}
+	else if (Encoding.bCompact && ElementCodec == ESpudPropertyCodec::Bool)
+	{
+		// Bit-packed, 8 per byte, low bit first
+		const FBoolProperty* Inner = CastFieldChecked<FBoolProperty>(AProp->Inner);
+		uint8 Bits = 0;
+		for (int ArrayElem = 0; ArrayElem < NumElements; ++ArrayElem)
+		{
+			if (Inner->GetPropertyValue(ArrayHelper.GetRawPtr(ArrayElem)))
+				Bits |= 1 << (ArrayElem & 7);
+			if ((ArrayElem & 7) == 7 || ArrayElem == NumElements - 1)
+			{
+				Out << Bits;
+				Bits = 0;
+			}
+		}
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = [%d bit-packed elements]"), *GetLogPrefix(AProp, Depth), NumElements);
+	}
+	else if (ElementCodec != ESpudPropertyCodec::None)
+	{
+		// Resolved element type, so each element is just one call
+		FProperty* Inner = AProp->Inner;
+		const FCodecWriteFunc WriteFunc = GetCodecFuncs(ElementCodec, Encoding).Write;
+		for (int ArrayElem = 0; ArrayElem < NumElements; ++ArrayElem)
+		{
+			const void* ElemPtr = Inner->ContainerPtrToValuePtr<void>(ArrayHelper.GetRawPtr(ArrayElem));
+			WriteFunc(Inner, PrefixID, ElemPtr, true, Depth, ClassDef, PropertyOffsets, Meta, Out);
+		}
+	}
+	else
+	{
+		for (int ArrayElem = 0; ArrayElem < NumElements; ++ArrayElem)
+		{
+			void *ElemPtr = ArrayHelper.GetRawPtr(ArrayElem);
+			StoreContainerProperty(AProp->Inner, ElementCodec, RootObject, PrefixID, ElemPtr, true, Depth, ClassDef, PropertyOffsets, Meta, Out);
+		}
+	}
 	
+}
+
+void SpudPropertyUtil::StoreSetProperty(FSetProperty* SProp,
+                                        ESpudPropertyCodec ElementCodec,
+                                        uint32 PrefixID,
+                                        const void* ContainerPtr,
+                                        int Depth,
+                                        TSharedPtr<FSpudClassDef> ClassDef,
+                                        TArray<uint32>& PropertyOffsets,
+                                        FSpudClassMetadata& Meta,
+                                        FSpudMemoryWriter& Out)
+{
+	const void* DataPtr = SProp->ContainerPtrToValuePtr<void>(ContainerPtr);
+	FScriptSetHelper SetHelper(SProp, DataPtr);
+	const int32 NumElements = SetHelper.Num();
+
+	RegisterProperty(SProp, PrefixID, ClassDef, PropertyOffsets, Meta, Out);
+
 	// Data is count first, then elements
-	uint16 ShortElems = static_cast<uint16>(NumElements);
-	Out << ShortElems;
-	for (int ArrayElem = 0; ArrayElem < NumElements; ++ArrayElem)
+	WriteVarUInt(static_cast<uint64>(NumElements), Out);
+	UE_LOG(LogSpudProps, Verbose, TEXT("%s = [%d elements]"), *GetLogPrefix(SProp, Depth), NumElements);
+
+	// Set storage is sparse
+	FProperty* ElementProp = SProp->ElementProp;
+	const FCodecWriteFunc WriteFunc = GetCodecFuncs(ElementCodec, ClassDef->Encoding).Write;
+	for (int32 Index = 0, Remaining = NumElements; Remaining > 0; ++Index)
 	{
-		void *ElemPtr = ArrayHelper.GetRawPtr(ArrayElem);
-		StoreContainerProperty(AProp->Inner, RootObject, PrefixID, ElemPtr, true, Depth, ClassDef, PropertyOffsets, Meta, Out);
+		if (SetHelper.IsValidIndex(Index))
+		{
+			WriteFunc(ElementProp, PrefixID, SetHelper.GetElementPtr(Index), true, Depth, ClassDef, PropertyOffsets, Meta, Out);
+			--Remaining;
+		}
+	}
+}
+
+void SpudPropertyUtil::StoreMapProperty(FMapProperty* MProp,
+                                        ESpudPropertyCodec KeyCodec,
+                                        ESpudPropertyCodec ValueCodec,
+                                        uint32 PrefixID,
+                                        const void* ContainerPtr,
+                                        int Depth,
+                                        TSharedPtr<FSpudClassDef> ClassDef,
+                                        TArray<uint32>& PropertyOffsets,
+                                        FSpudClassMetadata& Meta,
+                                        FSpudMemoryWriter& Out)
+{
+	const void* DataPtr = MProp->ContainerPtrToValuePtr<void>(ContainerPtr);
+	FScriptMapHelper MapHelper(MProp, DataPtr);
+	const int32 NumPairs = MapHelper.Num();
+
+	RegisterProperty(MProp, PrefixID, ClassDef, PropertyOffsets, Meta, Out);
+
+	// Data is count first, then all keys, then all values (packs better than interleaved)
+	WriteVarUInt(static_cast<uint64>(NumPairs), Out);
+	UE_LOG(LogSpudProps, Verbose, TEXT("%s = [%d pairs]"), *GetLogPrefix(MProp, Depth), NumPairs);
+
+	// Map storage is sparse
+	TArray<int32, TInlineAllocator<64>> ValidIndexes;
+	ValidIndexes.Reserve(NumPairs);
+	for (int32 Index = 0; ValidIndexes.Num() < NumPairs; ++Index)
+	{
+		if (MapHelper.IsValidIndex(Index))
+			ValidIndexes.Add(Index);
+	}
+
+	FProperty* KeyProp = MProp->KeyProp;
+	const FCodecWriteFunc KeyWriteFunc = GetCodecFuncs(KeyCodec, ClassDef->Encoding).Write;
+	for (const int32 Index : ValidIndexes)
+	{
+		KeyWriteFunc(KeyProp, PrefixID, MapHelper.GetKeyPtr(Index), true, Depth, ClassDef, PropertyOffsets, Meta, Out);
+	}
+	FProperty* ValueProp = MProp->ValueProp;
+	const FCodecWriteFunc ValueWriteFunc = GetCodecFuncs(ValueCodec, ClassDef->Encoding).Write;
+	for (const int32 Index : ValidIndexes)
+	{
+		ValueWriteFunc(ValueProp, PrefixID, MapHelper.GetValuePtr(Index), true, Depth, ClassDef, PropertyOffsets, Meta, Out);
 	}
-	
 }
 
 void SpudPropertyUtil::StoreContainerProperty(FProperty* Property,
+                                              ESpudPropertyCodec Codec,
                                               const UObject* RootObject,
                                               uint32 PrefixID,
                                               const void* ContainerPtr,
@@ -974,50 +1620,29 @@ void SpudPropertyUtil::StoreContainerProperty(FProperty* Property,
                                               FSpudMemoryWriter& Out)
 {
 	bool bUpdateOK = false;
-	if (IsPropertyNativelySupported(Property))
+	if (Codec != ESpudPropertyCodec::None)
+	{
+		// Primitives & builtin structs, type already resolved
+		const void* DataPtr = Property->ContainerPtrToValuePtr<void>(ContainerPtr);
+		GetCodecFuncs(Codec, ClassDef->Encoding).Write(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out);
+		bUpdateOK = true;
+	}
+	else if (IsPropertyNativelySupported(Property))
 	{
 		// Get pointer to data within container, must be from original property in the case of arrays
 		const void* DataPtr = Property->ContainerPtrToValuePtr<void>(ContainerPtr);
-		if (const auto SProp = CastField<FStructProperty>(Property))
+		// Builtin structs & primitives have a codec, so this is a custom struct or UObject
+		if (CastField<FStructProperty>(Property))
 		{
-			if (IsBuiltInStructProperty(SProp))
-			{
-				// Builtin structs
-				bUpdateOK =
-					TryWriteBuiltinStructPropertyData<FVector>(SProp, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-					TryWriteBuiltinStructPropertyData<FRotator>(SProp, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-					TryWriteBuiltinStructPropertyData<FTransform>(SProp, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-					TryWriteBuiltinStructPropertyData<FGuid>(SProp, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out);
-			}
-			else
-			{
-				// We assume that nested custom structs are ok
-				// We don't cascade here any more, visitor does it
-				// Just log fo consistency
-				UE_LOG(LogSpudProps, Verbose, TEXT("%s:"), *GetLogPrefix(Property, Depth));
-				bUpdateOK = true;
-			}
+			// We assume that nested custom structs are ok
+			// We don't cascade here any more, visitor does it
+			// Just log fo consistency
+			UE_LOG(LogSpudProps, Verbose, TEXT("%s:"), *GetLogPrefix(Property, Depth));
+			bUpdateOK = true;
 		}
 		else 
 		{
-			bUpdateOK =
-				TryWritePropertyData<FBoolProperty,		bool>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FByteProperty,		uint8>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FUInt16Property,	uint16>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FUInt32Property,	uint32>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FUInt64Property,	uint64>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FInt8Property,		int8>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FInt16Property,	int16>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FIntProperty,		int>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FInt64Property,	int64>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FFloatProperty,	float>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FDoubleProperty,	double>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FStrProperty,		FString>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FNameProperty,		FName>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWritePropertyData<FTextProperty,		FText>(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWriteEnumPropertyData(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out) ||
-				TryWriteUObjectPropertyData(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out);;
-		
+			bUpdateOK = TryWriteUObjectPropertyData(Property, PrefixID, DataPtr, bIsArrayElement, Depth, ClassDef, PropertyOffsets, Meta, Out);
 		}
 	}
 	else if (IsPropertyFallbackSupported(Property))
@@ -1042,53 +1667,227 @@ void SpudPropertyUtil::StoreContainerProperty(FProperty* Property,
 
 void SpudPropertyUtil::RestoreProperty(UObject* RootObject, FProperty* Property, void* ContainerPtr,
                                              const FSpudPropertyDef& StoredProperty,
+                                             const FSpudEncodingProfile& Encoding,
                                              const RuntimeObjectMap* RuntimeObjects,
                                              const FSpudClassMetadata& Meta,
                                              int Depth,
                                              FSpudMemoryReader& DataIn)
 {
-	// Arrays supported, but not maps / sets yet
 	if (const auto AProp = CastField<FArrayProperty>(Property))
 	{
 		if (IsNativelySupportedArrayType(AProp))
 		{
-			RestoreArrayProperty(RootObject, AProp, ContainerPtr, StoredProperty, RuntimeObjects, Meta, Depth, DataIn);
+			RestoreArrayProperty(RootObject, AProp, GetPropertyCodec(AProp->Inner), ContainerPtr, StoredProperty, Encoding, RuntimeObjects, Meta, Depth, DataIn);
+			return;
+		}
+	}
+	else if (const auto SetProp = CastField<FSetProperty>(Property))
+	{
+		if (IsNativelySupportedSetType(SetProp))
+		{
+			RestoreSetProperty(SetProp, GetPropertyCodec(SetProp->ElementProp), ContainerPtr, StoredProperty, Encoding, Depth, DataIn);
+			return;
+		}
+	}
+	else if (const auto MProp = CastField<FMapProperty>(Property))
+	{
+		if (IsNativelySupportedMapType(MProp))
+		{
+			RestoreMapProperty(MProp, GetPropertyCodec(MProp->KeyProp), GetPropertyCodec(MProp->ValueProp), ContainerPtr, StoredProperty, Encoding, Depth, DataIn);
 			return;
 		}
 	}
 		
 	// Otherwise pass through general property util
-	RestoreContainerProperty(RootObject,Property, ContainerPtr, StoredProperty, RuntimeObjects, Meta, Depth, DataIn);
+	RestoreContainerProperty(RootObject,Property, GetPropertyCodec(Property), ContainerPtr, StoredProperty, Encoding, RuntimeObjects, Meta, Depth, DataIn);
+}
+
+void SpudPropertyUtil::RestoreProperty(UObject* RootObject, const FSpudPropertyPlanStep& Step, void* ContainerPtr,
+                                       const FSpudPropertyDef& StoredProperty,
+                                       const FSpudEncodingProfile& Encoding,
+                                       const RuntimeObjectMap* RuntimeObjects,
+                                       const FSpudClassMetadata& Meta,
+                                       int Depth,
+                                       FSpudMemoryReader& DataIn)
+{
+	// Same as above but type was resolved when the plan was built
+	if (Step.bIsNativeArray)
+		RestoreArrayProperty(RootObject, CastFieldChecked<FArrayProperty>(Step.Property), Step.Codec, ContainerPtr, StoredProperty, Encoding, RuntimeObjects, Meta, Depth, DataIn);
+	else if (Step.bIsNativeSet)
+		RestoreSetProperty(CastFieldChecked<FSetProperty>(Step.Property), Step.Codec, ContainerPtr, StoredProperty, Encoding, Depth, DataIn);
+	else if (Step.bIsNativeMap)
+		RestoreMapProperty(CastFieldChecked<FMapProperty>(Step.Property), Step.Codec, Step.ValueCodec, ContainerPtr, StoredProperty, Encoding, Depth, DataIn);
+	else
+		RestoreContainerProperty(RootObject, Step.Property, Step.Codec, ContainerPtr, StoredProperty, Encoding, RuntimeObjects, Meta, Depth, DataIn);
 }
 
 
 void SpudPropertyUtil::RestoreArrayProperty(UObject* RootObject, FArrayProperty* const AProp,
+                                                  ESpudPropertyCodec ElementCodec,
                                                   void* ContainerPtr, const FSpudPropertyDef& StoredProperty,
+                                                  const FSpudEncodingProfile& Encoding,
                                                   const RuntimeObjectMap* RuntimeObjects,
                                                   const FSpudClassMetadata& Meta,
                                                   int Depth,
                                                   FSpudMemoryReader& DataIn)
 {
 
-	// Array properties store the count as a uint16 first
-	uint16 NumElems;
-	DataIn << NumElems;
+	const bool bElementTypeMatches = ElementCodec != ESpudPropertyCodec::None &&
+		GetCodecFuncs(ElementCodec).DataType == (StoredProperty.DataType & ~(ESST_ArrayOf | ESST_VarCount));
+	// Bools are stored as uint8, so the runtime type is all we have to go on
+	const bool bBitPacked = bElementTypeMatches && Encoding.bCompact && ElementCodec == ESpudPropertyCodec::Bool;
+
+	// Array properties store the count first, variable length or a uint16 in older data
+	int32 NumElems;
+	if (StoredProperty.DataType & ESST_VarCount)
+	{
+		if (!ReadElementCount(AProp, NumElems, DataIn, bBitPacked ? 8 : 1))
+			return;
+	}
+	else
+	{
+		uint16 ShortElems;
+		DataIn << ShortElems;
+		NumElems = ShortElems;
+	}
 	
 	void* DataPtr = AProp->ContainerPtrToValuePtr<void>(ContainerPtr);
 	FScriptArrayHelper ArrayHelper(AProp, DataPtr);
 	ArrayHelper.Resize(NumElems);
 
+	if (bBitPacked)
+	{
+		const FBoolProperty* Inner = CastFieldChecked<FBoolProperty>(AProp->Inner);
+		uint8 Bits = 0;
+		for (int ArrayElem = 0; ArrayElem < NumElems; ++ArrayElem)
+		{
+			if ((ArrayElem & 7) == 0)
+				DataIn << Bits;
+			Inner->SetPropertyValue(ArrayHelper.GetRawPtr(ArrayElem), (Bits & (1 << (ArrayElem & 7))) != 0);
+		}
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = [%d bit-packed elements]"), *GetLogPrefix(AProp, Depth), NumElems);
+	}
+	else if (bElementTypeMatches && NumElems > 0 && CanBulkSerializeArray(ElementCodec, Encoding, DataIn))
+	{
+		// Stored bytes are identical to the in-memory elements, read them as one block
+		const int64 NumBytes = static_cast<int64>(NumElems) * AProp->Inner->GetElementSize();
+		DataIn.Serialize(ArrayHelper.GetRawPtr(0), NumBytes);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = [%d elements, %lld bytes]"), *GetLogPrefix(AProp, Depth), NumElems, NumBytes);
+	}
 	// After that, it's just like restoring a single property, just to a new location for each element
-	for (int ArrayElem = 0; ArrayElem < NumElems; ++ArrayElem)
+	else if (bElementTypeMatches)
+	{
+		// Element type resolved & matches what was stored, so each element is just one call
+		FProperty* Inner = AProp->Inner;
+		const FCodecReadFunc ReadFunc = GetCodecFuncs(ElementCodec, Encoding).Read;
+		for (int ArrayElem = 0; ArrayElem < NumElems; ++ArrayElem)
+		{
+			void* ElemPtr = Inner->ContainerPtrToValuePtr<void>(ArrayHelper.GetRawPtr(ArrayElem));
+			ReadFunc(Inner, ElemPtr, Depth, Encoding, DataIn);
+		}
+	}
+	else
 	{
-		void *ElemPtr = ArrayHelper.GetRawPtr(ArrayElem);
-		RestoreContainerProperty(RootObject, AProp->Inner, ElemPtr, StoredProperty, RuntimeObjects, Meta, Depth, DataIn);
+		for (int ArrayElem = 0; ArrayElem < NumElems; ++ArrayElem)
+		{
+			void *ElemPtr = ArrayHelper.GetRawPtr(ArrayElem);
+			RestoreContainerProperty(RootObject, AProp->Inner, ElementCodec, ElemPtr, StoredProperty, Encoding, RuntimeObjects, Meta, Depth, DataIn);
+		}
 	}
 	
 }
 
+bool SpudPropertyUtil::ReadElementCount(FProperty* Property, int32& OutCount, FArchive& In, int32 ElementsPerByte)
+{
+	const uint64 Count = ReadVarUInt(In);
+	// Every element takes at least a byte (or a bit), so a count larger than the remaining data is corrupt
+	if (In.IsError() || Count > static_cast<uint64>(In.TotalSize() - In.Tell()) * ElementsPerByte || Count > MAX_int32)
+	{
+		UE_LOG(LogSpudProps, Error, TEXT("Property %s has invalid element count %llu, skipping"), *Property->GetName(), Count);
+		In.SetError();
+		return false;
+	}
+	OutCount = static_cast<int32>(Count);
+	return true;
+}
+
+void SpudPropertyUtil::RestoreSetProperty(FSetProperty* const SProp, ESpudPropertyCodec ElementCodec,
+                                          void* ContainerPtr, const FSpudPropertyDef& StoredProperty,
+                                          const FSpudEncodingProfile& Encoding, int Depth,
+                                          FSpudMemoryReader& DataIn)
+{
+	// Elements are written without type info so we can't read anything else
+	if (!StoredPropertyTypeMatchesRuntime(SProp, StoredProperty, false))
+	{
+		UE_LOG(LogSpudProps, Error, TEXT("Unable to restore set property %s, stored element type has changed."), *SProp->GetName());
+		return;
+	}
+
+	int32 NumElems;
+	if (!ReadElementCount(SProp, NumElems, DataIn))
+		return;
+	UE_LOG(LogSpudProps, Verbose, TEXT("%s = [%d elements]"), *GetLogPrefix(SProp, Depth), NumElems);
+
+	void* DataPtr = SProp->ContainerPtrToValuePtr<void>(ContainerPtr);
+	FScriptSetHelper SetHelper(SProp, DataPtr);
+	SetHelper.EmptyElements(NumElems);
+
+	FProperty* ElementProp = SProp->ElementProp;
+	const FCodecReadFunc ReadFunc = GetCodecFuncs(ElementCodec, Encoding).Read;
+	for (int32 i = 0; i < NumElems; ++i)
+	{
+		const int32 Index = SetHelper.AddDefaultValue_Invalid_NeedsRehash();
+		ReadFunc(ElementProp, SetHelper.GetElementPtr(Index), Depth, Encoding, DataIn);
+	}
+	SetHelper.Rehash();
+}
+
+void SpudPropertyUtil::RestoreMapProperty(FMapProperty* const MProp, ESpudPropertyCodec KeyCodec,
+                                          ESpudPropertyCodec ValueCodec, void* ContainerPtr,
+                                          const FSpudPropertyDef& StoredProperty,
+                                          const FSpudEncodingProfile& Encoding, int Depth,
+                                          FSpudMemoryReader& DataIn)
+{
+	// Keys & values are written without type info so we can't read anything else
+	if (!StoredPropertyTypeMatchesRuntime(MProp, StoredProperty, false))
+	{
+		UE_LOG(LogSpudProps, Error, TEXT("Unable to restore map property %s, stored key or value type has changed."), *MProp->GetName());
+		return;
+	}
+
+	int32 NumPairs;
+	if (!ReadElementCount(MProp, NumPairs, DataIn))
+		return;
+	UE_LOG(LogSpudProps, Verbose, TEXT("%s = [%d pairs]"), *GetLogPrefix(MProp, Depth), NumPairs);
+
+	void* DataPtr = MProp->ContainerPtrToValuePtr<void>(ContainerPtr);
+	FScriptMapHelper MapHelper(MProp, DataPtr);
+	MapHelper.EmptyValues(NumPairs);
+
+	// All keys, then all values
+	TArray<int32, TInlineAllocator<64>> Indexes;
+	Indexes.Reserve(NumPairs);
+	FProperty* KeyProp = MProp->KeyProp;
+	const FCodecReadFunc KeyReadFunc = GetCodecFuncs(KeyCodec, Encoding).Read;
+	for (int32 i = 0; i < NumPairs; ++i)
+	{
+		const int32 Index = MapHelper.AddDefaultValue_Invalid_NeedsRehash();
+		KeyReadFunc(KeyProp, MapHelper.GetKeyPtr(Index), Depth, Encoding, DataIn);
+		Indexes.Add(Index);
+	}
+	FProperty* ValueProp = MProp->ValueProp;
+	const FCodecReadFunc ValueReadFunc = GetCodecFuncs(ValueCodec, Encoding).Read;
+	for (const int32 Index : Indexes)
+	{
+		ValueReadFunc(ValueProp, MapHelper.GetValuePtr(Index), Depth, Encoding, DataIn);
+	}
+	MapHelper.Rehash();
+}
+
 void SpudPropertyUtil::RestoreContainerProperty(UObject* RootObject, FProperty* const Property,
+                                                      ESpudPropertyCodec Codec,
                                                       void* ContainerPtr, const FSpudPropertyDef& StoredProperty,
+                                                      const FSpudEncodingProfile& Encoding,
                                                       const RuntimeObjectMap* RuntimeObjects,
                                                       const FSpudClassMetadata& Meta,
                                                       int Depth,
@@ -1096,69 +1895,48 @@ void SpudPropertyUtil::RestoreContainerProperty(UObject* RootObject, FProperty*
 {
 	bool bUpdateOK;
 
-	if (IsPropertyNativelySupported(Property))
+	if (Codec != ESpudPropertyCodec::None)
+	{
+		// Primitives & builtin structs, type already resolved but must match what was stored
+		// We ignore the array flags since we could be processing inner
+		const FCodecFuncs& Funcs = GetCodecFuncs(Codec, Encoding);
+		bUpdateOK = Funcs.DataType == (StoredProperty.DataType & ~(ESST_ArrayOf | ESST_VarCount));
+		if (bUpdateOK)
+		{
+			void* DataPtr = Property->ContainerPtrToValuePtr<void>(ContainerPtr);
+			Funcs.Read(Property, DataPtr, Depth, Encoding, DataIn);
+		}
+	}
+	else if (IsPropertyNativelySupported(Property))
 	{
 		// Get pointer to data within container, must be from original property in the case of arrays
 		void* DataPtr = Property->ContainerPtrToValuePtr<void>(ContainerPtr);
-		if (const auto SProp = CastField<FStructProperty>(Property))
+		// Builtin structs & primitives have a codec, so this is a custom struct or UObject
+		if (CastField<FStructProperty>(Property))
 		{
-			if (IsBuiltInStructProperty(SProp))
-			{
-				// Builtin structs
-				bUpdateOK =
-					TryReadBuiltinStructPropertyData<FVector>(SProp, DataPtr, StoredProperty, Depth, DataIn) ||
-					TryReadBuiltinStructPropertyData<FRotator>(SProp, DataPtr, StoredProperty, Depth, DataIn) ||
-					TryReadBuiltinStructPropertyData<FTransform>(SProp, DataPtr, StoredProperty, Depth, DataIn) ||
-					TryReadBuiltinStructPropertyData<FGuid>(SProp, DataPtr, StoredProperty, Depth, DataIn);
-			}
-			else
-			{
-				// We assume that nested custom structs are ok
-				// We don't cascade here any more, visitor does it
-				bUpdateOK = true;
-			}
+			// We assume that nested custom structs are ok
+			// We don't cascade here any more, visitor does it
+			bUpdateOK = true;
 		}
 		else 
 		{
-			bUpdateOK =
-				TryReadPropertyData<FBoolProperty,		bool>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FByteProperty,		uint8>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FUInt16Property,	uint16>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FUInt32Property,	uint32>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FUInt64Property,	uint64>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FInt8Property,		int8>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FInt16Property,	int16>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FIntProperty,		int>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FInt64Property,	int64>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FFloatProperty,	float>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FDoubleProperty,	double>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FStrProperty,		FString>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FNameProperty,		FName>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadPropertyData<FTextProperty,		FText>(Property, DataPtr, StoredProperty, Depth, DataIn) ||
-				TryReadEnumPropertyData(Property, DataPtr, StoredProperty, Depth, DataIn);
-
-			if (!bUpdateOK)
+			// Actors can refer to each other
+			ULevel* Level = nullptr;
+			if (auto Actor = Cast<AActor>(RootObject))
 			{
-				// Actors can refer to each other
-			
-				ULevel* Level = nullptr;
-				if (auto Actor = Cast<AActor>(RootObject))
-				{
-					Level = Actor->GetLevel();
-				}
-				if (!IsValid(Level))
+				Level = Actor->GetLevel();
+			}
+			if (!IsValid(Level))
+			{
+				if (UActorComponent* ActorComponentLevelCheck = Cast<UActorComponent>(RootObject))
 				{
-					if (UActorComponent* ActorComponentLevelCheck = Cast<UActorComponent>(RootObject))
+					if (IsValid(ActorComponentLevelCheck->GetOwner()->GetLevel()))
 					{
-						if (IsValid(ActorComponentLevelCheck->GetOwner()->GetLevel()))
-						{
-							Level = ActorComponentLevelCheck->GetOwner()->GetLevel();
-						}
+						Level = ActorComponentLevelCheck->GetOwner()->GetLevel();
 					}
 				}
-				bUpdateOK = TryReadUObjectPropertyData(Property, DataPtr, StoredProperty, RuntimeObjects, Level, RootObject, Meta, Depth, DataIn);
 			}
-		
+			bUpdateOK = TryReadUObjectPropertyData(Property, DataPtr, StoredProperty, RuntimeObjects, Level, RootObject, Meta, Encoding, Depth, DataIn);
 		}
 	}
 	else
@@ -1197,8 +1975,9 @@ bool SpudPropertyUtil::StoredClassDefMatchesRuntime(const FSpudClassDef& ClassDe
 
 bool SpudPropertyUtil::StoredPropertyTypeMatchesRuntime(const FProperty* RuntimeProperty, const FSpudPropertyDef& StoredProperty, bool bIgnoreArrayFlag)
 {
-	uint16 StoredType = StoredProperty.DataType;
-	uint16 RuntimeType = GetPropertyDataType(RuntimeProperty);
+	// Count encoding doesn't change the type, older data may have 16-bit counts
+	uint16 StoredType = StoredProperty.DataType & ~ESST_VarCount;
+	uint16 RuntimeType = GetPropertyDataType(RuntimeProperty) & ~ESST_VarCount;
 	if (bIgnoreArrayFlag)
 	{
 		StoredType = StoredType & ~ESST_ArrayOf;
@@ -1309,6 +2088,155 @@ bool SpudPropertyUtil::IsRuntimeActor(const AActor* Actor)
 	return Ret;
 }
 
+void SpudPropertyUtil::WriteVarUInt(uint64 Value, FArchive& Out)
+{
+	// 7 bits at a time, low bits first, top bit set if more bytes follow
+	uint8 Bytes[10];
+	int NumBytes = 0;
+	do
+	{
+		uint8 Byte = static_cast<uint8>(Value & 0x7F);
+		Value >>= 7;
+		if (Value)
+			Byte |= 0x80;
+		Bytes[NumBytes++] = Byte;
+	} while (Value);
+
+	Out.Serialize(Bytes, NumBytes);
+}
+
+uint64 SpudPropertyUtil::ReadVarUInt(FArchive& In)
+{
+	uint64 Value = 0;
+	// 64 bits need at most 10 bytes
+	for (int Shift = 0; Shift < 64; Shift += 7)
+	{
+		uint8 Byte = 0;
+		In << Byte;
+		if (In.IsError())
+			return 0;
+
+		Value |= static_cast<uint64>(Byte & 0x7F) << Shift;
+		if (!(Byte & 0x80))
+			return Value;
+	}
+
+	// Continuation bit set on the 10th byte, can't be valid
+	In.SetError();
+	return 0;
+}
+
+void SpudPropertyUtil::WriteVarInt(int64 Value, FArchive& Out)
+{
+	// Zig-zag: 0, -1, 1, -2, 2... so the sign doesn't cost us the top bit
+	WriteVarUInt((static_cast<uint64>(Value) << 1) ^ static_cast<uint64>(Value >> 63), Out);
+}
+
+int64 SpudPropertyUtil::ReadVarInt(FArchive& In)
+{
+	const uint64 Encoded = ReadVarUInt(In);
+	return static_cast<int64>(Encoded >> 1) ^ -static_cast<int64>(Encoded & 1);
+}
+
+void SpudPropertyUtil::WriteQuantized(double Value, float Quantum, FArchive& Out)
+{
+	if (Quantum > 0)
+	{
+		// Clamp so that NaN / huge values can't overflow, they're not restorable at this precision anyway
+		constexpr double MaxSteps = static_cast<double>(MAX_int64 >> 1);
+		const double Steps = FMath::RoundToDouble(Value / Quantum);
+		WriteVarInt(static_cast<int64>(FMath::IsFinite(Steps) ? FMath::Clamp(Steps, -MaxSteps, MaxSteps) : 0), Out);
+	}
+	else
+	{
+		Out << Value;
+	}
+}
+
+double SpudPropertyUtil::ReadQuantized(float Quantum, FArchive& In)
+{
+	if (Quantum > 0)
+		return static_cast<double>(ReadVarInt(In)) * Quantum;
+
+	double Value;
+	In << Value;
+	return Value;
+}
+
+void SpudPropertyUtil::WriteQuantized(const FVector& Value, float Quantum, FArchive& Out)
+{
+	WriteQuantized(Value.X, Quantum, Out);
+	WriteQuantized(Value.Y, Quantum, Out);
+	WriteQuantized(Value.Z, Quantum, Out);
+}
+
+void SpudPropertyUtil::ReadQuantized(FVector& Value, float Quantum, FArchive& In)
+{
+	Value.X = ReadQuantized(Quantum, In);
+	Value.Y = ReadQuantized(Quantum, In);
+	Value.Z = ReadQuantized(Quantum, In);
+}
+
+void SpudPropertyUtil::WriteQuantized(const FVector& Value, const FSpudEncodingProfile& Encoding, FArchive& Out)
+{
+	WriteQuantized(Value, Encoding.PositionQuantum, Out);
+}
+
+void SpudPropertyUtil::ReadQuantized(FVector& Value, const FSpudEncodingProfile& Encoding, FArchive& In)
+{
+	ReadQuantized(Value, Encoding.PositionQuantum, In);
+}
+
+void SpudPropertyUtil::WriteQuantized(const FRotator& Value, const FSpudEncodingProfile& Encoding, FArchive& Out)
+{
+	WriteQuantized(Value.Pitch, Encoding.RotationQuantum, Out);
+	WriteQuantized(Value.Yaw, Encoding.RotationQuantum, Out);
+	WriteQuantized(Value.Roll, Encoding.RotationQuantum, Out);
+}
+
+void SpudPropertyUtil::ReadQuantized(FRotator& Value, const FSpudEncodingProfile& Encoding, FArchive& In)
+{
+	Value.Pitch = ReadQuantized(Encoding.RotationQuantum, In);
+	Value.Yaw = ReadQuantized(Encoding.RotationQuantum, In);
+	Value.Roll = ReadQuantized(Encoding.RotationQuantum, In);
+}
+
+void SpudPropertyUtil::WriteQuantized(const FTransform& Value, const FSpudEncodingProfile& Encoding, FArchive& Out)
+{
+	WriteQuantized(Value.GetTranslation(), Encoding.PositionQuantum, Out);
+	if (Encoding.RotationQuantum > 0)
+	{
+		WriteQuantized(Value.Rotator(), Encoding, Out);
+	}
+	else
+	{
+		FQuat Rotation = Value.GetRotation();
+		Out << Rotation;
+	}
+	WriteQuantized(Value.GetScale3D(), Encoding.ScaleQuantum, Out);
+}
+
+void SpudPropertyUtil::ReadQuantized(FTransform& Value, const FSpudEncodingProfile& Encoding, FArchive& In)
+{
+	FVector Translation, Scale;
+	ReadQuantized(Translation, Encoding.PositionQuantum, In);
+	if (Encoding.RotationQuantum > 0)
+	{
+		FRotator Rotation;
+		ReadQuantized(Rotation, Encoding, In);
+		Value.SetRotation(Rotation.Quaternion());
+	}
+	else
+	{
+		FQuat Rotation;
+		In << Rotation;
+		Value.SetRotation(Rotation);
+	}
+	ReadQuantized(Scale, Encoding.ScaleQuantum, In);
+	Value.SetTranslation(Translation);
+	Value.SetScale3D(Scale);
+}
+
 bool SpudPropertyUtil::IsPersistentObject(UObject* Obj)
 {
 	return IsValid(Obj) && Obj->Implements<USpudObject>() && !ISpudObject::Execute_ShouldSkip(Obj);
@@ -1374,6 +2302,18 @@ FString SpudPropertyUtil::GetLevelActorName(const AActor* Actor)
 	return Actor->GetFName().ToString();
 }
 
+FName SpudPropertyUtil::GetLevelActorKey(const AActor* Actor)
+{
+	if (Actor->Implements<USpudObject>())
+	{
+		const FString Name = ISpudObject::Execute_OverrideName(Actor);
+		if (!Name.IsEmpty())
+			return FName(*Name);
+	}
+
+	return Actor->GetFName();
+}
+
 FString SpudPropertyUtil::GetGlobalObjectID(const UObject* Obj)
 {
 	const auto Guid = SpudPropertyUtil::GetGuidProperty(Obj);
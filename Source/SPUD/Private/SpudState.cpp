@@ -12,9 +12,23 @@
 #include "../Public/SpudMemoryReaderWriter.h"
 #include "GameFramework/PlayerState.h"
 #include "WorldPartition/WorldPartitionRuntimeCell.h"
+#include "Misc/ScopeRWLock.h"
+#include "Algo/StableSort.h"
 
 DEFINE_LOG_CATEGORY(LogSpudState)
 
+bool GSpudStoreArchetypeDeltas = false;
+bool GSpudIncrementalLevelStore = false;
+
+/// Flags in compact (V2) core actor data
+enum ESpudCoreActorDataFlags : uint8
+{
+	ESCAF_Hidden = 0x01,
+	ESCAF_HasVelocity = 0x02,
+	ESCAF_HasAngularVelocity = 0x04,
+	ESCAF_HasControlRotation = 0x08
+};
+
 USpudState::USpudState()
 {
 	// In case game crashed etc, remove all garbage active level files at construction too
@@ -25,6 +39,40 @@ void USpudState::ResetState()
 {
 	RemoveAllActiveGameLevelFiles();
 	SaveData.Reset();
+	DirtyGenerations.Empty();
+	CancelIncrementalRestores();
+}
+
+void USpudState::MarkObjectDirty(const UObject* Obj)
+{
+	uint32& Generation = DirtyGenerations.FindOrAdd(FObjectKey(Obj), 1);
+	// 0 is reserved for unknown
+	if (++Generation == 0)
+		Generation = 1;
+}
+
+uint32 USpudState::GetDirtyGeneration(const UObject* Obj) const
+{
+	const uint32* Generation = DirtyGenerations.Find(FObjectKey(Obj));
+	return Generation ? *Generation : 1;
+}
+
+void USpudState::ForgetDirtyGenerations(const TArray<AActor*>& Actors)
+{
+	if (DirtyGenerations.Num() == 0)
+		return;
+
+	for (auto Actor : Actors)
+		DirtyGenerations.Remove(FObjectKey(Actor));
+}
+
+void USpudState::PruneDirtyGenerations()
+{
+	for (auto It = DirtyGenerations.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().ResolveObjectPtr())
+			It.RemoveCurrent();
+	}
 }
 
 void USpudState::StoreWorldGlobals(UWorld* World)
@@ -43,6 +91,7 @@ void USpudState::StoreWorldGlobals(UWorld* World)
 void USpudState::StoreLevel(ULevel* Level, bool bReleaseAfter, bool bBlocking)
 {
 	const FString LevelName = GetLevelName(Level);
+	FinishIncrementalRestoreBeforeStore(LevelName);
 	auto LevelData = GetLevelData(LevelName, true);
 
 	if (LevelData.IsValid())
@@ -50,19 +99,47 @@ void USpudState::StoreLevel(ULevel* Level, bool bReleaseAfter, bool bBlocking)
 		// Mutex lock the level (load and unload events on streaming can be in loading threads)
 		FScopeLock LevelLock(&LevelData->Mutex);
 
-		// Clear any existing data for levels being updated from
-		// Which is either the specific level, or all loaded levels
-		if (LevelData)
-			LevelData->PreStoreWorld();
-
+		// Persistent actors are picked out once, checking their stored class defs along the way
+		// Incremental stores keep existing records, which is fine so long as the class defs describe the runtime
+		// classes. If they came from older data they don't, and a full store is needed to get back to the fast
+		// restore path. Records which aren't re-encoded must also stay tagged with the version they were written with
+		bool bIncremental = GSpudIncrementalLevelStore && !LevelData->Metadata.IsUserDataModelOutdated();
+		TSet<const UClass*> CheckedClasses;
+		TArray<AActor*> PersistentActors;
+		PersistentActors.Reserve(Level->Actors.Num());
 		for (auto Actor : Level->Actors)
 		{
 			if (SpudPropertyUtil::IsPersistentObject(Actor))
 			{
-				StoreActor(Actor, LevelData);
+				if (bIncremental && !IsStoredClassDefCurrent(Actor, LevelData, CheckedClasses))
+					bIncremental = false;
+				PersistentActors.Add(Actor);
 			}
 		}
 
+		// Clear any existing data for levels being updated from
+		// Which is either the specific level, or all loaded levels
+		// Incremental stores keep it instead, and only replace the records of actors which changed
+		if (bIncremental)
+			LevelData->PreIncrementalStoreWorld();
+		else
+			LevelData->PreStoreWorld();
+
+		for (auto Actor : PersistentActors)
+		{
+			// Clean actors can only be skipped if their existing records were kept
+			StoreActor(Actor, LevelData, bIncremental);
+		}
+
+		if (bIncremental)
+			LevelData->PostIncrementalStoreWorld();
+
+		// The actors are going away with the level, a reload creates new ones.
+		// Also forget anything else which has gone, e.g. destroyed runtime actors
+		if (bReleaseAfter)
+			ForgetDirtyGenerations(PersistentActors);
+		PruneDirtyGenerations();
+
 		// ReSharper disable once CppExpressionWithoutSideEffects
 		OnLevelStore.ExecuteIfBound(LevelName);
 	}
@@ -71,15 +148,37 @@ void USpudState::StoreLevel(ULevel* Level, bool bReleaseAfter, bool bBlocking)
 		ReleaseLevelData(LevelName, bBlocking);
 }
 
+bool USpudState::IsStoredClassDefCurrent(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData,
+                                         TSet<const UClass*>& CheckedClasses) const
+{
+	bool bAlreadyChecked;
+	CheckedClasses.Add(Actor->GetClass(), &bAlreadyChecked);
+	if (bAlreadyChecked)
+		return true;
+
+	const FSpudClassMetadata& Meta = LevelData->Metadata;
+	const auto ClassDef = Meta.GetClassDef(SpudPropertyUtil::GetClassName(Actor));
+	if (ClassDef && !ClassDef->MatchesRuntimeClass(Actor->GetClass(), Meta))
+	{
+		UE_LOG(LogSpudState, Verbose, TEXT("Stored class %s in level %s is out of date, storing level in full"),
+			*ClassDef->ClassName, *LevelData->Name);
+		return false;
+	}
+	return true;
+}
+
 USpudState::StorePropertyVisitor::StorePropertyVisitor(
 	USpudState* Parent,
 	TSharedPtr<FSpudClassDef> InClassDef, TArray<uint32>& InPropertyOffsets,
-	FSpudClassMetadata& InMeta, FSpudMemoryWriter& InOut):
+	FSpudClassMetadata& InMeta, FSpudMemoryWriter& InOut,
+	const UObject* InArchetype, TBitArray<>* InPresentProperties):
 	ParentState(Parent),
 	ClassDef(InClassDef),
 	PropertyOffsets(InPropertyOffsets),
 	Meta(InMeta),
-	Out(InOut)
+	Out(InOut),
+	Archetype(InArchetype),
+	PresentProperties(InPresentProperties)
 {
 }
 
@@ -94,6 +193,32 @@ bool USpudState::StorePropertyVisitor::VisitProperty(UObject* RootObject, FPrope
 	return true;
 }
 
+bool USpudState::StorePropertyVisitor::VisitPlannedProperty(UObject* RootObject, const FSpudPropertyPlanStep& Step,
+                                                            uint32 CurrentPrefixID, void* ContainerPtr, int Depth)
+{
+	if (PresentProperties && SpudPropertyUtil::CanStoreAsArchetypeDelta(Step))
+	{
+		const void* ArchetypeContainerPtr = SpudPropertyUtil::GetEquivalentContainerPtr(RootObject, ContainerPtr, Archetype);
+		if (ArchetypeContainerPtr && Step.Property->Identical_InContainer(ContainerPtr, ArchetypeContainerPtr))
+		{
+			const int Index = SpudPropertyUtil::RegisterUnchangedProperty(Step.Property, CurrentPrefixID, ClassDef, PropertyOffsets, Meta, Out);
+			if (PresentProperties->Num() < Index + 1)
+				PresentProperties->Add(true, Index + 1 - PresentProperties->Num());
+			(*PresentProperties)[Index] = false;
+			UE_LOG(LogSpudProps, Verbose, TEXT("%s = (unchanged from archetype)"), *SpudPropertyUtil::GetLogPrefix(Step.Property, Depth));
+			return true;
+		}
+	}
+
+	SpudPropertyUtil::StoreProperty(RootObject, Step, CurrentPrefixID, ContainerPtr, Depth, ClassDef, PropertyOffsets, Meta, Out);
+
+	// Plan already knows whether this can cascade, skip re-testing every other property
+	if (Step.bIsNestedUObject)
+		StoreNestedUObjectIfNeeded(RootObject, Step.Property, CurrentPrefixID, ContainerPtr, Depth);
+
+	return true;
+}
+
 
 void USpudState::StorePropertyVisitor::StoreNestedUObjectIfNeeded(UObject* RootObject, FProperty* Property,
 	uint32 CurrentPrefixID, void* ContainerPtr, int Depth)
@@ -122,6 +247,7 @@ void USpudState::StorePropertyVisitor::StoreNestedUObjectIfNeeded(UObject* RootO
 					UE_LOG(LogSpudState, Verbose, TEXT("Storing asset link for %s: %s"), *Property->GetNameCPP(), *Obj->GetName());
 
 					SpudPropertyUtil::WriteRaw(Path, Out);
+					Meta.AssetPathIndex.FindOrAddIndex(Path.ToString());
 				}
 				else
 				{
@@ -173,15 +299,17 @@ uint32 USpudState::StorePropertyVisitor::GetNestedPrefix(
 }
 
 
-void USpudState::WriteCoreActorData(AActor* Actor, FArchive& Out) const
+void USpudState::WriteCoreActorData(AActor* Actor, const FSpudEncodingProfile& Encoding, FArchive& Out) const
 {
 	// Save core information which isn't in properties
 	// We write this as packed data
 
 	// Version: this needs to be incremented if any changes
+	// Version 2 is the compact encoding, it's only written when the actor's class def uses it
 	constexpr uint16 CoreDataVersion = 1;
+	constexpr uint16 CompactCoreDataVersion = 2;
 
-	// Current Format:
+	// V1 Format:
 	// - Version (uint16)
 	// - Hidden (bool)
 	// - Transform (FTransform)
@@ -189,13 +317,16 @@ void USpudState::WriteCoreActorData(AActor* Actor, FArchive& Out) const
 	// - AngularVelocity (FVector)
 	// - Control rotation (FRotator) (non-zero for Pawns only)
 
-	// We could omit some of this data for non-movables but it's simpler to include for all
+	// V2 Format:
+	// - Version (uint16)
+	// - Flags (uint8, ESpudCoreActorDataFlags)
+	// - Transform (quantized)
+	// - Velocity (quantized, only if flagged)
+	// - AngularVelocity (quantized, only if flagged)
+	// - Control rotation (quantized, only if flagged)
 
-	SpudPropertyUtil::WriteRaw(CoreDataVersion, Out);
+	// We could omit some of this data for non-movables but it's simpler to include for all
 
-	SpudPropertyUtil::WriteRaw(Actor->IsHidden(), Out);
-	SpudPropertyUtil::WriteRaw(Actor->GetTransform(), Out);
-	
 	FVector Velocity = FVector::ZeroVector;
 	FVector AngularVelocity = FVector::ZeroVector;
 	FRotator ControlRotation = FRotator::ZeroRotator;
@@ -220,9 +351,40 @@ void USpudState::WriteCoreActorData(AActor* Actor, FArchive& Out) const
 	{
 		ControlRotation = Pawn->GetControlRotation();
 	}
-	SpudPropertyUtil::WriteRaw(Velocity, Out);
-	SpudPropertyUtil::WriteRaw(AngularVelocity, Out);
-	SpudPropertyUtil::WriteRaw(ControlRotation, Out);
+
+	if (Encoding.bCompact)
+	{
+		SpudPropertyUtil::WriteRaw(CompactCoreDataVersion, Out);
+
+		uint8 Flags = 0;
+		if (Actor->IsHidden())
+			Flags |= ESCAF_Hidden;
+		if (!Velocity.IsZero())
+			Flags |= ESCAF_HasVelocity;
+		if (!AngularVelocity.IsZero())
+			Flags |= ESCAF_HasAngularVelocity;
+		if (!ControlRotation.IsZero())
+			Flags |= ESCAF_HasControlRotation;
+		Out << Flags;
+
+		SpudPropertyUtil::WriteQuantized(Actor->GetTransform(), Encoding, Out);
+		if (Flags & ESCAF_HasVelocity)
+			SpudPropertyUtil::WriteQuantized(Velocity, Encoding.PositionQuantum, Out);
+		if (Flags & ESCAF_HasAngularVelocity)
+			SpudPropertyUtil::WriteQuantized(AngularVelocity, Encoding.RotationQuantum, Out);
+		if (Flags & ESCAF_HasControlRotation)
+			SpudPropertyUtil::WriteQuantized(ControlRotation, Encoding, Out);
+	}
+	else
+	{
+		SpudPropertyUtil::WriteRaw(CoreDataVersion, Out);
+
+		SpudPropertyUtil::WriteRaw(Actor->IsHidden(), Out);
+		SpudPropertyUtil::WriteRaw(Actor->GetTransform(), Out);
+		SpudPropertyUtil::WriteRaw(Velocity, Out);
+		SpudPropertyUtil::WriteRaw(AngularVelocity, Out);
+		SpudPropertyUtil::WriteRaw(ControlRotation, Out);
+	}
 
 }
 
@@ -284,13 +446,13 @@ void USpudState::ReleaseAllLevelData()
 FSpudNamedObjectData* USpudState::GetLevelActorData(const AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData, bool AutoCreate)
 {
 	// FNames are constant within a level
-	const auto Name = SpudPropertyUtil::GetLevelActorName(Actor);
-	FSpudNamedObjectData* Ret = LevelData->LevelActors.Contents.Find(Name);
+	const FName Key = SpudPropertyUtil::GetLevelActorKey(Actor);
+	FSpudNamedObjectData* Ret = LevelData->LevelActors.Contents.Find(Key);
 
 	if (!Ret && AutoCreate)
 	{
-		Ret = &LevelData->LevelActors.Contents.Add(Name);
-		Ret->Name = Name;
+		Ret = &LevelData->LevelActors.Contents.Add(Key);
+		Ret->Name = SpudPropertyUtil::GetLevelActorName(Actor);
 		Ret->ClassID = LevelData->Metadata.FindOrAddClassIDFromName(SpudPropertyUtil::GetClassName(Actor));
 	}
 	
@@ -323,11 +485,10 @@ FSpudSpawnedActorData* USpudState::GetSpawnedActorData(AActor* Actor, FSpudSaveD
 		return nullptr;			
 	}
 	
-	const auto GuidStr = Guid.ToString(SPUDDATA_GUID_KEY_FORMAT);
-	FSpudSpawnedActorData* Ret = LevelData->SpawnedActors.Contents.Find(GuidStr);
+	FSpudSpawnedActorData* Ret = LevelData->SpawnedActors.Contents.Find(Guid);
 	if (!Ret && AutoCreate)
 	{
-		Ret = &LevelData->SpawnedActors.Contents.Emplace(GuidStr);
+		Ret = &LevelData->SpawnedActors.Contents.Emplace(Guid);
 		Ret->Guid = Guid;
 		const FString ClassName = SpudPropertyUtil::GetClassName(Actor); 
 		Ret->ClassID = LevelData->Metadata.FindOrAddClassIDFromName(ClassName);
@@ -342,6 +503,7 @@ void USpudState::StoreActor(AActor* Actor)
 		return;
 
 	const FString LevelName = GetLevelNameForActor(Actor);
+	FinishIncrementalRestoreBeforeStore(LevelName);
 
 	auto LevelData = GetLevelData(LevelName, true);
 	StoreActor(Actor, LevelData);
@@ -353,33 +515,46 @@ void USpudState::StoreActor(AActor* Actor, const FString& CellName)
 	if (Actor->HasAnyFlags(RF_ClassDefaultObject|RF_ArchetypeObject|RF_BeginDestroyed))
 		return;
 
+	FinishIncrementalRestoreBeforeStore(CellName);
 	const auto LevelData = GetLevelData(CellName, true);
 	StoreActor(Actor, LevelData);
 }
 
 void USpudState::StoreLevelActorDestroyed(AActor* Actor)
 {
+	// Being destroyed by a level restore because it's already recorded as destroyed
+	if (bDestroyingRestoredActors)
+		return;
+
 	const FString LevelName = GetLevelNameForActor(Actor);
 
 	auto LevelData = GetLevelData(LevelName, true);
 	StoreLevelActorDestroyed(Actor, LevelData);
+	DirtyGenerations.Remove(FObjectKey(Actor));
 }
 
 FSpudNamedObjectData* USpudState::GetGlobalObjectData(const UObject* Obj, bool AutoCreate)
 {
 	// Get the identifier; prefer GUID if present, if not just use name
-	const FString ID = SpudPropertyUtil::GetGlobalObjectID(Obj);
+	const FGuid Guid = SpudPropertyUtil::GetGuidProperty(Obj);
+	if (Guid.IsValid())
+		return GetGlobalObjectData(Guid.ToString(SPUDDATA_GUID_KEY_FORMAT), AutoCreate);
 
-	return GetGlobalObjectData(ID, AutoCreate);
+	return GetGlobalObjectData(Obj->GetFName(), AutoCreate);
 }
 
 FSpudNamedObjectData* USpudState::GetGlobalObjectData(const FString& ID, bool AutoCreate)
 {
-	FSpudNamedObjectData* Ret = SaveData.GlobalData.Objects.Contents.Find(ID);
+	return GetGlobalObjectData(FName(*ID), AutoCreate);
+}
+
+FSpudNamedObjectData* USpudState::GetGlobalObjectData(FName Key, bool AutoCreate)
+{
+	FSpudNamedObjectData* Ret = SaveData.GlobalData.Objects.Contents.Find(Key);
 	if (!Ret && AutoCreate)
 	{
-		Ret = &SaveData.GlobalData.Objects.Contents.Add(ID);
-		Ret->Name = ID;
+		Ret = &SaveData.GlobalData.Objects.Contents.Add(Key);
+		Ret->Name = Key.ToString();
 	}
 
 	return Ret;
@@ -436,23 +611,36 @@ void USpudState::StoreGlobalObject(UObject* Obj, FSpudNamedObjectData* Data)
 void USpudState::StoreObjectProperties(UObject* Obj, FSpudPropertyData& Properties, FSpudClassMetadata& Meta, int StartDepth)
 {
 	auto& PropOffsets = Properties.PropertyOffsets;
+	PropOffsets.Reset();
 		
 	auto& PropData = Properties.Data;
-	PropData.Empty();
+	PropData.Reset();
 	FSpudMemoryWriter PropertyWriter(PropData);
 
-	StoreObjectProperties(Obj, SPUDDATA_PREFIXID_NONE, PropOffsets, Meta, PropertyWriter, StartDepth);	
+	auto& Present = Properties.PresentProperties;
+	Present.Empty();
+	StoreObjectProperties(Obj, SPUDDATA_PREFIXID_NONE, PropOffsets, Meta, PropertyWriter, StartDepth,
+		GSpudStoreArchetypeDeltas ? &Present : nullptr);
+
+	// Bits were only added up to the last unchanged property, the rest are present
+	if (Present.Num() > 0 && Present.Num() < PropOffsets.Num())
+		Present.Add(true, PropOffsets.Num() - Present.Num());
 }
 
 
 void USpudState::StoreObjectProperties(UObject* Obj, uint32 PrefixID, TArray<uint32>& PropOffsets,
-	FSpudClassMetadata& Meta, FSpudMemoryWriter& Out, int StartDepth)
+	FSpudClassMetadata& Meta, FSpudMemoryWriter& Out, int StartDepth, TBitArray<>* OutPresentProperties)
 {
 	const FString& ClassName = SpudPropertyUtil::GetClassName(Obj);
 	auto ClassDef = Meta.FindOrAddClassDef(ClassName);
 
+	// Delta against the archetype (CDO, or template for e.g. child actors)
+	const UObject* Archetype = OutPresentProperties ? Obj->GetArchetype() : nullptr;
+	if (!Archetype)
+		OutPresentProperties = nullptr;
+
 	// visit all properties and write out
-	StorePropertyVisitor Visitor(this, ClassDef, PropOffsets, Meta, Out);
+	StorePropertyVisitor Visitor(this, ClassDef, PropOffsets, Meta, Out, Archetype, OutPresentProperties);
 	SpudPropertyUtil::VisitPersistentProperties(Obj, Visitor, StartDepth);
 }
 void USpudState::RestoreLevel(UWorld* World, const FString& LevelName)
@@ -475,74 +663,246 @@ void USpudState::RestoreLevel(UWorld* World, const FString& LevelName)
 }
 
 void USpudState::RestoreLevel(ULevel* Level)
+{
+	// Run the whole restore now, in the same order as an incremental one
+	if (auto Restore = CreateLevelRestore(Level, TOptional<FVector>()))
+		StepLevelRestore(*Restore, DBL_MAX);
+}
+
+TSharedPtr<FSpudLevelRestore> USpudState::CreateLevelRestore(ULevel* Level, const TOptional<FVector>& ViewLocation)
 {
 	if (!IsValid(Level))
-		return;
+		return nullptr;
 	
 	FString LevelName = GetLevelName(Level);
+	// Any restore of this level already in progress is superseded
+	IncrementalRestores.RemoveAll([&LevelName](const TSharedPtr<FSpudLevelRestore>& Restore)
+	{
+		return Restore->LevelName == LevelName;
+	});
+
 	auto LevelData = GetLevelData(LevelName, false);
 
 	if (!LevelData.IsValid())
 	{
 		UE_LOG(LogSpudState, Log, TEXT("Skipping restore level %s, no data (this may be fine)"), *LevelName);
-		return;
+		return nullptr;
+	}
+
+	auto Restore = MakeShared<FSpudLevelRestore>();
+	Restore->Level = Level;
+	Restore->LevelName = LevelName;
+	Restore->LevelData = LevelData;
+	Restore->ViewLocation = ViewLocation;
+	{
+		FScopeLock LevelLock(&LevelData->Mutex);
+		LevelData->SpawnedActors.Contents.GenerateKeyArray(Restore->ActorsToRespawn);
 	}
 
+	UE_LOG(LogSpudState, Verbose, TEXT("RESTORE level %s - Start"), *LevelName);
+	return Restore;
+}
+
+ESpudLevelRestoreProgress USpudState::StepLevelRestore(FSpudLevelRestore& Restore, double EndTime)
+{
+	const FString& LevelName = Restore.LevelName;
+	auto& LevelData = Restore.LevelData;
+	auto& RuntimeObjects = Restore.RuntimeObjects;
+
 	// Mutex lock the level (load and unload events on streaming can be in loading threads)
 	FScopeLock LevelLock(&LevelData->Mutex);
-	
-	UE_LOG(LogSpudState, Verbose, TEXT("RESTORE level %s - Start"), *LevelName);
-	TMap<FGuid, UObject*> RuntimeObjectsByGuid;
+
+	ULevel* Level = Restore.Level.Get();
+	if (!IsValid(Level) || LevelData->Status == LDS_Unloaded)
+	{
+		UE_LOG(LogSpudState, Warning, TEXT("RESTORE level %s - Abandoned, level or its data is no longer loaded"), *LevelName);
+		return ESpudLevelRestoreProgress::Abandoned;
+	}
+
+	// Always make some progress, however small the budget
+	bool bFirst = true;
+	auto HasTimeLeft = [&bFirst, EndTime]()
+	{
+		const bool bRet = bFirst || FPlatformTime::Seconds() < EndTime;
+		bFirst = false;
+		return bRet;
+	};
+
 	// Respawn dynamic actors first; they need to exist in order for cross-references in level actors to work
-	for (auto&& SpawnedActor : LevelData->SpawnedActors.Contents)
+	while (Restore.NextRespawn < Restore.ActorsToRespawn.Num())
 	{
-		auto Actor = RespawnActor(SpawnedActor.Value, LevelData->Metadata, Level);
-		if (Actor)
-			RuntimeObjectsByGuid.Add(SpawnedActor.Value.Guid, Actor);
-		// Spawned actors will have been added to Level->Actors, their state will be restored there
+		if (!HasTimeLeft())
+			return ESpudLevelRestoreProgress::InProgress;
+
+		const FGuid& Guid = Restore.ActorsToRespawn[Restore.NextRespawn++];
+		if (const auto SpawnedActor = LevelData->SpawnedActors.Contents.Find(Guid))
+		{
+			auto Actor = RespawnActor(*SpawnedActor, LevelData->Metadata, Level);
+			if (Actor)
+				RuntimeObjects.ObjectsByGuid.Add(SpawnedActor->Guid, Actor);
+			// Spawned actors will have been added to Level->Actors, their state will be restored there
+		}
 	}
 
-	TMap<FGuid, AActor*> RestoredRuntimeActors;
+	if (!Restore.bActorsGathered)
+	{
+		// Gathered after respawning so that respawned actors are included
+		TArray<TPair<double, AActor*>> Gathered;
+		for (auto Actor : Level->Actors)
+		{
+			if (SpudPropertyUtil::IsPersistentObject(Actor))
+			{
+				// Actors with no location (managers etc) are put first, as though they're right next to the viewer
+				double DistSq = 0;
+				if (Restore.ViewLocation.IsSet() && Actor->GetRootComponent())
+					DistSq = FVector::DistSquared(Actor->GetActorLocation(), Restore.ViewLocation.GetValue());
+				Gathered.Emplace(DistSq, Actor);
+			}
+		}
+		// Stable, so without a view location this is just level order
+		if (Restore.ViewLocation.IsSet())
+		{
+			Algo::StableSortBy(Gathered, [](const TPair<double, AActor*>& Entry) { return Entry.Key; });
+		}
+		Restore.ActorsToRestore.Reserve(Gathered.Num());
+		for (const auto& Entry : Gathered)
+			Restore.ActorsToRestore.Add(Entry.Value);
+		Restore.bActorsGathered = true;
+	}
 
 	// Restore existing actor state
-	for (auto Actor : Level->Actors)
+	while (Restore.NextActor < Restore.ActorsToRestore.Num())
 	{
-		if (SpudPropertyUtil::IsPersistentObject(Actor))
+		if (!HasTimeLeft())
+			return ESpudLevelRestoreProgress::InProgress;
+
+		AActor* Actor = Restore.ActorsToRestore[Restore.NextActor++].Get();
+		// May have been destroyed since it was gathered
+		if (!IsValid(Actor))
+			continue;
+
+		RestoreActor(Actor, LevelData, &RuntimeObjects);
+		auto Guid = SpudPropertyUtil::GetGuidProperty(Actor);
+		if (Guid.IsValid())
 		{
-			RestoreActor(Actor, LevelData, &RuntimeObjectsByGuid);
-			auto Guid = SpudPropertyUtil::GetGuidProperty(Actor);
-			if (Guid.IsValid())
+			if (RuntimeObjects.ObjectsByGuid.Contains(Guid))
 			{
-				if (RuntimeObjectsByGuid.Contains(Guid))
+				if (const auto DuplicatedActor = Restore.RestoredRuntimeActors.Find(Guid))
 				{
-					if (const auto DuplicatedActor = RestoredRuntimeActors.Find(Guid))
-					{
-						UE_LOG(LogSpudState, Verbose, TEXT("RESTORE level %s - destroying duplicate runtime actor %s"),
-						       *LevelName, *Guid.ToString(EGuidFormats::DigitsWithHyphens));
+					UE_LOG(LogSpudState, Verbose, TEXT("RESTORE level %s - destroying duplicate runtime actor %s"),
+					       *LevelName, *Guid.ToString(EGuidFormats::DigitsWithHyphens));
 
-						// sometimes runtime actors are duplicated in the level actors array - for example, when hiding a
-						// world partition cell and immediately showing it; need to remove duplicates in this case
-						(*DuplicatedActor)->Destroy();
-					}
-					else
-					{
-						RestoredRuntimeActors.Emplace(Guid, Actor);
-					}
+					// sometimes runtime actors are duplicated in the level actors array - for example, when hiding a
+					// world partition cell and immediately showing it; need to remove duplicates in this case
+					if (AActor* Duplicate = DuplicatedActor->Get())
+						Duplicate->Destroy();
 				}
 				else
 				{
-					RuntimeObjectsByGuid.Add(Guid, Actor);
+					Restore.RestoredRuntimeActors.Emplace(Guid, Actor);
 				}
 			}
+			else
+			{
+				RuntimeObjects.ObjectsByGuid.Add(Guid, Actor);
+			}
 		}
 	}
 	// Destroy actors in level but missing from save state
+	// They're already recorded as destroyed, so mustn't be again by anything listening for them being destroyed
+	TGuardValue<bool> DestroyingGuard(bDestroyingRestoredActors, true);
 	for (auto&& DestroyedActor : LevelData->DestroyedActors.Values)
 	{
 		DestroyActor(*DestroyedActor, Level);			
 	}
 	UE_LOG(LogSpudState, Verbose, TEXT("RESTORE level %s - Complete"), *LevelName);
+	return ESpudLevelRestoreProgress::Complete;
+}
+
+bool USpudState::BeginIncrementalRestoreLevel(ULevel* Level, const TOptional<FVector>& ViewLocation)
+{
+	auto Restore = CreateLevelRestore(Level, ViewLocation);
+	if (!Restore.IsValid())
+		return false;
 
+	IncrementalRestores.Add(Restore);
+	return true;
+}
+
+TArray<FString> USpudState::UpdateIncrementalRestores(double BudgetSeconds)
+{
+	TArray<FString> Completed;
+	const double EndTime = FPlatformTime::Seconds() + BudgetSeconds;
+	// Oldest first, so levels are completed in the order they arrived rather than all progressing slowly
+	while (IncrementalRestores.Num() > 0)
+	{
+		const FString LevelName = IncrementalRestores[0]->LevelName;
+		if (!StepIncrementalRestore(0, EndTime))
+			break;
+
+		Completed.Add(LevelName);
+		if (FPlatformTime::Seconds() >= EndTime)
+			break;
+	}
+	return Completed;
+}
+
+bool USpudState::StepIncrementalRestore(int32 Index, double EndTime)
+{
+	// Taken out while it's stepped, so anything storing the level from restore callbacks doesn't re-enter it;
+	// same as storing during a RestoreLevel
+	const TSharedPtr<FSpudLevelRestore> Restore = IncrementalRestores[Index];
+	IncrementalRestores.RemoveAt(Index);
+	const ESpudLevelRestoreProgress Progress = StepLevelRestore(*Restore, EndTime);
+	if (Progress == ESpudLevelRestoreProgress::InProgress)
+	{
+		IncrementalRestores.Insert(Restore, FMath::Min(Index, IncrementalRestores.Num()));
+		return false;
+	}
+
+	FinishedIncrementalRestores.Add(Restore->LevelName, Progress == ESpudLevelRestoreProgress::Complete);
+	return true;
+}
+
+int32 USpudState::FindIncrementalRestore(const FString& LevelName) const
+{
+	return IncrementalRestores.IndexOfByPredicate([&LevelName](const TSharedPtr<FSpudLevelRestore>& Restore)
+	{
+		return Restore->LevelName == LevelName;
+	});
+}
+
+bool USpudState::FinishIncrementalRestore(const FString& LevelName)
+{
+	const int32 Index = FindIncrementalRestore(LevelName);
+	if (Index != INDEX_NONE)
+		StepIncrementalRestore(Index, DBL_MAX);
+
+	bool bSucceeded = false;
+	FinishedIncrementalRestores.RemoveAndCopyValue(LevelName, bSucceeded);
+	return bSucceeded;
+}
+
+void USpudState::FinishIncrementalRestoreBeforeStore(const FString& LevelName)
+{
+	const int32 Index = IncrementalRestores.Num() > 0 ? FindIncrementalRestore(LevelName) : INDEX_NONE;
+	if (Index != INDEX_NONE)
+	{
+		UE_LOG(LogSpudState, Verbose, TEXT("Completing restore of level %s early since it's being stored"), *LevelName);
+		// The result is kept for whoever began the restore (@see FinishIncrementalRestore)
+		StepIncrementalRestore(Index, DBL_MAX);
+	}
+}
+
+void USpudState::CancelIncrementalRestores()
+{
+	IncrementalRestores.Empty();
+	FinishedIncrementalRestores.Empty();
+}
+
+bool USpudState::IsIncrementalRestoreInProgress(const FString& LevelName) const
+{
+	return FindIncrementalRestore(LevelName) != INDEX_NONE;
 }
 
 bool USpudState::PreLoadLevelData(const FString& LevelName)
@@ -552,6 +912,30 @@ bool USpudState::PreLoadLevelData(const FString& LevelName)
 	return Data != nullptr;
 }
 
+TArray<FSoftObjectPath> USpudState::GetLevelAssetsToPreload(const FString& LevelName)
+{
+	TArray<FSoftObjectPath> Ret;
+	auto LevelData = GetLevelData(LevelName, false);
+	if (!LevelData.IsValid())
+		return Ret;
+
+	FScopeLock LevelLock(&LevelData->Mutex);
+	auto AddIfNotLoaded = [&Ret](const FString& Path)
+	{
+		const FSoftObjectPath SoftPath(Path);
+		if (SoftPath.IsValid() && !SoftPath.ResolveObject())
+			Ret.Add(SoftPath);
+	};
+	// Every class in the metadata: respawned actors, nested UObjects & TSubclassOf values. Level actor classes
+	// will be loaded already so are skipped
+	for (const FString& ClassName : LevelData->Metadata.ClassNameIndex.UniqueValues)
+		AddIfNotLoaded(ClassName);
+	for (const FString& AssetPath : LevelData->Metadata.AssetPathIndex.UniqueValues)
+		AddIfNotLoaded(AssetPath);
+
+	return Ret;
+}
+
 void USpudState::RestoreActor(AActor* Actor)
 {
 	if (Actor->HasAnyFlags(RF_ClassDefaultObject|RF_ArchetypeObject|RF_BeginDestroyed))
@@ -670,13 +1054,13 @@ bool USpudState::ShouldActorVelocityBeRestored(AActor* Actor) const
 	return true;
 }
 
-void USpudState::RestoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData, const TMap<FGuid, UObject*>* RuntimeObjects)
+void USpudState::RestoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData, const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects)
 {
 	if (Actor->HasAnyFlags(RF_ClassDefaultObject|RF_ArchetypeObject|RF_BeginDestroyed))
 		return;
 
 	const bool bRespawned = ShouldActorBeRespawnedOnRestore(Actor);
-	const FSpudObjectData* ActorData;
+	FSpudObjectData* ActorData;
 
 	if (bRespawned)
 	{
@@ -691,13 +1075,19 @@ void USpudState::RestoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelD
 
 	if (ActorData)
 	{
+		// Taken before restoring, so that anything marking the actor dirty during the restore still counts
+		const uint32 DirtyGeneration = GetDirtyGeneration(Actor);
+		
 		PreRestoreObject(Actor, LevelData->GetUserDataModelVersion());
 		
-		RestoreCoreActorData(Actor, ActorData->CoreData);
 		const auto ClassDef = LevelData->Metadata.GetClassDef(ActorData->ClassID);
+		RestoreCoreActorData(Actor, ActorData->CoreData, ClassDef ? ClassDef->Encoding : FSpudEncodingProfile());
 		RestoreObjectProperties(Actor, ActorData->Properties, LevelData->Metadata, ClassDef, RuntimeObjects);
 
-		PostRestoreObject(Actor, ActorData->CustomData, LevelData->GetUserDataModelVersion());		
+		PostRestoreObject(Actor, ActorData->CustomData, LevelData->GetUserDataModelVersion());
+
+		// Actor now matches the record, unless the record needs upgrading
+		ActorData->StoredDirtyGeneration = LevelData->Metadata.IsUserDataModelOutdated() ? 0 : DirtyGeneration;
 	}
 }
 
@@ -729,7 +1119,7 @@ void USpudState::PostRestoreObject(UObject* Obj, const FSpudCustomData& FromCust
 	}
 }
 
-void USpudState::RestoreCoreActorData(AActor* Actor, const FSpudCoreActorData& FromData)
+void USpudState::RestoreCoreActorData(AActor* Actor, const FSpudCoreActorData& FromData, const FSpudEncodingProfile& Encoding)
 {
 	// Restore core data based on version
 	// Unlike properties this is packed data, versioned
@@ -740,30 +1130,39 @@ void USpudState::RestoreCoreActorData(AActor* Actor, const FSpudCoreActorData& F
 	uint16 InVersion = 0;
 	SpudPropertyUtil::ReadRaw(InVersion, In);
 
-	if (InVersion == 1)
+	// See WriteCoreActorData for formats
+	if (InVersion == 1 || InVersion == 2)
 	{
-		// First, and only version right now
-		// V1 Format:
-		// - Version (uint16)
-		// - Hidden (bool)
-		// - Transform (FTransform)
-		// - Velocity (FVector)
-		// - AngularVelocity (FVector)
-		// - Control rotation (FRotator) (non-zero for Pawns only)
-
 		bool Hidden;
-		SpudPropertyUtil::ReadRaw(Hidden, In);
-		Actor->SetActorHiddenInGame(Hidden);
-
 		FTransform XForm;
-		SpudPropertyUtil::ReadRaw(XForm, In);
+		FVector Velocity = FVector::ZeroVector;
+		FVector AngularVelocity = FVector::ZeroVector;
+		FRotator ControlRotation = FRotator::ZeroRotator;
 
-		FVector Velocity, AngularVelocity;
-		SpudPropertyUtil::ReadRaw(Velocity, In);
-		SpudPropertyUtil::ReadRaw(AngularVelocity, In);
+		if (InVersion == 1)
+		{
+			SpudPropertyUtil::ReadRaw(Hidden, In);
+			SpudPropertyUtil::ReadRaw(XForm, In);
+			SpudPropertyUtil::ReadRaw(Velocity, In);
+			SpudPropertyUtil::ReadRaw(AngularVelocity, In);
+			SpudPropertyUtil::ReadRaw(ControlRotation, In);
+		}
+		else
+		{
+			// Compact, quantization steps are in the actor's class def
+			uint8 Flags;
+			In << Flags;
+			Hidden = (Flags & ESCAF_Hidden) != 0;
+			SpudPropertyUtil::ReadQuantized(XForm, Encoding, In);
+			if (Flags & ESCAF_HasVelocity)
+				SpudPropertyUtil::ReadQuantized(Velocity, Encoding.PositionQuantum, In);
+			if (Flags & ESCAF_HasAngularVelocity)
+				SpudPropertyUtil::ReadQuantized(AngularVelocity, Encoding.RotationQuantum, In);
+			if (Flags & ESCAF_HasControlRotation)
+				SpudPropertyUtil::ReadQuantized(ControlRotation, Encoding, In);
+		}
 
-		FRotator ControlRotation;
-		SpudPropertyUtil::ReadRaw(ControlRotation, In);
+		Actor->SetActorHiddenInGame(Hidden);
 
 
 		auto Pawn = Cast<APawn>(Actor);
@@ -824,17 +1223,19 @@ void USpudState::RestoreCoreActorData(AActor* Actor, const FSpudCoreActorData& F
 }
 
 void USpudState::RestoreObjectProperties(UObject* Obj, const FSpudPropertyData& FromData, const FSpudClassMetadata& Meta,
-	TSharedPtr<const FSpudClassDef> StoredClassDef, const TMap<FGuid, UObject*>* RuntimeObjects, int StartDepth)
+	TSharedPtr<const FSpudClassDef> StoredClassDef, const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects, int StartDepth)
 {
 	FSpudMemoryReader In(FromData.Data);
-	RestoreObjectProperties(Obj, In, Meta, StoredClassDef, FromData.PropertyOffsets, RuntimeObjects, StartDepth);
+	const TBitArray<>* PresentProperties = FromData.PresentProperties.Num() > 0 ? &FromData.PresentProperties : nullptr;
+	RestoreObjectProperties(Obj, In, Meta, StoredClassDef, FromData.PropertyOffsets, PresentProperties, RuntimeObjects, StartDepth);
 
 }
 
 
 void USpudState::RestoreObjectProperties(UObject* Obj, FSpudMemoryReader& In, const FSpudClassMetadata& Meta,
 										 TSharedPtr<const FSpudClassDef> StoredClassDef, const TArray<uint32>& PropertyOffsets,
-										 const TMap<FGuid, UObject*>* RuntimeObjects, int StartDepth)
+										 const TBitArray<>* PresentProperties,
+										 const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects, int StartDepth)
 {
 	if (!StoredClassDef)
 	{
@@ -861,22 +1262,24 @@ void USpudState::RestoreObjectProperties(UObject* Obj, FSpudMemoryReader& In, co
 	
 	
 	if (bUseFastPath)
-		RestoreObjectPropertiesFast(Obj, In, Meta, StoredClassDef, PropertyOffsets, RuntimeObjects, StartDepth);
+		RestoreObjectPropertiesFast(Obj, In, Meta, StoredClassDef, PropertyOffsets, PresentProperties, RuntimeObjects, StartDepth);
 	else
-		RestoreObjectPropertiesSlow(Obj, In, Meta, StoredClassDef, PropertyOffsets, RuntimeObjects, StartDepth);
+		RestoreObjectPropertiesSlow(Obj, In, Meta, StoredClassDef, PropertyOffsets, PresentProperties, RuntimeObjects, StartDepth);
 }
 
 void USpudState::RestoreObjectPropertiesFast(UObject* Obj, FSpudMemoryReader& In,
                                              const FSpudClassMetadata& Meta,
                                              TSharedPtr<const FSpudClassDef> ClassDef,
                                              const TArray<uint32>& PropertyOffsets,
-                                             const TMap<FGuid, UObject*>* RuntimeObjects,
+                                             const TBitArray<>* PresentProperties,
+                                             const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects,
                                              int StartDepth)
 {
 	UE_LOG(LogSpudState, Verbose, TEXT("%s FAST path, %d properties"), *SpudPropertyUtil::GetLogPrefix(StartDepth), ClassDef->Properties.Num());
 	const auto StoredPropertyIterator = ClassDef->Properties.CreateConstIterator();
+	const UObject* Archetype = PresentProperties ? Obj->GetArchetype() : nullptr;
 
-	RestoreFastPropertyVisitor Visitor(this, StoredPropertyIterator, In, ClassDef, PropertyOffsets, Meta, RuntimeObjects);
+	RestoreFastPropertyVisitor Visitor(this, StoredPropertyIterator, In, ClassDef, PropertyOffsets, PresentProperties, Archetype, Meta, RuntimeObjects);
 	SpudPropertyUtil::VisitPersistentProperties(Obj, Visitor, StartDepth);
 	
 }
@@ -885,12 +1288,14 @@ void USpudState::RestoreObjectPropertiesSlow(UObject* Obj, FSpudMemoryReader& In
                                                        const FSpudClassMetadata& Meta,
                                                        TSharedPtr<const FSpudClassDef> ClassDef,
                                                        const TArray<uint32>& PropertyOffsets,
-                                                       const TMap<FGuid, UObject*>* RuntimeObjects,
+                                                       const TBitArray<>* PresentProperties,
+                                                       const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects,
                                                        int StartDepth)
 {
 	UE_LOG(LogSpudState, Verbose, TEXT("%s SLOW path, %d properties"), *SpudPropertyUtil::GetLogPrefix(StartDepth), ClassDef->Properties.Num());
+	const UObject* Archetype = PresentProperties ? Obj->GetArchetype() : nullptr;
 
-	RestoreSlowPropertyVisitor Visitor(this, In, ClassDef, PropertyOffsets, Meta, RuntimeObjects);
+	RestoreSlowPropertyVisitor Visitor(this, In, ClassDef, PropertyOffsets, PresentProperties, Archetype, Meta, RuntimeObjects);
 	SpudPropertyUtil::VisitPersistentProperties(Obj, Visitor, StartDepth);
 }
 
@@ -950,7 +1355,7 @@ void USpudState::RestorePropertyVisitor::RestoreNestedUObjectIfNeeded(UObject* R
 					FSpudMemoryReader ObjectDataIn(ObjectData);
 					const uint32 NewPrefixID = GetNestedPrefix(Property, CurrentPrefixID);
 					const auto StoredClassDef = Meta.GetClassDef(SpudPropertyUtil::GetClassName(Obj));
-					ParentState->RestoreObjectProperties(Obj, ObjectDataIn, Meta, StoredClassDef, ObjectPropertyOffsets, RuntimeObjects, Depth+1);
+					ParentState->RestoreObjectProperties(Obj, ObjectDataIn, Meta, StoredClassDef, ObjectPropertyOffsets, nullptr, RuntimeObjects, Depth+1);
 
 					if (IsCallback)
 					{
@@ -966,6 +1371,18 @@ void USpudState::RestorePropertyVisitor::RestoreNestedUObjectIfNeeded(UObject* R
 	}	
 }
 
+void USpudState::RestorePropertyVisitor::RestoreUnchangedProperty(UObject* RootObject, FProperty* Property,
+	void* ContainerPtr, int Depth)
+{
+	// Value was identical to the archetype when stored. Don't assume the loaded value still is, e.g. level actors
+	// can have instance overrides which the archetype doesn't
+	if (const void* ArchetypeContainerPtr = SpudPropertyUtil::GetEquivalentContainerPtr(RootObject, ContainerPtr, Archetype))
+	{
+		Property->CopyCompleteValue_InContainer(ContainerPtr, ArchetypeContainerPtr);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = (archetype value)"), *SpudPropertyUtil::GetLogPrefix(Property, Depth));
+	}
+}
+
 bool USpudState::RestoreFastPropertyVisitor::VisitProperty(UObject* RootObject, FProperty* Property,
                                                            uint32 CurrentPrefixID, void* ContainerPtr, int Depth)
 {
@@ -973,7 +1390,10 @@ bool USpudState::RestoreFastPropertyVisitor::VisitProperty(UObject* RootObject,
 	if (StoredPropertyIterator)
 	{
 		auto& StoredProperty = *StoredPropertyIterator;
-		SpudPropertyUtil::RestoreProperty(RootObject, Property, ContainerPtr, StoredProperty, RuntimeObjects, Meta, Depth, DataIn);
+		if (SpudPropertyUtil::IsCustomStructProperty(Property) || IsPropertyPresent(StoredPropertyIterator.GetIndex()))
+			SpudPropertyUtil::RestoreProperty(RootObject, Property, ContainerPtr, StoredProperty, ClassDef->Encoding, RuntimeObjects, Meta, Depth, DataIn);
+		else
+			RestoreUnchangedProperty(RootObject, Property, ContainerPtr, Depth);
 
 		// We DON'T increment the property iterator for custom structs, since they don't have any values of their own
 		// It's their nested properties that have the values, they're only context
@@ -987,6 +1407,29 @@ bool USpudState::RestoreFastPropertyVisitor::VisitProperty(UObject* RootObject,
 	return false;
 }
 
+bool USpudState::RestoreFastPropertyVisitor::VisitPlannedProperty(UObject* RootObject, const FSpudPropertyPlanStep& Step,
+                                                                  uint32 CurrentPrefixID, void* ContainerPtr, int Depth)
+{
+	// Same as VisitProperty but using the type info resolved when the plan was built
+	if (StoredPropertyIterator)
+	{
+		auto& StoredProperty = *StoredPropertyIterator;
+		if (Step.bIsCustomStruct || IsPropertyPresent(StoredPropertyIterator.GetIndex()))
+			SpudPropertyUtil::RestoreProperty(RootObject, Step, ContainerPtr, StoredProperty, ClassDef->Encoding, RuntimeObjects, Meta, Depth, DataIn);
+		else
+			RestoreUnchangedProperty(RootObject, Step.Property, ContainerPtr, Depth);
+
+		if (!Step.bIsCustomStruct)
+			++StoredPropertyIterator;
+
+		if (Step.bIsNestedUObject)
+			RestoreNestedUObjectIfNeeded(RootObject, Step.Property, CurrentPrefixID, ContainerPtr, Depth);
+
+		return true;
+	}
+	return false;
+}
+
 bool USpudState::RestoreSlowPropertyVisitor::VisitProperty(UObject* RootObject, FProperty* Property,
                                                                      uint32 CurrentPrefixID, void* ContainerPtr, int Depth)
 {
@@ -1025,9 +1468,14 @@ bool USpudState::RestoreSlowPropertyVisitor::VisitProperty(UObject* RootObject,
 		UE_LOG(LogSpudState, Error, TEXT("Error in RestoreSlowPropertyVisitor, invalid property index for %s on class %s"), *Property->GetName(), *ClassDef->ClassName);
 		return true;		
 	}
+	if (!IsPropertyPresent(*PropertyIndexPtr))
+	{
+		RestoreUnchangedProperty(RootObject, Property, ContainerPtr, Depth);
+		return true;
+	}
 	auto& StoredProperty = ClassDef->Properties[*PropertyIndexPtr];
 	DataIn.Seek(PropertyOffsets[*PropertyIndexPtr]);
-	SpudPropertyUtil::RestoreProperty(RootObject, Property, ContainerPtr, StoredProperty, RuntimeObjects, Meta, Depth, DataIn);
+	SpudPropertyUtil::RestoreProperty(RootObject, Property, ContainerPtr, StoredProperty, ClassDef->Encoding, RuntimeObjects, Meta, Depth, DataIn);
 
 	RestoreNestedUObjectIfNeeded(RootObject, Property, CurrentPrefixID, ContainerPtr, Depth);
 	
@@ -1071,7 +1519,7 @@ void USpudState::RestoreGlobalObject(UObject* Obj, const FSpudNamedObjectData* D
 	}
 	
 }
-void USpudState::StoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData)
+void USpudState::StoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData, bool bSkipIfClean)
 {
 	if (Actor->HasAnyFlags(RF_ClassDefaultObject|RF_ArchetypeObject|RF_BeginDestroyed))
 		return;
@@ -1085,12 +1533,12 @@ void USpudState::StoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelDat
 	
 	// This is how we identify run-time created objects
 	bool bRespawn = ShouldActorBeRespawnedOnRestore(Actor);
-	FString Name;
 	FGuid Guid;
 
 	TArray<uint8>* pDestCoreData = nullptr;
 	FSpudPropertyData* pDestProperties = nullptr;
 	TArray<uint8>* pDestCustomData = nullptr;
+	FSpudObjectData* pRecord = nullptr;
 	FSpudClassMetadata& Meta = LevelData->Metadata;
 	if (bRespawn)
 	{
@@ -1100,8 +1548,9 @@ void USpudState::StoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelDat
 			pDestCoreData = &ActorData->CoreData.Data;
 			pDestProperties = &ActorData->Properties;
 			pDestCustomData = &ActorData->CustomData.Data;
+			ActorData->bStored = true;
+			pRecord = ActorData;
 			Guid = ActorData->Guid;
-			Name = SpudPropertyUtil::GetLevelActorName(Actor);
 		}
 	}
 	else
@@ -1112,7 +1561,8 @@ void USpudState::StoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelDat
 			pDestCoreData = &ActorData->CoreData.Data;
 			pDestProperties = &ActorData->Properties;
 			pDestCustomData = &ActorData->CustomData.Data;
-			Name = ActorData->Name;
+			ActorData->bStored = true;
+			pRecord = ActorData;
 
 #if WITH_EDITOR
 			// Verify that cases where the actor wasn't loaded from the level, but also
@@ -1143,29 +1593,57 @@ void USpudState::StoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelDat
 	
 
 	if (bRespawn)
-		UE_LOG(LogSpudState, Verbose, TEXT(" * STORE Runtime Actor: %s (%s)"), *Guid.ToString(EGuidFormats::DigitsWithHyphens), *Name)
+		UE_LOG(LogSpudState, Verbose, TEXT(" * STORE Runtime Actor: %s (%s)"), *Guid.ToString(EGuidFormats::DigitsWithHyphens), *Actor->GetName())
 	else
-		UE_LOG(LogSpudState, Verbose, TEXT(" * STORE Level Actor: %s/%s"), *LevelData->Name, *Name);
+		UE_LOG(LogSpudState, Verbose, TEXT(" * STORE Level Actor: %s/%s"), *LevelData->Name, *Actor->GetName());
+
+	// If the actor uses dirty tracking & hasn't been marked since the record was stored / restored, the properties
+	// & custom data in the record are still correct. Core data isn't covered by dirty tracking (e.g. physics can move
+	// things) but it's cheap, so is always updated
+	const uint32 DirtyGeneration = GetDirtyGeneration(Actor);
+	const bool bClean = bSkipIfClean &&
+		pRecord->StoredDirtyGeneration == DirtyGeneration &&
+		Actor->Implements<USpudObject>() &&
+		ISpudObject::Execute_UsesSpudDirtyTracking(Actor);
 
-	bool bIsCallback = Actor->GetClass()->ImplementsInterface(USpudObjectCallback::StaticClass());
+	bool bIsCallback = !bClean && Actor->GetClass()->ImplementsInterface(USpudObjectCallback::StaticClass());
 
 	if (bIsCallback)
 		ISpudObjectCallback::Execute_SpudPreStore(Actor, this);
 
-	// Core data first
-	pDestCoreData->Empty();
-	FSpudMemoryWriter CoreDataWriter(*pDestCoreData);
-	WriteCoreActorData(Actor, CoreDataWriter);
+	// Everything is encoded into scratch buffers first, and only replaces what's in the record if it's different,
+	// so that level data can tell whether it actually changed (and doesn't need writing out again if not)
+	
+	// Core data first, same encoding as the properties
+	ScratchCoreData.Reset();
+	FSpudMemoryWriter CoreDataWriter(ScratchCoreData);
+	WriteCoreActorData(Actor, Meta.FindOrAddClassDef(SpudPropertyUtil::GetClassName(Actor))->Encoding, CoreDataWriter);
+
+	// Swap rather than copy, the old buffers get reused for the next actor
+	bool bChanged = false;
+	if (ScratchCoreData != *pDestCoreData)
+	{
+		Swap(ScratchCoreData, *pDestCoreData);
+		bChanged = true;
+	}
+
+	if (bClean)
+	{
+		if (bChanged)
+			LevelData->bModified = true;
+		UE_LOG(LogSpudState, Verbose, TEXT(" * Clean, skipped properties: %s"), *Actor->GetName());
+		return;
+	}
 
 	// Now properties, visit all and write out
-	StoreObjectProperties(Actor, *pDestProperties, Meta);
+	StoreObjectProperties(Actor, ScratchProperties, Meta);
 
+	ScratchCustomData.Reset();
 	if (bIsCallback)
 	{
 		if (pDestCustomData)
 		{
-			pDestCustomData->Empty();
-			FSpudMemoryWriter CustomDataWriter(*pDestCustomData);
+			FSpudMemoryWriter CustomDataWriter(ScratchCustomData);
 			auto CustomDataStruct = NewObject<USpudStateCustomData>();
 			CustomDataStruct->Init(&CustomDataWriter);
 			ISpudObjectCallback::Execute_SpudStoreCustomData(Actor, this, CustomDataStruct);
@@ -1173,6 +1651,27 @@ void USpudState::StoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelDat
 	
 		ISpudObjectCallback::Execute_SpudPostStore(Actor, this);
 	}
+
+	if (ScratchProperties.PropertyOffsets != pDestProperties->PropertyOffsets ||
+		ScratchProperties.Data != pDestProperties->Data ||
+		ScratchProperties.PresentProperties != pDestProperties->PresentProperties)
+	{
+		Swap(ScratchProperties.PropertyOffsets, pDestProperties->PropertyOffsets);
+		Swap(ScratchProperties.Data, pDestProperties->Data);
+		Swap(ScratchProperties.PresentProperties, pDestProperties->PresentProperties);
+		bChanged = true;
+	}
+	if (pDestCustomData && ScratchCustomData != *pDestCustomData)
+	{
+		Swap(ScratchCustomData, *pDestCustomData);
+		bChanged = true;
+	}
+	pRecord->StoredDirtyGeneration = DirtyGeneration;
+
+	if (bChanged)
+		LevelData->bModified = true;
+	else
+		UE_LOG(LogSpudState, Verbose, TEXT(" * Unchanged: %s"), *Actor->GetName());
 }
 
 
@@ -1180,6 +1679,7 @@ void USpudState::StoreLevelActorDestroyed(AActor* Actor, FSpudSaveData::TLevelDa
 {
 	// We don't check for duplicates, because it should only be possible to destroy a uniquely named level actor once
 	LevelData->DestroyedActors.Add(SpudPropertyUtil::GetLevelActorName(Actor));
+	LevelData->bModified = true;
 }
 
 void USpudState::SaveToArchive(FArchive& SPUDAr)
@@ -1193,7 +1693,23 @@ void USpudState::SaveToArchive(FArchive& SPUDAr)
 
 }
 
-void USpudState::LoadFromArchive(FArchive& SPUDAr, bool bFullyLoadAllLevelData)
+TSharedRef<FSpudSaveData, ESPMode::ThreadSafe> USpudState::CreateSaveSnapshot()
+{
+	SaveData.PrepareForWrite();
+	TSharedRef<FSpudSaveData, ESPMode::ThreadSafe> Snapshot(new FSpudSaveData());
+	SaveData.CreateSnapshot(*Snapshot, GetActiveGameLevelFolder());
+	return Snapshot;
+}
+
+void USpudState::SaveSnapshotToArchive(FSpudSaveData& Snapshot, FArchive& SPUDAr)
+{
+	// Level files the snapshot needs are pinned to it, see FSpudSaveData::CreateSnapshot
+	FSpudChunkedDataArchive ChunkedAr(SPUDAr);
+	Snapshot.WriteToArchive(ChunkedAr, GetActiveGameLevelFolder());
+}
+
+void USpudState::LoadFromArchive(FArchive& SPUDAr, bool bFullyLoadAllLevelData, const FSpudReadProgressCallback& ProgressCallback,
+                                 const FString& SourceFilePath)
 {
 	// Firstly, destroy any active game level files
 	RemoveAllActiveGameLevelFiles();
@@ -1201,7 +1717,25 @@ void USpudState::LoadFromArchive(FArchive& SPUDAr, bool bFullyLoadAllLevelData)
 	Source = SPUDAr.GetArchiveName();
 	
 	FSpudChunkedDataArchive ChunkedAr(SPUDAr);
-	SaveData.ReadFromArchive(ChunkedAr, bFullyLoadAllLevelData, GetActiveGameLevelFolder());
+	SaveData.ReadFromArchive(ChunkedAr, bFullyLoadAllLevelData, GetActiveGameLevelFolder(), ProgressCallback, SourceFilePath);
+}
+
+bool USpudState::ReleaseSourceFile(const FString& Filename)
+{
+	if (!SaveData.SourceFilePath.IsEmpty() && FPaths::IsSamePath(SaveData.SourceFilePath, Filename))
+	{
+		return SaveData.ReleaseSourceFile(GetActiveGameLevelFolder());
+	}
+	return true;
+}
+
+bool USpudState::ExtractLevelsFromSourceFile(const FString& Filename)
+{
+	if (!SaveData.SourceFilePath.IsEmpty() && FPaths::IsSamePath(SaveData.SourceFilePath, Filename))
+	{
+		return SaveData.ExtractLevelsFromSourceFile(GetActiveGameLevelFolder());
+	}
+	return true;
 }
 
 bool USpudState::IsLevelDataLoaded(const FString& LevelName)
@@ -1219,26 +1753,30 @@ void USpudState::ClearLevel(const FString& LevelName)
 	SaveData.DeleteLevelData(LevelName, GetActiveGameLevelFolder());
 }
 
-bool USpudState::LoadSaveInfoFromArchive(FArchive& SPUDAr, USpudSaveGameInfo& OutInfo)
+bool USpudState::LoadSaveInfoFromArchive(FArchive& SPUDAr, USpudSaveGameInfo& OutInfo, bool bIncludeThumbnail)
 {
 	FSpudChunkedDataArchive ChunkedAr(SPUDAr);
 	FSpudSaveInfo StorageInfo;
-	const bool Ok = FSpudSaveData::ReadSaveInfoFromArchive(ChunkedAr, StorageInfo);
+	const bool Ok = FSpudSaveData::ReadSaveInfoFromArchive(ChunkedAr, StorageInfo, bIncludeThumbnail);
 	if (Ok)
-	{
-		OutInfo.Title = StorageInfo.Title;
-		OutInfo.Timestamp = StorageInfo.Timestamp;
-		if (StorageInfo.Screenshot.ImageData.Num() > 0)
-			OutInfo.Thumbnail = FImageUtils::ImportBufferAsTexture2D(StorageInfo.Screenshot.ImageData);
-		else
-			OutInfo.Thumbnail = nullptr;
-		OutInfo.CustomInfo = NewObject<USpudCustomSaveInfo>();
-		OutInfo.CustomInfo->SetData(StorageInfo.CustomInfo);
-	}
+		PopulateSaveGameInfo(StorageInfo, OutInfo);
 	return Ok;
 	
 }
 
+void USpudState::PopulateSaveGameInfo(const FSpudSaveInfo& StorageInfo, USpudSaveGameInfo& OutInfo)
+{
+	OutInfo.Title = StorageInfo.Title;
+	OutInfo.Timestamp = StorageInfo.Timestamp;
+	OutInfo.bHasThumbnail = StorageInfo.Screenshot.HasImage();
+	if (StorageInfo.Screenshot.ImageData.Num() > 0)
+		OutInfo.Thumbnail = FImageUtils::ImportBufferAsTexture2D(StorageInfo.Screenshot.ImageData);
+	else
+		OutInfo.Thumbnail = nullptr;
+	OutInfo.CustomInfo = NewObject<USpudCustomSaveInfo>();
+	OutInfo.CustomInfo->SetData(StorageInfo.CustomInfo);
+}
+
 void USpudStateCustomData::BeginWriteChunk(FString MagicID)
 {
 	auto MagicChar = StringCast<ANSICHAR>(*MagicID);
@@ -1451,7 +1989,11 @@ bool USpudState::RenameClass(const FString& OldClassName, const FString& NewClas
 	bool Changed = SaveData.GlobalData.Metadata.RenameClass(OldClassName, NewClassName);
 	for (auto && Pair : SaveData.LevelDataMap)
 	{
-		Changed = Pair.Value->Metadata.RenameClass(OldClassName, NewClassName) || Changed;
+		if (Pair.Value->Metadata.RenameClass(OldClassName, NewClassName))
+		{
+			Pair.Value->bModified = true;
+			Changed = true;
+		}
 	}
 	return Changed;
 }
@@ -1468,7 +2010,11 @@ bool USpudState::RenameProperty(const FString& ClassName, const FString& OldProp
 	bool Changed = SaveData.GlobalData.Metadata.RenameProperty(ClassName, OldPropertyName, NewPropertyName, OldPrefix, NewPrefix);
 	for (auto && Pair : SaveData.LevelDataMap)
 	{
-		Changed = Pair.Value->Metadata.RenameProperty(ClassName, OldPropertyName, NewPropertyName, OldPrefix, NewPrefix) || Changed;
+		if (Pair.Value->Metadata.RenameProperty(ClassName, OldPropertyName, NewPropertyName, OldPrefix, NewPrefix))
+		{
+			Pair.Value->bModified = true;
+			Changed = true;
+		}
 	}
 	return Changed;
 }
@@ -1485,7 +2031,10 @@ bool USpudState::RenameLevelObject(const FString& LevelName, const FString& OldN
 	{
 		FScopeLock LevelLock(&LevelData->Mutex);
 
-		return LevelData->LevelActors.RenameObject(OldName, NewName);
+		const bool bRenamed = LevelData->LevelActors.RenameObject(OldName, NewName);
+		if (bRenamed)
+			LevelData->bModified = true;
+		return bRenamed;
 	}
 	return false;
 }
@@ -2,8 +2,11 @@
 #include "SpudState.h"
 #include "Engine/LevelStreaming.h"
 #include "Engine/LocalPlayer.h"
+#include "GameFramework/PlayerController.h"
 #include "Kismet/GameplayStatics.h"
 #include "ImageUtils.h"
+#include "ImageCore.h"
+#include "IImageWrapper.h"
 #include "SpudRuntimeStoredActorComponent.h"
 #include "TimerManager.h"
 #include "HAL/FileManager.h"
@@ -22,11 +25,17 @@ DEFINE_LOG_CATEGORY(LogSpudSubsystem)
 
 #define SPUD_QUICKSAVE_SLOTNAME "__QuickSave__"
 #define SPUD_AUTOSAVE_SLOTNAME "__AutoSave__"
+// Only used with the SaveGameSystem, otherwise the slot index is a separate file
+#define SPUD_SLOTINDEX_SLOTNAME "__SpudSlotIndex__"
 
 
 void USpudSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	bIsTearingDown = false;
+	GSpudLevelDataCompressionFormat = LevelDataCompressionFormat;
+	UpdateEncodingProfile();
+	GSpudStoreArchetypeDeltas = bStoreArchetypeDeltas;
+	GSpudIncrementalLevelStore = bIncrementalLevelStore;
 	// Note: this will register for clients too, but callbacks will be ignored
 	// We can't call ServerCheck() here because GameMode won't be valid (which is what we use to determine server mode)
 	OnPostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &USpudSubsystem::OnPostLoadMap);
@@ -60,6 +69,8 @@ void USpudSubsystem::Deinitialize()
 {
 	Super::Deinitialize();
 	bIsTearingDown = true;
+
+	WaitForAsyncOperations();
 	
 	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(OnPostLoadMapHandle);
 	FCoreUObjectDelegates::PreLoadMap.Remove(OnPreLoadMapHandle);
@@ -118,6 +129,9 @@ bool USpudSubsystem::ServerCheck(bool LogWarning) const
 
 void USpudSubsystem::EndGame()
 {
+	WaitForAsyncOperations();
+	CancelTimeSlicedRestores();
+	
 	if (ActiveState)
 		ActiveState->ResetState();
 	
@@ -171,10 +185,24 @@ void USpudSubsystem::NotifyLevelUnloadedExternally(ULevel* Level)
 	HandleLevelUnloaded(Level);
 }
 
+/// Find the entry for the most recent save, or null if there are none
+static const FSpudSlotIndexEntry* SpudFindLatestSlotEntry(const TArray<FSpudSlotIndexEntry>& Entries)
+{
+	const FSpudSlotIndexEntry* Best = nullptr;
+	for (auto& Entry : Entries)
+	{
+		if (!Best || Entry.Info.Timestamp > Best->Info.Timestamp)
+			Best = &Entry;
+	}
+	return Best;
+}
+
 void USpudSubsystem::LoadLatestSaveGame(const FString& TravelOptions)
 {
-	auto Latest = GetLatestSaveGame();
-	if (Latest)
+	// No need to create the info object just to get the slot name
+	TArray<FSpudSlotIndexEntry> Entries;
+	GetSlotIndexEntries(Entries);
+	if (const auto Latest = SpudFindLatestSlotEntry(Entries))
 		LoadGame(Latest->SlotName, TravelOptions);
 }
 
@@ -210,6 +238,10 @@ void USpudSubsystem::OnPreLoadMap(const FString& MapName)
 #endif
 		}
 	}
+	// Levels still waiting for their assets or part way through restoring won't be restored now. Not cleared until
+	// after storing, so that the store knows they weren't restored yet, and completes those part way through
+	PendingLevelPreloads.Empty();
+	CancelTimeSlicedRestores();
 }
 
 void USpudSubsystem::OnSeamlessTravelTransition(UWorld* World)
@@ -261,7 +293,17 @@ void USpudSubsystem::OnPostLoadMap(UWorld* World)
 
 			const auto State = GetActiveState();
 			PreLevelRestore.Broadcast(LevelName);
+			// Load everything the persistent level's data needs in one batch, rather than one at a time during restore
+			TSharedPtr<FStreamableHandle> PreloadHandle;
+			if (bPreloadLevelAssets && IsValid(World->PersistentLevel))
+			{
+				const TArray<FSoftObjectPath> Assets = State->GetLevelAssetsToPreload(USpudState::GetLevelName(World->PersistentLevel));
+				if (Assets.Num() > 0)
+					PreloadHandle = StreamableManager.RequestSyncLoad(Assets);
+			}
 			State->RestoreLoadedWorld(World);
+			if (PreloadHandle.IsValid())
+				PreloadHandle->ReleaseHandle();
 			PostLevelRestore.Broadcast(LevelName, true);
 			
 			IsRestoringState = false;
@@ -355,19 +397,52 @@ void USpudSubsystem::OnScreenshotCaptured(int32 Width, int32 Height, const TArra
 {
 	ResetScreenshotState();
 
-	// Downscale the screenshot, pass to finish
-	TArray<FColor> RawDataCroppedResized;
-	FImageUtils::CropAndScaleImage(Width, Height, ScreenshotWidth, ScreenshotHeight, Colours, RawDataCroppedResized);
+	// Downscale & encode the screenshot in the background, UpdateAsyncScreenshot will pass it to finish
+	const int32 DestWidth = ScreenshotWidth;
+	const int32 DestHeight = ScreenshotHeight;
+	const ESpudScreenshotFormat Format = ScreenshotFormat;
+	AsyncScreenshotResult = Async(EAsyncExecution::ThreadPool, [Width, Height, Colours, DestWidth, DestHeight, Format]()
+	{
+		TArray<FColor> RawDataCroppedResized;
+		FImageUtils::CropAndScaleImage(Width, Height, DestWidth, DestHeight, Colours, RawDataCroppedResized);
 
-	// Convert down to PNG
-	TArray<uint8> PngData;
+		TArray<uint8> ImageData;
 #if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1
-	FImageUtils::ThumbnailCompressImageArray(ScreenshotWidth, ScreenshotHeight, RawDataCroppedResized, PngData);
+		const FImageView Image(RawDataCroppedResized.GetData(), DestWidth, DestHeight);
+		TArray64<uint8> EncodedData;
+		bool bEncoded;
+		switch (Format)
+		{
+		default:
+		case ESpudScreenshotFormat::PNG:
+			bEncoded = FImageUtils::CompressImage(EncodedData, TEXT("png"), Image);
+			break;
+		case ESpudScreenshotFormat::UncompressedPNG:
+			bEncoded = FImageUtils::CompressImage(EncodedData, TEXT("png"), Image, (int32)EImageCompressionQuality::Uncompressed);
+			break;
+		case ESpudScreenshotFormat::JPEG:
+			bEncoded = FImageUtils::CompressImage(EncodedData, TEXT("jpg"), Image);
+			break;
+		}
+		if (bEncoded)
+			ImageData = TArray<uint8>(EncodedData.GetData(), static_cast<int32>(EncodedData.Num()));
+		else
+			UE_LOG(LogSpudSubsystem, Error, TEXT("Unable to encode save game screenshot, saving without one"));
 #else
-	FImageUtils::CompressImageArray(ScreenshotWidth, ScreenshotHeight, RawDataCroppedResized, PngData);
+		FImageUtils::CompressImageArray(DestWidth, DestHeight, RawDataCroppedResized, ImageData);
 #endif
-	
-	FinishSaveGame(SlotNameInProgress, TitleInProgress, ExtraInfoInProgress, &PngData);
+		return ImageData;
+	});
+}
+
+void USpudSubsystem::UpdateAsyncScreenshot()
+{
+	if (!AsyncScreenshotResult.IsValid() || !AsyncScreenshotResult.IsReady())
+		return;
+
+	TArray<uint8> ImageData = AsyncScreenshotResult.Get();
+	AsyncScreenshotResult = TFuture<TArray<uint8>>();
+	FinishSaveGame(SlotNameInProgress, TitleInProgress, ExtraInfoInProgress, ImageData.Num() > 0 ? &ImageData : nullptr);
 }
 
 void USpudSubsystem::ResetScreenshotState()
@@ -482,6 +557,63 @@ void USpudSubsystem::FinishSaveGame(const FString& SlotName, const FText& Title,
 	// Plus it writes it all to memory first, which we don't need another copy of. Write direct to file
 	// I'm not sure if the save game system doesn't do this because of some console hardware issues, but
 	// I'll worry about that at some later point
+	if (bBackgroundSaveGame)
+	{
+		// Copying the state is all we do on the game thread
+		const auto Snapshot = State->CreateSaveSnapshot();
+		const FString Filename = GetSaveGameFilePath(SlotName);
+		SlotNameInProgress = SlotName;
+		AsyncSaveGameResult = Async(EAsyncExecution::ThreadPool, [State, Snapshot, Filename]()
+		{
+			// Written to a temporary file first, since levels may still be paged from (and piped from) the save
+			// being overwritten
+			const FString TempFilename = Filename + TEXT(".tmp");
+			IFileManager& FileMgr = IFileManager::Get();
+			auto Archive = TUniquePtr<FArchive>(FileMgr.CreateFileWriter(*TempFilename));
+			if (!Archive)
+			{
+				UE_LOG(LogSpudSubsystem, Error, TEXT("Error while creating save game %s"), *TempFilename);
+				return false;
+			}
+
+			State->SaveSnapshotToArchive(*Snapshot, *Archive);
+			// Always explicitly close to catch errors from flush/close
+			Archive->Close();
+
+			if (Archive->IsError() || Archive->IsCriticalError())
+			{
+				UE_LOG(LogSpudSubsystem, Error, TEXT("Error while saving game to %s"), *TempFilename);
+				FileMgr.Delete(*TempFilename, false, true, true);
+				return false;
+			}
+
+			// If we're still paging levels from the file we're about to replace, get them out of there first
+			if (!State->ExtractLevelsFromSourceFile(Filename))
+			{
+				UE_LOG(LogSpudSubsystem, Error, TEXT("Error while copying level data out of save game %s, not replacing it"), *Filename);
+				FileMgr.Delete(*TempFilename, false, true, true);
+				return false;
+			}
+			if (!FileMgr.Move(*Filename, *TempFilename, true, true))
+			{
+				UE_LOG(LogSpudSubsystem, Error, TEXT("Error while replacing save game %s"), *Filename);
+				FileMgr.Delete(*TempFilename, false, true, true);
+				return false;
+			}
+			return true;
+		});
+		// UpdateAsyncSaveGame will complete
+		return;
+	}
+
+	// If we're still paging levels from the file we're about to overwrite, get them out of there first
+	if (!State->ReleaseSourceFile(GetSaveGameFilePath(SlotName)))
+	{
+		UE_LOG(LogSpudSubsystem, Error, TEXT("Error while copying level data out of save game for slot %s, not overwriting it"), *SlotName);
+		SaveComplete(SlotName, false);
+		return;
+	}
+
 	IFileManager& FileMgr = IFileManager::Get();
 	auto Archive = TUniquePtr<FArchive>(FileMgr.CreateFileWriter(*GetSaveGameFilePath(SlotName)));
 
@@ -513,8 +645,27 @@ void USpudSubsystem::FinishSaveGame(const FString& SlotName, const FText& Title,
 #endif
 }
 
+void USpudSubsystem::UpdateAsyncSaveGame()
+{
+	if (!AsyncSaveGameResult.IsValid() || !AsyncSaveGameResult.IsReady())
+		return;
+
+	const bool SaveOK = AsyncSaveGameResult.Get();
+	AsyncSaveGameResult = TFuture<bool>();
+	if (SaveOK)
+	{
+		// Levels were already copied out of the save if it was being paged from, this just stops using it
+		GetActiveState()->ReleaseSourceFile(GetSaveGameFilePath(SlotNameInProgress));
+		UE_LOG(LogSpudSubsystem, Log, TEXT("Save to slot %s: Success"), *SlotNameInProgress);
+	}
+	SaveComplete(SlotNameInProgress, SaveOK);
+}
+
 void USpudSubsystem::SaveComplete(const FString& SlotName, bool bSuccess)
 {
+	if (bSuccess)
+		UpdateSlotIndex(SlotName, GetActiveState()->SaveData.Info);
+
 	CurrentState = ESpudSystemState::RunningIdle;
 	PostSaveGame.Broadcast(SlotName, bSuccess);
 	// It's possible that the reference to SlotName *is* SlotNameInProgress, so we can't reset it until after
@@ -527,6 +678,11 @@ void USpudSubsystem::HandleLevelLoaded(FName LevelName)
 {
 	if (!ServerCheck(false))
 		return;
+
+	// Any levels being loaded while we're reading a save game in the background are from the world we're about to
+	// leave, and the state is not safe to access anyway
+	if (AsyncLoadGameResult.IsValid())
+		return;
 	
 	// Defer the restore to the game thread, streaming calls happen in loading thread?
 	// However, quickly ping the state to force it to pre-load the leveldata
@@ -558,8 +714,12 @@ void USpudSubsystem::HandleLevelUnloaded(ULevel* Level)
 	if (!ServerCheck(false))
 		return;
 	
+	const FName LevelName(USpudState::GetLevelName(Level));
 	if (ShouldStoreLevel(Level))
 	{
+		// Complete a time sliced restore first so the level isn't stored half restored, and PostLevelRestore
+		// always pairs with PreLevelRestore
+		FinishTimeSlicedRestore(LevelName);
 		UnsubscribeLevelObjectEvents(Level);
 
 		if (CurrentState != ESpudSystemState::LoadingGame && !bIsTearingDown)
@@ -574,6 +734,8 @@ void USpudSubsystem::HandleLevelUnloaded(ULevel* Level)
 			StoreLevel(Level, true, false);
 		}
 	}
+	// Not restored if it was still waiting for its preload (StoreLevel keeps its existing data), and now never will be
+	PendingLevelPreloads.Remove(LevelName);
 }
 
 
@@ -592,6 +754,22 @@ void USpudSubsystem::StoreWorld(UWorld* World, bool bReleaseLevels, bool bBlocki
 void USpudSubsystem::StoreLevel(ULevel* Level, bool bRelease, bool bBlocking)
 {
 	const FString LevelName = USpudState::GetLevelName(Level);
+	// A level still waiting for its preload hasn't been restored, so storing it would replace its saved state
+	// with whatever its actors started with
+	if (PendingLevelPreloads.Contains(FName(LevelName)))
+	{
+		if (bRelease)
+		{
+			// Going away, so the existing data is still the latest
+			UE_LOG(LogSpudSubsystem, Verbose, TEXT("Not storing level %s, it hasn't been restored yet"), *LevelName);
+			PendingLevelPreloads.Remove(FName(LevelName));
+			GetActiveState()->ReleaseLevelData(LevelName, bBlocking);
+			return;
+		}
+		// Staying loaded, so restore it now; any assets not preloaded yet are loaded as needed
+		FinishLevelPreload(FName(LevelName));
+	}
+
 	PreLevelStore.Broadcast(LevelName);
 	GetActiveState()->StoreLevel(Level, bRelease, bBlocking);
 	PostLevelStore.Broadcast(LevelName, true);
@@ -621,6 +799,7 @@ void USpudSubsystem::LoadGame(const FString& SlotName, const FString& TravelOpti
 
 	auto State = GetActiveState();
 
+	CancelTimeSlicedRestores();
 	State->ResetState();
 
 #ifdef USE_SAVEGAMESYSTEM
@@ -655,15 +834,21 @@ void USpudSubsystem::LoadGame(const FString& SlotName, const FString& TravelOpti
 	
 #else
 
-	// TODO: async load
+	if (bAsyncLoadGame)
+	{
+		// Read the save file in the background, then load the map package async, then FinishLoadGame
+		StartAsyncLoadGame(SlotName, TravelOptions);
+		return;
+	}
 
 	IFileManager& FileMgr = IFileManager::Get();
-	auto Archive = TUniquePtr<FArchive>(FileMgr.CreateFileReader(*GetSaveGameFilePath(SlotName)));
+	const FString Filename = GetSaveGameFilePath(SlotName);
+	auto Archive = TUniquePtr<FArchive>(FileMgr.CreateFileReader(*Filename));
 
 	if(Archive)
 	{
 		// Load only global data and page in level data as needed
-		State->LoadFromArchive(*Archive, false);
+		State->LoadFromArchive(*Archive, false, nullptr, bPageLevelsFromSaveFile ? Filename : FString());
 		Archive->Close();
 
 		if (Archive->IsError() || Archive->IsCriticalError())
@@ -707,7 +892,144 @@ void USpudSubsystem::LoadGame(const FString& SlotName, const FString& TravelOpti
 	        WorldToLoad = UWorld::FindWorldInPackage(WorldPackage);
 	    }
 	}
+
+	FinishLoadGame(SlotName, TravelOptions);
+}
+
+void USpudSubsystem::StartAsyncLoadGame(const FString& SlotName, const FString& TravelOptions)
+{
+	SlotNameInProgress = SlotName;
+	TravelOptionsInProgress = TravelOptions;
+	AsyncLoadBytesProcessed = 0;
+	AsyncLoadTotalBytes = 0;
+	AsyncLoadLevelsProcessed = 0;
+	AsyncLoadLastBroadcastLevels = -1;
+
+	UE_LOG(LogSpudSubsystem, Verbose, TEXT("Starting async load of slot %s"), *SlotName);
+
+	// The state is not touched by anything else while we're in the LoadingGame state; level streaming events are
+	// ignored until the read is complete, and EndGame / Deinitialize wait for it
+	USpudState* State = GetActiveState();
+	const FString Filename = GetSaveGameFilePath(SlotName);
+	const FString SourceFilePath = bPageLevelsFromSaveFile ? Filename : FString();
+	AsyncLoadGameResult = Async(EAsyncExecution::ThreadPool, [this, State, Filename, SourceFilePath]()
+	{
+		IFileManager& FileMgr = IFileManager::Get();
+		auto Archive = TUniquePtr<FArchive>(FileMgr.CreateFileReader(*Filename));
+		if (!Archive)
+		{
+			UE_LOG(LogSpudSubsystem, Error, TEXT("Error while opening save game %s"), *Filename);
+			return false;
+		}
+
+		// Load only global data and page in level data as needed
+		State->LoadFromArchive(*Archive, false, [this](int64 BytesProcessed, int64 TotalBytes, int32 LevelsProcessed)
+		{
+			AsyncLoadBytesProcessed = BytesProcessed;
+			AsyncLoadTotalBytes = TotalBytes;
+			AsyncLoadLevelsProcessed = LevelsProcessed;
+		}, SourceFilePath);
+		Archive->Close();
+
+		if (Archive->IsError() || Archive->IsCriticalError())
+		{
+			UE_LOG(LogSpudSubsystem, Error, TEXT("Error while loading game from %s"), *Filename);
+			return false;
+		}
+		return true;
+	});
+}
+
+void USpudSubsystem::UpdateAsyncLoadGame()
+{
+	if (!AsyncLoadGameResult.IsValid())
+		return;
+
+	// Progress is broadcast from the game thread, only when something has changed
+	const int32 Levels = AsyncLoadLevelsProcessed;
+	if (Levels != AsyncLoadLastBroadcastLevels || AsyncLoadGameResult.IsReady())
+	{
+		AsyncLoadLastBroadcastLevels = Levels;
+		LoadGameProgress.Broadcast(SlotNameInProgress, AsyncLoadBytesProcessed, AsyncLoadTotalBytes, Levels);
+	}
+
+	if (!AsyncLoadGameResult.IsReady())
+		return;
+
+	const bool bReadOK = AsyncLoadGameResult.Get();
+	AsyncLoadGameResult = TFuture<bool>();
+
+	if (CurrentState != ESpudSystemState::LoadingGame)
+	{
+		// Game was ended or reset while we were reading
+		return;
+	}
 	
+	if (!bReadOK)
+	{
+		LoadComplete(SlotNameInProgress, false);
+		return;
+	}
+
+	const FString LevelName = GetActiveState()->GetPersistentLevel();
+	if (UPackage* WorldPackage = FindPackage(nullptr, *LevelName))
+	{
+		OnAsyncLoadGameWorldPackageLoaded(FName(LevelName), WorldPackage, EAsyncLoadingResult::Succeeded);
+	}
+	else
+	{
+		// See the comments in LoadGame about why we need to load the world package ahead of OpenLevel
+		UE_LOG(LogSpudSubsystem, Verbose, TEXT("Async loading map package: %s"), *LevelName);
+		LoadPackageAsync(LevelName,
+			FLoadPackageAsyncDelegate::CreateUObject(this, &USpudSubsystem::OnAsyncLoadGameWorldPackageLoaded));
+	}
+}
+
+void USpudSubsystem::OnAsyncLoadGameWorldPackageLoaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result)
+{
+	if (CurrentState != ESpudSystemState::LoadingGame)
+		return;
+
+	if (Result == EAsyncLoadingResult::Succeeded && Package != nullptr)
+	{
+		// Keep a reference to it to prevent GC
+		WorldToLoad = UWorld::FindWorldInPackage(Package);
+	}
+	else
+	{
+		// Carry on anyway, OpenLevel will try to load it again & report the problem
+		UE_LOG(LogSpudSubsystem, Warning, TEXT("Async load of map package %s failed"), *PackageName.ToString());
+	}
+
+	FinishLoadGame(SlotNameInProgress, TravelOptionsInProgress);
+}
+
+void USpudSubsystem::WaitForAsyncOperations()
+{
+	// Background reads & writes use the active state, so anything which is about to discard it has to let them finish
+	if (AsyncLoadGameResult.IsValid())
+	{
+		AsyncLoadGameResult.Wait();
+		AsyncLoadGameResult = TFuture<bool>();
+	}
+	if (AsyncSaveGameResult.IsValid())
+	{
+		AsyncSaveGameResult.Wait();
+		UpdateAsyncSaveGame();
+	}
+	// The screenshot doesn't use the state, but the save it's for can't be finished now
+	if (AsyncScreenshotResult.IsValid())
+	{
+		AsyncScreenshotResult.Wait();
+		AsyncScreenshotResult = TFuture<TArray<uint8>>();
+		SaveComplete(SlotNameInProgress, false);
+	}
+}
+
+void USpudSubsystem::FinishLoadGame(const FString& SlotName, const FString& TravelOptions)
+{
+	auto State = GetActiveState();
+
 	// Just do the reverse of what we did
 	// Global objects first before map, these should be only objects which survive map load
 	for (auto Ptr : GlobalObjects)
@@ -722,10 +1044,13 @@ void USpudSubsystem::LoadGame(const FString& SlotName, const FString& TravelOpti
 	}
 
 	// This is deferred, final load process will happen in PostLoadMap
+	// Take a copy first, TravelOptions may be TravelOptionsInProgress which is cleared below
+	const FString TravelOptionsCopy = TravelOptions;
 	SlotNameInProgress = SlotName;
+	TravelOptionsInProgress.Empty();
 	UE_LOG(LogSpudSubsystem, Verbose, TEXT("(Re)loading map: %s"), *State->GetPersistentLevel());
 	
-	UGameplayStatics::OpenLevel(GetWorld(), FName(State->GetPersistentLevel()), true, TravelOptions);
+	UGameplayStatics::OpenLevel(GetWorld(), FName(State->GetPersistentLevel()), true, TravelOptionsCopy);
 }
 
 
@@ -749,14 +1074,24 @@ bool USpudSubsystem::DeleteSave(const FString& SlotName)
 	// VIVI: Consoles require using the SaveGameSystem
 	ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
 
-	if (SaveSystem)
+	if (SaveSystem && SaveSystem->DeleteGame(false, *SlotName, 0))
 	{
-		return SaveSystem->DeleteGame(false, *SlotName, 0);
+		RemoveFromSlotIndex(SlotName);
+		return true;
 	}
 	return false;
 #else
+	const FString Filename = GetSaveGameFilePath(SlotName);
+	if (ActiveState && !ActiveState->ReleaseSourceFile(Filename))
+	{
+		UE_LOG(LogSpudSubsystem, Error, TEXT("Error while copying level data out of save game %s, not deleting it"), *Filename);
+		return false;
+	}
 	IFileManager& FileMgr = IFileManager::Get();
-	return FileMgr.Delete(*GetSaveGameFilePath(SlotName), false, true);
+	const bool bDeleted = FileMgr.Delete(*Filename, false, true);
+	if (bDeleted)
+		RemoveFromSlotIndex(SlotName);
+	return bDeleted;
 #endif
 }
 
@@ -937,6 +1272,46 @@ void USpudSubsystem::PostLoadStreamLevel(int32 LinkID)
 void USpudSubsystem::PostLoadStreamLevelGameThread(FName LevelName)
 {
 	PostLoadStreamingLevel.Broadcast(LevelName);
+	if (AsyncLoadGameResult.IsValid())
+		return;
+
+	if (bPreloadLevelAssets)
+	{
+		const TArray<FSoftObjectPath> Assets = GetActiveState()->GetLevelAssetsToPreload(LevelName.ToString());
+		if (Assets.Num() > 0)
+		{
+			UE_LOG(LogSpudSubsystem, Verbose, TEXT("Preloading %d assets before restoring %s"), Assets.Num(), *LevelName.ToString());
+			const uint32 PreloadID = ++LevelPreloadCounter;
+			PendingLevelPreloads.Add(LevelName, PreloadID);
+			// The handle keeps the assets loaded until the callback has returned, by which time the restore
+			// has made its own references to them
+			StreamableManager.RequestAsyncLoad(Assets, FStreamableDelegate::CreateWeakLambda(this, [this, LevelName, PreloadID]()
+			{
+				if (PendingLevelPreloads.FindRef(LevelName) == PreloadID)
+				{
+					PendingLevelPreloads.Remove(LevelName);
+					RestoreStreamLevel(LevelName);
+				}
+			}));
+			return;
+		}
+	}
+	RestoreStreamLevel(LevelName);
+}
+
+void USpudSubsystem::FinishLevelPreload(FName LevelName)
+{
+	// The preload callback does nothing once the entry has gone
+	if (PendingLevelPreloads.Remove(LevelName) > 0)
+		RestoreStreamLevel(LevelName);
+}
+
+void USpudSubsystem::RestoreStreamLevel(FName LevelName)
+{
+	// May have started loading a game since the restore was deferred
+	if (AsyncLoadGameResult.IsValid())
+		return;
+
 	auto StreamLevel = UGameplayStatics::GetStreamingLevel(GetWorld(), LevelName);
 
 	if (StreamLevel)
@@ -959,7 +1334,24 @@ void USpudSubsystem::PostLoadStreamLevelGameThread(FName LevelName)
 		// It's important to note that this streaming level won't be added to UWorld::Levels yet
 		// This is usually where things like the TActorIterator get actors from, ULevel::Actors
 		// we have the ULevel here right now, so restore it directly
-		GetActiveState()->RestoreLevel(Level);
+		LevelsRestoringTimeSliced.Remove(LevelName);
+		if (bTimeSlicedLevelRestore)
+		{
+			if (GetActiveState()->BeginIncrementalRestoreLevel(Level, GetRestoreViewLocation()))
+			{
+				// The rest happens in Tick; the level is shown now so the nearest actors are seen restored first
+				LevelsRestoringTimeSliced.Add(LevelName);
+				StreamLevel->SetShouldBeVisible(true);
+				// Actors can be destroyed while the restore is still going, which needs recording the same as after
+				SubscribeLevelObjectEvents(Level);
+				return;
+			}
+			// Otherwise there was nothing to restore
+		}
+		else
+		{
+			GetActiveState()->RestoreLevel(Level);
+		}
 
 		// NB: after restoring the level, we could release MOST of the memory for this level
 		// However, we don't for 2 reasons:
@@ -974,6 +1366,65 @@ void USpudSubsystem::PostLoadStreamLevelGameThread(FName LevelName)
 	}
 }
 
+void USpudSubsystem::UpdateTimeSlicedRestores()
+{
+	if (LevelsRestoringTimeSliced.Num() == 0)
+		return;
+
+	USpudState* State = GetActiveState();
+	State->UpdateIncrementalRestores(FMath::Max(LevelRestoreBudgetMs, 0.f) / 1000.0);
+
+	// Also picks up restores completed outside of this, e.g. by the level being stored for a save
+	TArray<FName> Completed;
+	for (const FName& LevelName : LevelsRestoringTimeSliced)
+	{
+		if (!State->IsIncrementalRestoreInProgress(LevelName.ToString()))
+			Completed.Add(LevelName);
+	}
+	for (const FName& LevelName : Completed)
+	{
+		FinishTimeSlicedRestore(LevelName);
+	}
+}
+
+void USpudSubsystem::FinishTimeSlicedRestore(FName LevelName)
+{
+	if (!LevelsRestoringTimeSliced.Remove(LevelName))
+		return;
+
+	// Fails if the level went away before the restore could complete
+	const bool bSucceeded = GetActiveState()->FinishIncrementalRestore(LevelName.ToString());
+	PostLevelRestore.Broadcast(LevelName.ToString(), bSucceeded);
+
+	UE_LOG(LogSpudSubsystem, Verbose, TEXT("Time sliced restore of %s %s"), *LevelName.ToString(), bSucceeded ? TEXT("complete") : TEXT("abandoned"));
+	IsRestoringState = LevelsRestoringTimeSliced.Num() > 0;
+}
+
+void USpudSubsystem::CancelTimeSlicedRestores()
+{
+	LevelsRestoringTimeSliced.Empty();
+	if (ActiveState)
+		ActiveState->CancelIncrementalRestores();
+}
+
+TOptional<FVector> USpudSubsystem::GetRestoreViewLocation() const
+{
+	const UWorld* World = GetWorld();
+	if (APlayerController* PC = World ? World->GetFirstPlayerController() : nullptr)
+	{
+		FVector Location;
+		FRotator Rotation;
+		PC->GetPlayerViewPoint(Location, Rotation);
+		return Location;
+	}
+	return TOptional<FVector>();
+}
+
+bool USpudSubsystem::IsLevelRestoreInProgress(const FString& LevelName) const
+{
+	return LevelsRestoringTimeSliced.Contains(FName(LevelName));
+}
+
 void USpudSubsystem::UnloadStreamLevel(FName LevelName)
 {
 	auto StreamLevel = UGameplayStatics::GetStreamingLevel(GetWorld(), LevelName);
@@ -1031,6 +1482,7 @@ void USpudSubsystem::UpdateRegisteredComps()
 
 void USpudSubsystem::ForceReset()
 {
+	WaitForAsyncOperations();
 	CurrentState = ESpudSystemState::RunningIdle;
 	IsRestoringState = false;
 }
@@ -1046,6 +1498,51 @@ int32 USpudSubsystem::GetUserDataModelVersion() const
 	return GCurrentUserDataModelVersion;
 }
 
+void USpudSubsystem::SetLevelDataCompressionFormat(FName Format)
+{
+	LevelDataCompressionFormat = Format;
+	GSpudLevelDataCompressionFormat = Format;
+}
+
+void USpudSubsystem::SetCompactEncoding(bool bCompact)
+{
+	bCompactEncoding = bCompact;
+	UpdateEncodingProfile();
+}
+
+void USpudSubsystem::SetIndexedObjectReferences(bool bIndexed)
+{
+	bIndexedObjectReferences = bIndexed;
+	UpdateEncodingProfile();
+}
+
+void USpudSubsystem::SetStoreArchetypeDeltas(bool bDeltas)
+{
+	bStoreArchetypeDeltas = bDeltas;
+	GSpudStoreArchetypeDeltas = bDeltas;
+}
+
+void USpudSubsystem::SetIncrementalLevelStore(bool bIncremental)
+{
+	bIncrementalLevelStore = bIncremental;
+	GSpudIncrementalLevelStore = bIncremental;
+}
+
+void USpudSubsystem::MarkSpudDirty(UObject* Obj)
+{
+	if (IsValid(Obj))
+		GetActiveState()->MarkObjectDirty(Obj);
+}
+
+void USpudSubsystem::UpdateEncodingProfile()
+{
+	GSpudEncodingProfile.bCompact = bCompactEncoding;
+	GSpudEncodingProfile.PositionQuantum = FMath::Max(CompactPositionQuantum, 0.f);
+	GSpudEncodingProfile.RotationQuantum = FMath::Max(CompactRotationQuantum, 0.f);
+	GSpudEncodingProfile.ScaleQuantum = FMath::Max(CompactScaleQuantum, 0.f);
+	GSpudEncodingProfile.bIndexedObjectRefs = bIndexedObjectReferences;
+}
+
 void USpudSubsystem::PostUnloadStreamLevel(int32 LinkID)
 {
 	FScopeLock PendingUnloadLock(&LevelsPendingUnloadMutex);
@@ -1198,26 +1695,32 @@ struct FSaveSorter
 	}
 };
 
-TArray<USpudSaveGameInfo*> USpudSubsystem::GetSaveGameList(bool bIncludeQuickSave, bool bIncludeAutoSave, ESpudSaveSorting Sorting)
+TArray<USpudSaveGameInfo*> USpudSubsystem::GetSaveGameList(bool bIncludeQuickSave, bool bIncludeAutoSave, ESpudSaveSorting Sorting, bool bIncludeThumbnails)
 {
+	TArray<FSpudSlotIndexEntry> Entries;
+	GetSlotIndexEntries(Entries, bIncludeThumbnails);
 
-	TArray<FString> SaveFiles;
-	ListSaveGameFiles(SaveFiles);
+	return MakeSaveGameList(Entries, bIncludeQuickSave, bIncludeAutoSave, Sorting);
+}
 
+TArray<USpudSaveGameInfo*> USpudSubsystem::MakeSaveGameList(const TArray<FSpudSlotIndexEntry>& Entries,
+                                                           bool bIncludeQuickSave,
+                                                           bool bIncludeAutoSave,
+                                                           ESpudSaveSorting Sorting)
+{
 	TArray<USpudSaveGameInfo*> Ret;
-	for (auto && File : SaveFiles)
+	for (auto && Entry : Entries)
 	{
-		FString SlotName = FPaths::GetBaseFilename(File);
-
-		if ((!bIncludeQuickSave && SlotName == SPUD_QUICKSAVE_SLOTNAME) ||
-			(!bIncludeAutoSave && SlotName == SPUD_AUTOSAVE_SLOTNAME))
+		if ((!bIncludeQuickSave && Entry.SlotName == SPUD_QUICKSAVE_SLOTNAME) ||
+			(!bIncludeAutoSave && Entry.SlotName == SPUD_AUTOSAVE_SLOTNAME))
 		{
 			continue;			
 		}
 
-		auto Info = GetSaveGameInfo(SlotName);
-		if (Info)
-			Ret.Add(Info);
+		auto Info = NewObject<USpudSaveGameInfo>();
+		Info->SlotName = Entry.SlotName;
+		USpudState::PopulateSaveGameInfo(Entry.Info, *Info);
+		Ret.Add(Info);
 	}
 
 	if (Sorting != ESpudSaveSorting::None)
@@ -1299,14 +1802,20 @@ USpudSaveGameInfo* USpudSubsystem::GetSaveGameInfo(const FString& SlotName)
 
 USpudSaveGameInfo* USpudSubsystem::GetLatestSaveGame()
 {
-	auto SaveGameList = GetSaveGameList();
-	USpudSaveGameInfo* Best = nullptr;
-	for (auto Curr : SaveGameList)
-	{
-		if (!Best || Curr->Timestamp > Best->Timestamp)
-			Best = Curr;		
-	}
-	return Best;
+	TArray<FSpudSlotIndexEntry> Entries;
+	GetSlotIndexEntries(Entries);
+	const auto Latest = SpudFindLatestSlotEntry(Entries);
+	if (!Latest)
+		return nullptr;
+
+	// Only need the one thumbnail
+	FSpudSaveInfo LatestInfo = Latest->Info;
+	ReadSaveThumbnailData(Latest->SlotName, LatestInfo.Screenshot.ImageData);
+	
+	auto Info = NewObject<USpudSaveGameInfo>();
+	Info->SlotName = Latest->SlotName;
+	USpudState::PopulateSaveGameInfo(LatestInfo, *Info);
+	return Info;
 }
 
 
@@ -1339,6 +1848,7 @@ void USpudSubsystem::ListSaveGameFiles(TArray<FString>& OutSaveFileList)
 	if (SaveSystem)
 	{
 		SaveSystem->GetSaveGameNames(OutSaveFileList, 0);
+		OutSaveFileList.Remove(TEXT(SPUD_SLOTINDEX_SLOTNAME));
 	}
 #else
 	IFileManager& FM = IFileManager::Get();
@@ -1347,6 +1857,303 @@ void USpudSubsystem::ListSaveGameFiles(TArray<FString>& OutSaveFileList)
 #endif
 }
 
+FString USpudSubsystem::GetSlotIndexFilePath()
+{
+	return FString::Printf(TEXT("%sSpudSlotIndex.idx"), *GetSaveGameDirectory());
+}
+
+// There's only one save game directory, so the slot index is shared by everything listing saves, on any thread
+static FSpudSlotIndex GSpudSlotIndex;
+static bool GSpudSlotIndexLoaded = false;
+static FCriticalSection GSpudSlotIndexMutex;
+
+/// Read the slot index if that hasn't been done yet. Must be holding GSpudSlotIndexMutex
+static void SpudLoadSlotIndex()
+{
+	if (GSpudSlotIndexLoaded)
+		return;
+
+	GSpudSlotIndexLoaded = true;
+	GSpudSlotIndex.Reset();
+	bool bError = false;
+
+#ifdef USE_SAVEGAMESYSTEM
+	// VIVI: Consoles require using the SaveGameSystem
+	ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+	TArray<uint8> InData;
+	if (SaveSystem &&
+		SaveSystem->DoesSaveGameExist(TEXT(SPUD_SLOTINDEX_SLOTNAME), 0) &&
+		SaveSystem->LoadGame(false, TEXT(SPUD_SLOTINDEX_SLOTNAME), 0, InData))
+	{
+		auto Archive = FMemoryReader(InData, true);
+		FSpudChunkedDataArchive ChunkedAr(Archive);
+		GSpudSlotIndex.ReadFromArchive(ChunkedAr, SPUD_CURRENT_SYSTEM_VERSION);
+		bError = Archive.IsError() || Archive.IsCriticalError();
+	}
+#else
+	IFileManager& FM = IFileManager::Get();
+	auto Archive = TUniquePtr<FArchive>(FM.CreateFileReader(*USpudSubsystem::GetSlotIndexFilePath()));
+	if (Archive)
+	{
+		FSpudChunkedDataArchive ChunkedAr(*Archive);
+		GSpudSlotIndex.ReadFromArchive(ChunkedAr, SPUD_CURRENT_SYSTEM_VERSION);
+		Archive->Close();
+		bError = Archive->IsError() || Archive->IsCriticalError();
+	}
+#endif
+
+	if (bError)
+	{
+		// Not a problem, everything will just be read from the saves again
+		UE_LOG(LogSpudSubsystem, Warning, TEXT("Save slot index is damaged, rebuilding"));
+		GSpudSlotIndex.Reset();
+	}
+}
+
+/// Write the slot index. Must be holding GSpudSlotIndexMutex
+static void SpudSaveSlotIndex()
+{
+#ifdef USE_SAVEGAMESYSTEM
+	// VIVI: Consoles require using the SaveGameSystem
+	ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+	if (SaveSystem)
+	{
+		TArray<uint8> OutData;
+		auto Archive = FMemoryWriter(OutData, true);
+		FSpudChunkedDataArchive ChunkedAr(Archive);
+		GSpudSlotIndex.WriteToArchive(ChunkedAr);
+		Archive.Close();
+
+		if (!SaveSystem->SaveGame(false, TEXT(SPUD_SLOTINDEX_SLOTNAME), 0, OutData))
+		{
+			UE_LOG(LogSpudSubsystem, Error, TEXT("Error while writing save slot index"));
+		}
+	}
+#else
+	IFileManager& FM = IFileManager::Get();
+	const FString Filename = USpudSubsystem::GetSlotIndexFilePath();
+	auto Archive = TUniquePtr<FArchive>(FM.CreateFileWriter(*Filename));
+	if (!Archive)
+	{
+		UE_LOG(LogSpudSubsystem, Error, TEXT("Error while creating save slot index %s"), *Filename);
+		return;
+	}
+
+	FSpudChunkedDataArchive ChunkedAr(*Archive);
+	GSpudSlotIndex.WriteToArchive(ChunkedAr);
+	Archive->Close();
+
+	if (Archive->IsError() || Archive->IsCriticalError())
+	{
+		UE_LOG(LogSpudSubsystem, Error, TEXT("Error while writing save slot index %s"), *Filename);
+		// Don't leave a partial index behind
+		Archive.Reset();
+		FM.Delete(*Filename, false, true, true);
+	}
+#endif
+}
+
+/// Read just the info for a save slot from the save itself
+static bool SpudReadSlotInfo(const FString& SlotName, FSpudSaveInfo& OutInfo, bool bIncludeScreenshot)
+{
+#ifdef USE_SAVEGAMESYSTEM
+	// VIVI: Consoles require using the SaveGameSystem
+	ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+	TArray<uint8> InSaveData;
+	// The Save Game System has to give us the entire thing, but at least we only do this when a save has changed
+	if (!SaveSystem || !SaveSystem->LoadGame(false, *SlotName, 0, InSaveData))
+	{
+		UE_LOG(LogSpudSubsystem, Error, TEXT("Unable to open slot %s for reading info"), *SlotName);
+		return false;
+	}
+	auto Archive = FMemoryReader(InSaveData, true);
+	FSpudChunkedDataArchive ChunkedAr(Archive);
+	const bool bResult = FSpudSaveData::ReadSaveInfoFromArchive(ChunkedAr, OutInfo, bIncludeScreenshot);
+	// Offsets within the save data are no use to us, we can't read part of a platform save
+	OutInfo.Screenshot.ImageDataOffset = -1;
+	return bResult;
+#else
+	IFileManager& FM = IFileManager::Get();
+	const FString Filename = USpudSubsystem::GetSaveGameFilePath(SlotName);
+	auto Archive = TUniquePtr<FArchive>(FM.CreateFileReader(*Filename));
+	if (!Archive)
+	{
+		UE_LOG(LogSpudSubsystem, Error, TEXT("Unable to open %s for reading info"), *Filename);
+		return false;
+	}
+	FSpudChunkedDataArchive ChunkedAr(*Archive);
+	const bool bResult = FSpudSaveData::ReadSaveInfoFromArchive(ChunkedAr, OutInfo, bIncludeScreenshot);
+	Archive->Close();
+	return bResult;
+#endif
+}
+
+/// Make sure the slot index entry for a save is up to date, re-reading the save info if it's new or has changed.
+/// Returns the entry, or null if the save can't be read. Must be holding GSpudSlotIndexMutex
+static FSpudSlotIndexEntry* SpudRefreshSlotIndexEntry(const FString& SlotName, bool& bOutIndexChanged)
+{
+	FSpudSlotIndexEntry* Existing = GSpudSlotIndex.Contents.Find(SlotName);
+#ifdef USE_SAVEGAMESYSTEM
+	// No way to tell if a save has changed behind our back, but we always update the index when we save
+	const int64 FileSize = -1;
+	const FDateTime FileTimestamp = FDateTime::MinValue();
+	if (Existing)
+		return Existing;
+#else
+	const FFileStatData Stat = IFileManager::Get().GetStatData(*USpudSubsystem::GetSaveGameFilePath(SlotName));
+	if (!Stat.bIsValid)
+		return nullptr;
+	const int64 FileSize = Stat.FileSize;
+	const FDateTime FileTimestamp = Stat.ModificationTime;
+	if (Existing && Existing->FileSize == FileSize && Existing->FileTimestamp == FileTimestamp)
+		return Existing;
+#endif
+
+	// New or changed save, read its info (but not the screenshot)
+	bOutIndexChanged = true;
+	FSpudSlotIndexEntry Entry;
+	Entry.SlotName = SlotName;
+	Entry.FileSize = FileSize;
+	Entry.FileTimestamp = FileTimestamp;
+	if (!SpudReadSlotInfo(SlotName, Entry.Info, false))
+	{
+		GSpudSlotIndex.Contents.Remove(SlotName);
+		return nullptr;
+	}
+	return &GSpudSlotIndex.Contents.Add(SlotName, MoveTemp(Entry));
+}
+
+/// Load the screenshot image data for an up to date slot index entry
+static bool SpudReadSlotScreenshot(const FSpudSlotIndexEntry& Entry, TArray<uint8>& OutImageData)
+{
+	const FSpudScreenshot& Screenshot = Entry.Info.Screenshot;
+	if (!Screenshot.HasImage())
+		return false;
+
+	if (Screenshot.ImageDataOffset >= 0)
+	{
+		// Just read the image straight out of the save
+		IFileManager& FM = IFileManager::Get();
+		auto Archive = TUniquePtr<FArchive>(FM.CreateFileReader(*USpudSubsystem::GetSaveGameFilePath(Entry.SlotName)));
+		if (Archive)
+		{
+			OutImageData.SetNumUninitialized(Screenshot.ImageDataSize);
+			Archive->Seek(Screenshot.ImageDataOffset);
+			Archive->Serialize(OutImageData.GetData(), Screenshot.ImageDataSize);
+			Archive->Close();
+			if (!Archive->IsError() && !Archive->IsCriticalError())
+				return true;
+		}
+	}
+
+	// Location unknown, read the info again including the screenshot
+	FSpudSaveInfo Info;
+	if (SpudReadSlotInfo(Entry.SlotName, Info, true) && Info.Screenshot.ImageData.Num() > 0)
+	{
+		OutImageData = MoveTemp(Info.Screenshot.ImageData);
+		return true;
+	}
+
+	UE_LOG(LogSpudSubsystem, Error, TEXT("Unable to read thumbnail for slot %s"), *Entry.SlotName);
+	OutImageData.Empty();
+	return false;
+}
+
+void USpudSubsystem::GetSlotIndexEntries(TArray<FSpudSlotIndexEntry>& OutEntries, bool bIncludeScreenshots)
+{
+	{
+		FScopeLock Lock(&GSpudSlotIndexMutex);
+		SpudLoadSlotIndex();
+
+		TArray<FString> SaveFiles;
+		ListSaveGameFiles(SaveFiles);
+
+		TSet<FString> SlotNames;
+		bool bIndexChanged = false;
+		OutEntries.Empty(SaveFiles.Num());
+		for (auto && File : SaveFiles)
+		{
+			FString SlotName = FPaths::GetBaseFilename(File);
+			SlotNames.Add(SlotName);
+
+			if (const auto Entry = SpudRefreshSlotIndexEntry(SlotName, bIndexChanged))
+				OutEntries.Add(*Entry);
+		}
+
+		// Forget about saves which have gone
+		for (auto It = GSpudSlotIndex.Contents.CreateIterator(); It; ++It)
+		{
+			if (!SlotNames.Contains(It.Key()))
+			{
+				It.RemoveCurrent();
+				bIndexChanged = true;
+			}
+		}
+
+		if (bIndexChanged)
+			SpudSaveSlotIndex();
+	}
+
+	if (bIncludeScreenshots)
+	{
+		for (auto& Entry : OutEntries)
+		{
+			SpudReadSlotScreenshot(Entry, Entry.Info.Screenshot.ImageData);
+		}
+	}
+}
+
+bool USpudSubsystem::ReadSaveThumbnailData(const FString& SlotName, TArray<uint8>& OutImageData)
+{
+	FSpudSlotIndexEntry Entry;
+	{
+		FScopeLock Lock(&GSpudSlotIndexMutex);
+		SpudLoadSlotIndex();
+
+		bool bIndexChanged = false;
+		const auto Existing = SpudRefreshSlotIndexEntry(SlotName, bIndexChanged);
+		if (bIndexChanged)
+			SpudSaveSlotIndex();
+		if (!Existing)
+			return false;
+		Entry = *Existing;
+	}
+
+	return SpudReadSlotScreenshot(Entry, OutImageData);
+}
+
+void USpudSubsystem::UpdateSlotIndex(const FString& SlotName, const FSpudSaveInfo& Info)
+{
+	FScopeLock Lock(&GSpudSlotIndexMutex);
+	SpudLoadSlotIndex();
+
+#ifdef USE_SAVEGAMESYSTEM
+	// Reading back a platform save means loading all of it, so just use what we saved
+	FSpudSlotIndexEntry& Entry = GSpudSlotIndex.Contents.FindOrAdd(SlotName);
+	Entry.SlotName = SlotName;
+	Entry.Info = Info;
+	Entry.Info.Screenshot.ImageDataSize = Info.Screenshot.ImageData.Num();
+	Entry.Info.Screenshot.ImageDataOffset = -1;
+	Entry.Info.Screenshot.ImageData.Empty();
+#else
+	// Read back the info from the file we just wrote, which is cheap and tells us where the screenshot is
+	GSpudSlotIndex.Contents.Remove(SlotName);
+	bool bIndexChanged = false;
+	SpudRefreshSlotIndexEntry(SlotName, bIndexChanged);
+#endif
+
+	SpudSaveSlotIndex();
+}
+
+void USpudSubsystem::RemoveFromSlotIndex(const FString& SlotName)
+{
+	FScopeLock Lock(&GSpudSlotIndexMutex);
+	SpudLoadSlotIndex();
+
+	if (GSpudSlotIndex.Contents.Remove(SlotName) > 0)
+		SpudSaveSlotIndex();
+}
+
 FString USpudSubsystem::GetActiveGameFolder()
 {
 	return FString::Printf(TEXT("%sCurrentGame/"), *FPaths::ProjectSavedDir());
@@ -1438,6 +2245,11 @@ public:
 									{
 										UE_LOG(LogSpudSubsystem, Error, TEXT("Error while upgrading save %s"), *SaveFile);
 									}
+									else
+									{
+										// Can't detect changes to platform saves, so make sure the info is re-read
+										USpudSubsystem::RemoveFromSlotIndex(SaveFile);
+									}
 								}
 							}
 						}
@@ -1533,6 +2345,131 @@ void USpudSubsystem::UpgradeAllSaveGames(bool bUpgradeEvenIfNoUserDataModelVersi
 	}
 }
 
+class FGetSaveGameListAction : public FPendingLatentAction
+{
+public:
+	FName ExecutionFunction;
+	int32 OutputLink;
+	FWeakObjectPtr CallbackTarget;
+
+	bool bIncludeQuickSave;
+	bool bIncludeAutoSave;
+	ESpudSaveSorting Sorting;
+	TArray<USpudSaveGameInfo*>& OutSaveGames;
+	TFuture<TArray<FSpudSlotIndexEntry>> Result;
+
+	FGetSaveGameListAction(bool InIncludeQuickSave, bool InIncludeAutoSave, ESpudSaveSorting InSorting, bool bIncludeThumbnails, TArray<USpudSaveGameInfo*>& InOutSaveGames, const FLatentActionInfo& LatentInfo)
+		: ExecutionFunction(LatentInfo.ExecutionFunction)
+		, OutputLink(LatentInfo.Linkage)
+		, CallbackTarget(LatentInfo.CallbackTarget)
+		, bIncludeQuickSave(InIncludeQuickSave)
+		, bIncludeAutoSave(InIncludeAutoSave)
+		, Sorting(InSorting)
+		, OutSaveGames(InOutSaveGames)
+	{
+		// All the file access happens in the background
+		Result = Async(EAsyncExecution::ThreadPool, [bIncludeThumbnails]()
+		{
+			TArray<FSpudSlotIndexEntry> Entries;
+			USpudSubsystem::GetSlotIndexEntries(Entries, bIncludeThumbnails);
+			return Entries;
+		});
+	}
+
+	virtual void UpdateOperation(FLatentResponse& Response) override
+	{
+		if (!Result.IsReady())
+			return;
+
+		// Info objects & thumbnail textures have to be created here on the game thread
+		OutSaveGames = USpudSubsystem::MakeSaveGameList(Result.Get(), bIncludeQuickSave, bIncludeAutoSave, Sorting);
+		Response.FinishAndTriggerIf(true, ExecutionFunction, OutputLink, CallbackTarget);
+	}
+
+#if WITH_EDITOR
+	virtual FString GetDescription() const override
+	{
+		return "Get Save Game List";
+	}
+#endif
+};
+
+void USpudSubsystem::GetSaveGameListAsync(bool bIncludeQuickSave,
+                                          bool bIncludeAutoSave,
+                                          ESpudSaveSorting Sorting,
+                                          bool bIncludeThumbnails,
+                                          TArray<USpudSaveGameInfo*>& SaveGames,
+                                          FLatentActionInfo LatentInfo)
+{
+	FLatentActionManager& LatentActionManager = GetGameInstance()->GetLatentActionManager();
+	if (LatentActionManager.FindExistingAction<FGetSaveGameListAction>(LatentInfo.CallbackTarget, LatentInfo.UUID) == nullptr)
+	{
+		LatentActionManager.AddNewAction(LatentInfo.CallbackTarget, LatentInfo.UUID,
+		                                 new FGetSaveGameListAction(bIncludeQuickSave, bIncludeAutoSave, Sorting,
+		                                                            bIncludeThumbnails, SaveGames, LatentInfo));
+	}
+}
+
+class FLoadSaveThumbnailAction : public FPendingLatentAction
+{
+public:
+	FName ExecutionFunction;
+	int32 OutputLink;
+	FWeakObjectPtr CallbackTarget;
+
+	UTexture2D*& OutThumbnail;
+	TFuture<FImage> Result;
+
+	FLoadSaveThumbnailAction(const FString& SlotName, UTexture2D*& InOutThumbnail, const FLatentActionInfo& LatentInfo)
+		: ExecutionFunction(LatentInfo.ExecutionFunction)
+		, OutputLink(LatentInfo.Linkage)
+		, CallbackTarget(LatentInfo.CallbackTarget)
+		, OutThumbnail(InOutThumbnail)
+	{
+		// Read & decode in the background
+		Result = Async(EAsyncExecution::ThreadPool, [SlotName]()
+		{
+			FImage Image;
+			TArray<uint8> ImageData;
+			if (USpudSubsystem::ReadSaveThumbnailData(SlotName, ImageData) &&
+				!FImageUtils::DecompressImage(ImageData.GetData(), ImageData.Num(), Image))
+			{
+				UE_LOG(LogSpudSubsystem, Error, TEXT("Unable to decode thumbnail for slot %s"), *SlotName);
+				Image = FImage();
+			}
+			return Image;
+		});
+	}
+
+	virtual void UpdateOperation(FLatentResponse& Response) override
+	{
+		if (!Result.IsReady())
+			return;
+
+		// Only the texture has to be created on the game thread
+		const FImage& Image = Result.Get();
+		OutThumbnail = Image.GetNumPixels() > 0 ? FImageUtils::CreateTexture2DFromImage(Image) : nullptr;
+		Response.FinishAndTriggerIf(true, ExecutionFunction, OutputLink, CallbackTarget);
+	}
+
+#if WITH_EDITOR
+	virtual FString GetDescription() const override
+	{
+		return "Load Save Thumbnail";
+	}
+#endif
+};
+
+void USpudSubsystem::LoadSaveThumbnail(const FString& SlotName, UTexture2D*& Thumbnail, FLatentActionInfo LatentInfo)
+{
+	FLatentActionManager& LatentActionManager = GetGameInstance()->GetLatentActionManager();
+	if (LatentActionManager.FindExistingAction<FLoadSaveThumbnailAction>(LatentInfo.CallbackTarget, LatentInfo.UUID) == nullptr)
+	{
+		LatentActionManager.AddNewAction(LatentInfo.CallbackTarget, LatentInfo.UUID,
+		                                 new FLoadSaveThumbnailAction(SlotName, Thumbnail, LatentInfo));
+	}
+}
+
 USpudCustomSaveInfo* USpudSubsystem::CreateCustomSaveInfo()
 {
 	return NewObject<USpudCustomSaveInfo>();
@@ -1545,6 +2482,11 @@ USpudCustomSaveInfo* USpudSubsystem::CreateCustomSaveInfo()
 
 void USpudSubsystem::Tick(float DeltaTime)
 {
+	UpdateAsyncLoadGame();
+	UpdateAsyncSaveGame();
+	UpdateAsyncScreenshot();
+	UpdateTimeSlicedRestores();
+
 	if (ScreenshotTimeout > 0)
 	{
 		ScreenshotTimeout -= DeltaTime;
@@ -63,6 +63,17 @@ public:
 	/// Allows deciding if an object should be skipped at runtime.
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "SPUD Interface")
 	bool ShouldSkip() const; virtual bool ShouldSkip_Implementation() const { return false; }
+
+	/// Return true if this object promises to call MarkSpudDirty whenever its SaveGame properties or custom data change.
+	/// When a level is stored incrementally (USpudSubsystem::bIncrementalLevelStore), an object which hasn't been
+	/// marked dirty since it was last stored or restored only has its core data (transform etc) updated; its
+	/// properties aren't visited at all, and no store callbacks are made.
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent, Category = "SPUD Interface")
+	bool UsesSpudDirtyTracking() const; virtual bool UsesSpudDirtyTracking_Implementation() const { return false; }
+
+	/// Tell SPUD that the persistent state of this object has changed, if it uses dirty tracking (@see UsesSpudDirtyTracking)
+	/// Blueprints can use USpudSubsystem::MarkSpudDirty instead.
+	void MarkSpudDirty();
 };
 
 UINTERFACE(MinimalAPI)
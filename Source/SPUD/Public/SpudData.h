@@ -5,6 +5,11 @@
 DECLARE_LOG_CATEGORY_EXTERN(LogSpudData, Verbose, Verbose);
 
 extern int32 GCurrentUserDataModelVersion;
+/// Compression format (as used by FCompression) to use when writing level data, or NAME_None for no compression
+extern SPUD_API FName GSpudLevelDataCompressionFormat;
+
+// System version covers our internal format changes
+#define SPUD_CURRENT_SYSTEM_VERSION 4
 
 // Chunk IDs
 #define SPUDDATA_SAVEGAME_MAGIC "SAVE"
@@ -17,12 +22,15 @@ extern int32 GCurrentUserDataModelVersion;
 #define SPUDDATA_CLASSDEF_MAGIC "CDEF"
 #define SPUDDATA_CLASSNAMEINDEX_MAGIC "CNIX"
 #define SPUDDATA_PROPERTYNAMEINDEX_MAGIC "PNIX"
+#define SPUDDATA_OBJECTREFINDEX_MAGIC "ORIX"
+#define SPUDDATA_ASSETPATHINDEX_MAGIC "APIX"
 #define SPUDDATA_VERSIONINFO_MAGIC "VERS"
 #define SPUDDATA_NAMEDOBJECT_MAGIC "NOBJ"
 #define SPUDDATA_SPAWNEDACTOR_MAGIC "SPWN"
 #define SPUDDATA_DESTROYEDACTOR_MAGIC "KILL"
 #define SPUDDATA_LEVELDATAMAP_MAGIC "LVLS"
 #define SPUDDATA_LEVELDATA_MAGIC "LEVL"
+#define SPUDDATA_COMPRESSEDLEVELDATA_MAGIC "LVLZ"
 #define SPUDDATA_GLOBALDATA_MAGIC "GLOB"
 #define SPUDDATA_GLOBALOBJECTLIST_MAGIC "GOBS"
 #define SPUDDATA_LEVELACTORLIST_MAGIC "LATS"
@@ -33,6 +41,12 @@ extern int32 GCurrentUserDataModelVersion;
 // custom per-object data
 #define SPUDDATA_CUSTOMDATA_MAGIC "CUST" 
 #define SPUDDATA_COREACTORDATA_MAGIC "CORA"
+// table of contents, and the fixed-size pointer to it at the end of the save
+#define SPUDDATA_TABLEOFCONTENTS_MAGIC "TOCS"
+#define SPUDDATA_TABLEOFCONTENTSPTR_MAGIC "TOCP"
+// index of save slot info, stored alongside the saves rather than in them
+#define SPUDDATA_SLOTINDEX_MAGIC "SIDX"
+#define SPUDDATA_SLOTINDEXENTRY_MAGIC "SLOT"
 
 #define SPUDDATA_INDEX_NONE 0xFFFFFFFF
 #define SPUDDATA_PROPERTYID_NONE 0xFFFFFFFF
@@ -56,6 +70,8 @@ extern int32 GCurrentUserDataModelVersion;
 // - Save Info Chunk
 // - Global Data Chunk
 // - Level Chunks x N
+// - Table of Contents Chunk (optional, older saves don't have it)
+// - Table of Contents Pointer Chunk (optional, fixed size, always last so it can be found from the end)
 
 // Save Info is a chunk of the minimal data needed to describe the save game, for easy access to a description of the
 // save. Global Data includes what map the player is on, and the state of global objects like GameInstance.
@@ -97,13 +113,79 @@ enum SPUD_API ESpudStorageType // (stored as uint16 but not using enum class to
 
 	// - Values 0x1000 upwards are flags
 	/// ArrayOf type is bitwise combined with other types to indicate multiple elements
-	/// 1. Element Count (uint16 - max 65536 elements)
+	/// 1. Element Count (uint16 - max 65535 elements, unless ESST_VarCount)
 	/// 2. Data x Element Count
 	ESST_ArrayOf = 0x1000,
+	/// Combined with ESST_ArrayOf to indicate the element count is a variable length (LEB128) integer instead of
+	/// a uint16, so no size limit & 1 byte for arrays < 128 elements. All arrays are written this way now, data
+	/// without the flag is from older saves. This is an encoding detail, not part of the type when comparing
+	ESST_VarCount = 0x2000,
+	/// SetOf is combined with the element type like ArrayOf, always with ESST_VarCount
+	/// 1. Element Count (variable length)
+	/// 2. Data x Element Count
+	ESST_SetOf = 0x4000,
+	/// MapOf is combined with both the key type (bits 0-5) and value type (bits 6-11), see SpudMakeMapDataType.
+	/// Always with ESST_VarCount
+	/// 1. Pair Count (variable length)
+	/// 2. Key Data x Pair Count
+	/// 3. Value Data x Pair Count
+	ESST_MapOf = 0x8000,
 	ESST_Single = 0x0 // to indicate not an array, useful sometimes
 	
 };
 
+/// Build the stored type of a map from the key & value types, which must both be < 64
+inline uint16 SpudMakeMapDataType(uint16 KeyType, uint16 ValueType)
+{
+	return ESST_MapOf | ESST_VarCount | (KeyType & 0x3F) | ((ValueType & 0x3F) << 6);
+}
+inline uint16 SpudGetMapKeyType(uint16 MapDataType) { return MapDataType & 0x3F; }
+inline uint16 SpudGetMapValueType(uint16 MapDataType) { return (MapDataType >> 6) & 0x3F; }
+
+/// Codecs used in compressed chunks. Stored as uint8, so never change existing values
+enum SPUD_API ESpudCompressionCodec
+{
+	ESCC_None = 0,
+	ESCC_Zlib = 1,
+	ESCC_Gzip = 2,
+	ESCC_LZ4 = 3,
+	ESCC_Oodle = 4
+};
+
+/// Get the stored codec for an FCompression format name, ESCC_None if not supported
+SPUD_API uint8 SpudCompressionFormatToCodec(FName Format);
+/// Get the FCompression format name for a stored codec, NAME_None if not supported
+SPUD_API FName SpudCompressionCodecToFormat(uint8 Codec);
+
+/// Flags stored after the properties in a class definition. Stored as uint8, so never change existing values
+enum ESpudClassDefFlags
+{
+	ESCDF_None = 0,
+	/// Property & core actor data for this class uses the compact encoding, quantization steps follow the flags
+	ESCDF_Compact = 0x01,
+	/// Actor references are stored as indexes into FSpudClassMetadata::ObjectRefIndex instead of strings
+	ESCDF_IndexedObjectRefs = 0x02
+};
+
+/// How property & core actor data is encoded. This is recorded in each class definition, so data written with any
+/// profile can always be read back, and a class keeps the profile it was first written with in a given save.
+struct SPUD_API FSpudEncodingProfile
+{
+	/// Integers are written as variable length (zig-zag for signed) values, bool arrays are bit-packed and
+	/// zero velocities are omitted from core actor data
+	bool bCompact = false;
+	/// Quantization step for vectors & translations, 0 for full precision. Compact only
+	float PositionQuantum = 0;
+	/// Quantization step in degrees for rotators & rotations, 0 for full precision. Compact only
+	float RotationQuantum = 0;
+	/// Quantization step for transform scale, 0 for full precision. Compact only
+	float ScaleQuantum = 0;
+	/// Actor references are written as indexes into the metadata's reference table, rather than as name / GUID strings
+	bool bIndexedObjectRefs = false;
+};
+/// Encoding used for class definitions created from now on
+extern SPUD_API FSpudEncodingProfile GSpudEncodingProfile;
+
 /// Common header for all data types
 struct SPUD_API FSpudChunkHeader
 {
@@ -239,7 +321,7 @@ struct SPUD_API FSpudPropertyDef
 struct SPUD_API FSpudVersionInfo : public FSpudChunk
 {
 	// Signed for blueprint compat (user version might be set from BP)
-	int32 Version;
+	int32 Version = 0;
 
 
 	virtual const char* GetMagic() const override { return SPUDDATA_VERSIONINFO_MAGIC; }
@@ -258,6 +340,8 @@ struct SPUD_API FSpudClassDef : public FSpudChunk
 		TMap<uint32, int>> PropertyLookup; // Property Name ID -> Index
 	/// Actual property storage, these indexes are what actual instances store offsets against
 	TArray<FSpudPropertyDef> Properties;
+	/// How data for instances of this class is encoded
+	FSpudEncodingProfile Encoding;
 
 	virtual const char* GetMagic() const override{ return SPUDDATA_CLASSDEF_MAGIC; }
 	
@@ -312,6 +396,10 @@ struct SPUD_API FSpudPropertyData : public FSpudChunk
 	// (string lengths, array lengths can vary)
 	TArray<uint32> PropertyOffsets;
 	TArray<uint8> Data;
+	/// Only used when properties were stored as a delta against the object's archetype: one bit per entry in
+	/// PropertyOffsets, set if the property has data, clear if it was identical to the archetype so nothing was
+	/// written. Empty means all properties have data.
+	TBitArray<> PresentProperties;
 	
 	virtual const char* GetMagic() const override { return SPUDDATA_PROPERTYDATA_MAGIC; }
 	virtual void WriteToArchive(FSpudChunkedDataArchive& Ar) override;
@@ -343,6 +431,12 @@ struct SPUD_API FSpudObjectData : public FSpudChunk
 	FSpudCustomData CustomData;
 	// ID for the ClassName (see FSpudClassNameIndex) 
 	uint32 ClassID; 
+	/// non-persistent; set when the object is stored, so that an incremental level store can tell which records
+	/// belong to actors which no longer exist
+	bool bStored = false;
+	/// non-persistent; the dirty generation of the object when it was last stored to / restored from this record,
+	/// 0 if unknown (@see ISpudObject::MarkSpudDirty)
+	uint32 StoredDirtyGeneration = 0;
 };
 
 
@@ -352,8 +446,9 @@ struct SPUD_API FSpudNamedObjectData : public FSpudObjectData
 {
 	FString Name;
 
-	/// Key value for indexing this item; name is unique in the level
-	FString Key() const { return Name; }
+	/// Key value for indexing this item; name is unique in the level. Maps are keyed by FName so that lookups for
+	/// actors which aren't overriding their name don't need to convert it to a string
+	FName Key() const { return FName(*Name); }
 
 	virtual const char* GetMagic() const override { return SPUDDATA_NAMEDOBJECT_MAGIC; }
 	virtual void WriteToArchive(FSpudChunkedDataArchive& Ar) override;
@@ -365,8 +460,8 @@ struct SPUD_API FSpudSpawnedActorData : public FSpudObjectData
 {
 	FGuid Guid;
 
-	/// Key value for indexing this item; name is unique in the level
-	FString Key() const { return Guid.ToString(SPUDDATA_GUID_KEY_FORMAT); }
+	/// Key value for indexing this item; GUID is unique in the level
+	FGuid Key() const { return Guid; }
 
 	virtual const char* GetMagic() const override { return SPUDDATA_SPAWNEDACTOR_MAGIC; }
 	virtual void WriteToArchive(FSpudChunkedDataArchive& Ar) override;
@@ -497,7 +592,7 @@ struct FSpudArray : public FSpudChunk
 	
 };
 
-struct FSpudNamedObjectMap : public FSpudStructMapData<FString /* FName or Guid String */, FSpudNamedObjectData>
+struct FSpudNamedObjectMap : public FSpudStructMapData<FName /* FName, overridden name or Guid String */, FSpudNamedObjectData>
 {
 	virtual bool RenameObject(const FString& OldName, const FString& NewName);
 };
@@ -513,7 +608,7 @@ struct FSpudLevelActorMap : public FSpudNamedObjectMap
 	virtual const char* GetChildMagic() const override { return SPUDDATA_NAMEDOBJECT_MAGIC; }
 };
 
-struct FSpudSpawnedActorMap : public FSpudStructMapData<FString /*GUID String*/, FSpudSpawnedActorData>
+struct FSpudSpawnedActorMap : public FSpudStructMapData<FGuid, FSpudSpawnedActorData>
 {
 	virtual const char* GetMagic() const override { return SPUDDATA_SPAWNEDACTORLIST_MAGIC; }
 	virtual const char* GetChildMagic() const override { return SPUDDATA_SPAWNEDACTOR_MAGIC; }
@@ -626,6 +721,69 @@ struct FSpudPropertyNameIndex : public FSpudIndex<FString>
 	virtual const char* GetMagic() const override { return SPUDDATA_PROPERTYNAMEINDEX_MAGIC; }
 };
 
+/// How an FSpudObjectRef identifies its actor. Stored as uint8, so never change existing values
+enum class ESpudObjectRefType : uint8
+{
+	Guid = 0,
+	LevelName = 1
+};
+
+/// A stored reference to an actor: a runtime actor by its SpudGuid, or a level actor by name
+struct SPUD_API FSpudObjectRef
+{
+	ESpudObjectRefType Type = ESpudObjectRefType::LevelName;
+	/// Identifies runtime actors
+	FGuid ActorGuid;
+	/// Identifies level actors, either their FName or ISpudObject::OverrideName
+	FString Name;
+
+	FSpudObjectRef() {}
+	explicit FSpudObjectRef(const FGuid& InGuid) : Type(ESpudObjectRefType::Guid), ActorGuid(InGuid) {}
+	explicit FSpudObjectRef(const FString& InName) : Type(ESpudObjectRefType::LevelName), Name(InName) {}
+
+	/// The string this reference was stored as before reference tables, also used for logging
+	FString ToString() const
+	{
+		return Type == ESpudObjectRefType::Guid ? ActorGuid.ToString(EGuidFormats::DigitsWithHyphensInBraces) : Name;
+	}
+
+	bool operator==(const FSpudObjectRef& Other) const
+	{
+		return Type == Other.Type && (Type == ESpudObjectRefType::Guid ? ActorGuid == Other.ActorGuid : Name == Other.Name);
+	}
+
+	friend uint32 GetTypeHash(const FSpudObjectRef& Ref)
+	{
+		return Ref.Type == ESpudObjectRefType::Guid ? GetTypeHash(Ref.ActorGuid) : GetTypeHash(Ref.Name);
+	}
+
+	friend FArchive& operator<<(FArchive& Ar, FSpudObjectRef& Ref)
+	{
+		uint8 TypeVal = static_cast<uint8>(Ref.Type);
+		Ar << TypeVal;
+		Ref.Type = static_cast<ESpudObjectRefType>(TypeVal);
+		// GUIDs are written as 16 bytes rather than a 38 character string
+		if (Ref.Type == ESpudObjectRefType::Guid)
+			Ar << Ref.ActorGuid;
+		else
+			Ar << Ref.Name;
+		return Ar;
+	}
+};
+
+/// Actor reference lookup, so each referenced actor is only stored (and resolved on restore) once
+struct FSpudObjectRefIndex : public FSpudIndex<FSpudObjectRef>
+{
+	virtual const char* GetMagic() const override { return SPUDDATA_OBJECTREFINDEX_MAGIC; }
+};
+
+/// Paths of assets referenced by nested UObject properties. The paths are still stored inline with the property data,
+/// this is just so they can be loaded in bulk before a restore
+struct FSpudAssetPathIndex : public FSpudIndex<FString>
+{
+	virtual const char* GetMagic() const override { return SPUDDATA_ASSETPATHINDEX_MAGIC; }
+};
+
 struct SPUD_API FSpudClassMetadata : public FSpudChunk
 {
 	/// Description of classes. This allows us to quickly find out what properties are available
@@ -635,6 +793,10 @@ struct SPUD_API FSpudClassMetadata : public FSpudChunk
 	FSpudClassNameIndex ClassNameIndex;
 	/// Property Name string -> number index (also used for prefixes, but prefix and property name are separate to help name re-use)
 	FSpudPropertyNameIndex PropertyNameIndex;
+	/// Actor references -> number index, used by classes with FSpudEncodingProfile::bIndexedObjectRefs
+	FSpudObjectRefIndex ObjectRefIndex;
+	/// Assets referenced from this data, so they can be preloaded (@see USpudState::GetLevelAssetsToPreload)
+	FSpudAssetPathIndex AssetPathIndex;
 
 	/// The user data model version number when this metadata was generated
 	/// @see USpudSubsystem::SetUserDataModelVersion
@@ -658,6 +820,9 @@ struct SPUD_API FSpudClassMetadata : public FSpudChunk
 	uint32 FindOrAddClassIDFromName(const FString& Name);
 	uint32 GetClassIDFromName(const FString& Name) const;
 	void Reset();
+	/// Class definitions are shared pointers so copying this metadata shares them. Call this on a copy to give it its
+	/// own definitions, so it can't be affected by further changes to the original
+	void DeepCopyClassDefinitions();
 
 	
 	bool RenameClass(const FString& OldClassName, const FString& NewClassName);
@@ -693,6 +858,16 @@ struct SPUD_API FSpudGlobalData : public FSpudChunk
 	uint32 GetUserDataModelVersion() const { return Metadata.GetUserDataModelVersion(); }
 };
 
+// Level data may be written as a compressed chunk instead (see GSpudLevelDataCompressionFormat), in which case it's
+// wrapped like this, and can be piped around / paged out without being decompressed:
+// Header:
+// - MAGIC (char[4]) "LVLZ"
+// - Total Data Length (uint32)
+// Data:
+// - Level name (FString), uncompressed so the level can be identified without decompressing
+// - Codec (uint8, ESpudCompressionCodec)
+// - Uncompressed size (uint32)
+// - Compressed data; when decompressed this is the entire LEVL chunk including its header
 struct SPUD_API FSpudLevelData : public FSpudChunk
 {
 	/// Level Name
@@ -715,6 +890,12 @@ struct SPUD_API FSpudLevelData : public FSpudChunk
 
 	/// non-persistent status flag to support placeholder level data which is not currently loaded
 	ELevelDataStatus Status;
+	/// non-persistent; if unloaded and this is >= 0, the level data is still where it was in the save file it was
+	/// loaded from (FSpudSaveData::SourceFilePath), at this position, rather than in a level file
+	int64 SourceOffset = -1;
+	/// non-persistent; whether the contents have changed since they were last read from or written to the level
+	/// cache. Level data which hasn't been modified doesn't need writing out again when it's released
+	bool bModified = true;
 	/// Mutex for the data in this level. You should lock this before altering any contents because levels can
 	/// be loaded in multiple threads
 	FCriticalSection Mutex;
@@ -724,7 +905,7 @@ struct SPUD_API FSpudLevelData : public FSpudChunk
 	void ReleaseMemory();
 	
 	/// Key value for indexing this item; name is unique
-	FString Key() const { return Name; }
+	FName Key() const { return FName(*Name); }
 
 	FSpudLevelData() {}
 
@@ -736,7 +917,9 @@ struct SPUD_API FSpudLevelData : public FSpudChunk
 		  LevelActors(Other.LevelActors),
 		  SpawnedActors(Other.SpawnedActors),
 		  DestroyedActors(Other.DestroyedActors),
-		  Status(Other.Status)
+		  Status(Other.Status),
+		  SourceOffset(Other.SourceOffset),
+		  bModified(Other.bModified)
 	{
 	}
 
@@ -746,21 +929,42 @@ struct SPUD_API FSpudLevelData : public FSpudChunk
 
 	/// Empty the lists of actors ready to be re-populated
 	virtual void PreStoreWorld();
+	/// Alternative to PreStoreWorld which keeps the existing actors & class definitions, so that records can be
+	/// replaced only if they change. Must be followed by PostIncrementalStoreWorld
+	virtual void PreIncrementalStoreWorld();
+	/// Remove the records of any actors which weren't stored since PreIncrementalStoreWorld, because they no longer exist
+	virtual void PostIncrementalStoreWorld();
 
 	/// Read just enough of the next level chunk to retrieve the name, then optionally return the read pointer to where it was
+	/// Works on compressed level chunks too, OutDataSize is the size as stored
 	static bool ReadLevelInfoFromArchive(FSpudChunkedDataArchive& Ar, bool bReturnToStart, FString& OutLevelName, int64& OutDataSize);
+	/// Whether a chunk ID is that of level data, either plain or compressed
+	static bool IsLevelDataMagic(uint32 EncodedMagic);
 
 	void Reset();
 
 	bool IsUserDataModelOutdated() const { return Metadata.IsUserDataModelOutdated(); }
 	uint32 GetUserDataModelVersion() const { return Metadata.GetUserDataModelVersion(); }
+
+protected:
+	void WriteUncompressedToArchive(FSpudChunkedDataArchive& Ar);
+	bool WriteCompressedToArchive(FSpudChunkedDataArchive& Ar, FName Format);
+	void ReadCompressedFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSystemVersion);
 };
 
 /// Screenshot chunk
 struct SPUD_API FSpudScreenshot : public FSpudChunk
 {
-	// PNG encoded image bytes
+	// Encoded image bytes (PNG, unless configured otherwise)
 	TArray<uint8> ImageData;
+	/// Not saved; position of the image data in the archive this was read from, or -1 if not read from one
+	int64 ImageDataOffset = -1;
+	/// Not saved; size of the image data in the archive this was read from, even if it wasn't loaded
+	uint32 ImageDataSize = 0;
+	/// If true, reading only records where the image data is and doesn't load it
+	bool bSkipImageData = false;
+
+	bool HasImage() const { return ImageData.Num() > 0 || ImageDataSize > 0; }
 	
 	virtual const char* GetMagic() const override { return SPUDDATA_SCREENSHOT_MAGIC; }
 	virtual void WriteToArchive(FSpudChunkedDataArchive& Ar) override;
@@ -820,6 +1024,121 @@ struct SPUD_API FSpudSaveInfo : public FSpudChunk
 	void Reset();
 };
 
+/// Location of a single chunk within a save file
+struct SPUD_API FSpudTocEntry
+{
+	/// Encoded magic of the chunk
+	uint32 Magic;
+	/// Position of the chunk header, relative to the start of the save chunk header
+	int64 Offset;
+	/// Length of the chunk, as per its header (excluding header)
+	uint32 Length;
+	/// Level name, for level chunks only
+	FString Name;
+	/// Position of the class metadata chunk inside this chunk (relative as Offset), or -1 if none
+	int64 MetadataOffset;
+
+	FSpudTocEntry() : Magic(0), Offset(0), Length(0), MetadataOffset(-1) {}
+
+	friend FArchive& operator<<(FArchive& Ar, FSpudTocEntry& Entry)
+	{
+		Ar << Entry.Magic;
+		Ar << Entry.Offset;
+		Ar << Entry.Length;
+		Ar << Entry.Name;
+		Ar << Entry.MetadataOffset;
+		return Ar;
+	}
+};
+
+/// Table of contents, listing where all the top-level and level chunks are in the save file so that a reader can seek
+/// straight to the one it wants. Written at the end of the save, followed by an FSpudTableOfContentsPointer
+struct SPUD_API FSpudTableOfContents : public FSpudChunk
+{
+	TArray<FSpudTocEntry> Entries;
+
+	/// Not saved; absolute position of the save chunk header in the archive this was read from. Entry offsets are
+	/// relative to this.
+	int64 SaveStart = 0;
+	/// Not saved; system version of the save this was read from
+	uint16 SystemVersion = 0;
+
+	virtual const char* GetMagic() const override { return SPUDDATA_TABLEOFCONTENTS_MAGIC; }
+	virtual void WriteToArchive(FSpudChunkedDataArchive& Ar) override;
+	virtual void ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSystemVersion) override;
+
+	FSpudTocEntry& AddEntry(const FSpudChunk& Chunk, int64 InSaveStart);
+	const FSpudTocEntry* FindEntry(const char* Magic) const;
+	const FSpudTocEntry* FindLevel(const FString& LevelName) const;
+	void Reset();
+};
+
+/// Fixed-size chunk which is always last in a save that has a table of contents, so that it can be located by seeking
+/// back from the end rather than scanning through the whole file
+struct SPUD_API FSpudTableOfContentsPointer : public FSpudChunk
+{
+	/// Position of the table of contents chunk header, relative to the start of the save chunk header
+	int64 TocOffset = 0;
+
+	static constexpr int64 GetTotalSize() { return FSpudChunkHeader::GetHeaderSize() + sizeof(int64); }
+
+	virtual const char* GetMagic() const override { return SPUDDATA_TABLEOFCONTENTSPTR_MAGIC; }
+	virtual void WriteToArchive(FSpudChunkedDataArchive& Ar) override;
+	virtual void ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSystemVersion) override;
+};
+
+/// Cached description of a single save slot, as stored in the slot index
+struct SPUD_API FSpudSlotIndexEntry : public FSpudChunk
+{
+	FString SlotName;
+	/// Size of the save file when this entry was made, or -1 if not known (platform save systems)
+	int64 FileSize;
+	/// Modification time of the save file when this entry was made
+	FDateTime FileTimestamp;
+	/// Copy of the save's info chunk. The screenshot image data is never kept in the index, just where it is in the
+	/// save file (if known), so that thumbnails can be loaded only when needed
+	FSpudSaveInfo Info;
+
+	/// Key value for indexing this item
+	FString Key() const { return SlotName; }
+
+	FSpudSlotIndexEntry() : FileSize(-1), FileTimestamp(FDateTime::MinValue()) {}
+
+	virtual const char* GetMagic() const override { return SPUDDATA_SLOTINDEXENTRY_MAGIC; }
+	virtual void WriteToArchive(FSpudChunkedDataArchive& Ar) override;
+	virtual void ReadFromArchive(FSpudChunkedDataArchive& Ar, uint32 StoredSystemVersion) override;
+};
+
+/// Index of the info for every save slot, kept up to date as games are saved & deleted so that save lists can be
+/// built from a single small read instead of opening every save file
+struct SPUD_API FSpudSlotIndex : public FSpudStructMapData<FString, FSpudSlotIndexEntry>
+{
+	virtual const char* GetMagic() const override { return SPUDDATA_SLOTINDEX_MAGIC; }
+	virtual const char* GetChildMagic() const override { return SPUDDATA_SLOTINDEXENTRY_MAGIC; }
+};
+
+/**
+ * Callback for reporting progress while reading a save file. Called on whichever thread is doing the read.
+ * Params are bytes processed so far, total bytes in the source archive, and the number of levels processed so far.
+ */
+typedef TFunction<void(int64 BytesProcessed, int64 TotalBytes, int32 LevelsProcessed)> FSpudReadProgressCallback;
+
+/// Paged out level files which a save snapshot still has to pipe into the save (@see FSpudSaveData::CreateSnapshot).
+/// Shared between the snapshot and the live save data. Before the live data rewrites or deletes one of these files
+/// it's moved aside for the snapshot, so the save always gets the level as it was when the snapshot was taken.
+struct SPUD_API FSpudSnapshotLevelFiles
+{
+	FCriticalSection Mutex;
+	/// Levels not piped yet, which are still in the level cache
+	TSet<FString> PendingLevels;
+	/// Levels not piped yet whose file was moved aside, and where to
+	TMap<FString, FString> MovedLevels;
+	/// The live data's FSpudSaveData::LevelFilesLock
+	FRWLock* LevelFilesLock = nullptr;
+
+	~FSpudSnapshotLevelFiles();
+};
+
 /// The top-level structure for the entire save file
 struct SPUD_API FSpudSaveData : public FSpudChunk
 {
@@ -831,9 +1150,22 @@ struct SPUD_API FSpudSaveData : public FSpudChunk
 	// Also we want threadsafe shared ptr for data holder so that we can write it in the background without holding the
 	// lock on the entire map while we do so
 	typedef TSharedPtr<FSpudLevelData, ESPMode::ThreadSafe> TLevelDataPtr;
-	TMap<FString, TLevelDataPtr> LevelDataMap;
+	TMap<FName, TLevelDataPtr> LevelDataMap;
 	// Mutex for altering the level data map
 	FCriticalSection LevelDataMapMutex;
+	// Lock for the paged-out level files. Held for read while one is being piped into a save, and for write while
+	// any level file is being written or deleted. If you need the level mutex as well, lock that first.
+	FRWLock LevelFilesLock;
+	/// Snapshots which haven't finished piping paged out level files yet; only changed with LevelFilesLock held for write
+	TArray<TWeakPtr<FSpudSnapshotLevelFiles, ESPMode::ThreadSafe>> SnapshotsPinningLevelFiles;
+	/// If this is a snapshot, the paged out level files it writes
+	TSharedPtr<FSpudSnapshotLevelFiles, ESPMode::ThreadSafe> PinnedLevelFiles;
+
+	/// The save file which unloaded levels with a SourceOffset are paged in from, if any
+	FString SourceFilePath;
+	/// Size & timestamp of the source file when it was read, to detect it being changed underneath us
+	int64 SourceFileSize = 0;
+	FDateTime SourceFileTimestamp;
 
 	virtual const char* GetMagic() const override { return SPUDDATA_SAVEGAME_MAGIC; }
 	void PrepareForWrite();
@@ -851,8 +1183,52 @@ struct SPUD_API FSpudSaveData : public FSpudChunk
 	 * @param Ar Source archive for the entire save file
 	 * @param bLoadAllLevels If true, all levels will be loaded into memory. If false, none will be & data will be split for later loading
 	 * @param LevelPath The parent directory where level chunks should be written as separate files
+	 * @param ProgressCallback Optional callback to be notified of progress as each level is processed
+	 * @param InSourceFilePath If not empty, this is the file Ar is reading, and when not loading all levels, level data
+	 * is left where it is in that file and paged in from there when needed, instead of being split into LevelPath.
+	 * Levels are only written to LevelPath once they've been loaded and released again.
+	 */
+	virtual void ReadFromArchive(FSpudChunkedDataArchive& Ar, bool bLoadAllLevels, const FString& LevelPath,
+	                             const FSpudReadProgressCallback& ProgressCallback = nullptr,
+	                             const FString& InSourceFilePath = FString());
+
+	/**
+	 * @brief Stop paging level data from SourceFilePath, copying any levels which are still only in that file into
+	 * LevelPath. Must be called before the source file is overwritten or deleted.
+	 * @param LevelPath The path in which to write the level data
+	 * @return False if any level couldn't be copied, in which case the source file is still needed
+	 */
+	bool ReleaseSourceFile(const FString& LevelPath);
+
+	/**
+	 * @brief Copy any levels which are still only in SourceFilePath into LevelPath, but keep SourceFilePath. Once
+	 * this is done the source file isn't read any more, so it can be replaced before calling ReleaseSourceFile.
+	 * Safe to call from another thread while the game thread continues to use this data.
+	 * @param LevelPath The path in which to write the level data
+	 * @return False if any level couldn't be copied, in which case the source file mustn't be replaced
+	 */
+	bool ExtractLevelsFromSourceFile(const FString& LevelPath);
+
+	/// Whether the source file is unchanged since it was read, so level data can still be paged in from it
+	bool IsSourceFileUnchanged() const;
+
+	/**
+	 * @brief Populate another save data instance with a copy of this one which is safe to write out in another thread
+	 * while this one continues to be changed. Level data in memory is copied; paged out levels are left unloaded in
+	 * the snapshot so they're piped from their files when written. Those files are pinned to the snapshot, so
+	 * changing them here afterwards moves the old version aside for the snapshot first.
+	 * @param OutSnapshot The save data to populate, any existing contents are discarded
+	 * @param LevelPath The parent directory where level chunks can be found as separate files
 	 */
-	virtual void ReadFromArchive(FSpudChunkedDataArchive& Ar, bool bLoadAllLevels, const FString& LevelPath);
+	void CreateSnapshot(FSpudSaveData& OutSnapshot, const FString& LevelPath);
+
+	/// Before a level file is rewritten or deleted, move it aside for any snapshots which still need the old version.
+	/// Must be called with LevelFilesLock held for write
+	void PreserveLevelFileForSnapshots(const FString& LevelName, const FString& LevelPath);
+
+	/// Pipe the file of a paged out level into a save, recording it in the TOC. OutFilename is the file it was read from
+	bool PipeUnloadedLevelData(const FSpudLevelData& LevelData, const FString& LevelPath, FSpudChunkedDataArchive& Ar,
+	                           int64 SaveStart, TArray<FSpudTocEntry>& OutEntries, FString& OutFilename);
 	
 	/**
 	 * @brief Retrieve data for a single level, loading it if necessary. Thread-safe.
@@ -905,7 +1281,28 @@ struct SPUD_API FSpudSaveData : public FSpudChunk
 	static void WriteLevelData(FSpudLevelData& LevelData, const FString& LevelName, const FString& LevelPath);
 
 	/// Utility method to read an archive just up to the end of the FSpudSaveInfo, and output details
-	static bool ReadSaveInfoFromArchive(FSpudChunkedDataArchive& Ar, FSpudSaveInfo& OutInfo);
+	/// If bIncludeScreenshot is false, only the location of the screenshot is recorded, the image isn't loaded
+	static bool ReadSaveInfoFromArchive(FSpudChunkedDataArchive& Ar, FSpudSaveInfo& OutInfo, bool bIncludeScreenshot = true);
+
+	/**
+	 * @brief Read the table of contents of a save file. Uses the TOC chunk at the end of the save if there is one,
+	 * otherwise falls back on scanning the chunks to build the same information (older saves).
+	 * @param Ar Archive positioned at the start of the save chunk. Position is restored afterwards
+	 * @param OutToc The table of contents to populate
+	 * @return Whether the table of contents could be read
+	 */
+	static bool ReadTableOfContents(FSpudChunkedDataArchive& Ar, FSpudTableOfContents& OutToc);
+
+	/**
+	 * @brief Read a single level's data from a save file, seeking directly to it using a table of contents
+	 * @param Ar The archive the table of contents was read from
+	 * @param Toc Table of contents from ReadTableOfContents
+	 * @param LevelName The name of the level to read
+	 * @param OutLevelData Level data to populate
+	 * @return Whether the level was found and read
+	 */
+	static bool ReadLevelFromArchive(FSpudChunkedDataArchive& Ar, const FSpudTableOfContents& Toc,
+	                                 const FString& LevelName, FSpudLevelData& OutLevelData);
 };
 
 
@@ -917,3 +1314,14 @@ struct SPUD_API FSpudSaveData : public FSpudChunk
  * @return The length of the data actually copied
  */
 int64 SpudCopyArchiveData(FArchive& InArchive, FArchive& OutArchive, int64 Length);
+
+/**
+ * @brief Copy a range of a file into an archive. Faster than SpudCopyArchiveData for large amounts of data, since it
+ * uses async reads so that reading the next block overlaps writing the previous one
+ * @param Filename File to read from
+ * @param Offset Position in the file to start copying from
+ * @param OutArchive Archive to write to
+ * @param Length Total length of data to copy
+ * @return The length of the data actually copied
+ */
+int64 SpudCopyFileData(const FString& Filename, int64 Offset, FArchive& OutArchive, int64 Length);
@@ -70,6 +70,73 @@ template <> const ESpudStorageType SpudTypeInfo<FString>::EnumType = ESST_String
 template <> const ESpudStorageType SpudTypeInfo<FName>::EnumType = ESST_Name;
 template <> const ESpudStorageType SpudTypeInfo<FText>::EnumType = ESST_Text;
 }
+/// Specialised value read / write functions for primitives & builtin structs. Resolved once per FProperty so that
+/// values can be written & read with a single table lookup instead of trying each property type in turn.
+/// None means the property must go through the general path (UObjects, custom structs, fallback records).
+enum class ESpudPropertyCodec : uint8
+{
+	None,
+	Bool,
+	Byte,
+	UInt16,
+	UInt32,
+	UInt64,
+	Int8,
+	Int16,
+	Int32,
+	Int64,
+	Float,
+	Double,
+	String,
+	Name,
+	Text,
+	Enum,
+	Vector,
+	Rotator,
+	Transform,
+	Guid,
+
+	Count
+};
+
+/// One entry in a flattened property plan, see FSpudPropertyPlan
+struct SPUD_API FSpudPropertyPlanStep
+{
+	/// The runtime property this step visits
+	FProperty* Property = nullptr;
+	/// Storage type of the property, as returned by SpudPropertyUtil::GetPropertyDataType
+	uint16 DataType = ESST_Unknown;
+	/// Value codec; for natively supported arrays & sets this is the codec of the elements, for maps the keys
+	ESpudPropertyCodec Codec = ESpudPropertyCodec::None;
+	/// For natively supported maps, the codec of the values
+	ESpudPropertyCodec ValueCodec = ESpudPropertyCodec::None;
+	/// Property is an array which is stored natively (count then elements)
+	bool bIsNativeArray = false;
+	/// Property is a set which is stored natively (count then elements)
+	bool bIsNativeSet = false;
+	/// Property is a map which is stored natively (count then keys then values)
+	bool bIsNativeMap = false;
+	/// Property is marked for persistence but not supported
+	bool bUnsupported = false;
+	/// Property is a custom (non-builtin) struct whose members follow this step
+	bool bIsCustomStruct = false;
+	/// Property is an FInstancedStruct, whose members depend on the instance so can't be planned
+	bool bIsInstancedStruct = false;
+	/// Property is a nested UObject which cascades based on the runtime instance
+	bool bIsNestedUObject = false;
+	/// For custom structs, the index of the first step after the struct's members
+	int32 NestedEnd = INDEX_NONE;
+};
+
+/// A flattened, depth-first list of the persistent properties of a class, in exactly the order that reflective
+/// visiting would produce them. Built once per class and replayed linearly on the store / restore hot paths,
+/// instead of re-iterating fields and re-evaluating property flags for every object. Immutable once built.
+struct SPUD_API FSpudPropertyPlan
+{
+	TArray<FSpudPropertyPlanStep> Steps;
+};
+typedef TSharedPtr<const FSpudPropertyPlan, ESPMode::ThreadSafe> FSpudPropertyPlanPtr;
+
 /// Utility class which does all the nuts & bolts related to property persistence without actually being stateful
 /// Also none of this is exposed to Blueprints, is completely internal to C++ persistence
 class SPUD_API SpudPropertyUtil
@@ -131,6 +198,22 @@ public:
 		 * @param Depth The depth for members of the struct
 		 */
 		virtual void EndNestedStruct(UObject* RootObject, FStructProperty* SProp, uint32 PrefixID, int Depth) {}
+
+		/**
+		 * @brief Visit a property from a cached property plan. Equivalent to VisitProperty, but gives access to the
+		 * type information which was resolved when the plan was built. Default implementation calls VisitProperty.
+		 * @param RootObject The root object for this property. Can be null if just parsing definitions not instances!
+		 * @param Step The plan step, including the property to process
+		 * @param CurrentPrefixID The prefix which identifies nested struct properties
+		 * @param ContainerPtr Pointer to data container which can be used to access values. Can be null!
+		 * @param Depth The current nesting depth (0 for top-level properties, higher for nested structs)
+		 * @returns True to continue parsing properties, false to quit early
+		 */
+		virtual bool VisitPlannedProperty(UObject* RootObject, const FSpudPropertyPlanStep& Step, uint32 CurrentPrefixID,
+		                                  void* ContainerPtr, int Depth)
+		{
+			return VisitProperty(RootObject, Step.Property, CurrentPrefixID, ContainerPtr, Depth);
+		}
 	};
 
 	/**
@@ -175,6 +258,9 @@ public:
 	// Whether a property is a TSubclassOf property
 	static bool IsSubclassOfProperty(const FProperty* Property);
 	static uint16 GetPropertyDataType(const FProperty* Prop);
+	/// Get the specialised value codec for a property, or None if it has to use the general path. Arrays are None,
+	/// ask for the codec of AProp->Inner instead.
+	static ESpudPropertyCodec GetPropertyCodec(const FProperty* Prop);
 
 	class StoredMatchesRuntimePropertyVisitor : public SpudPropertyUtil::PropertyVisitor
 	{
@@ -200,15 +286,17 @@ public:
 	static FString GetNestedPrefix(uint32 PrefixIDSoFar, FProperty* Prop, const FSpudClassMetadata& Meta);
 	static uint32 GetNestedPrefixID(uint32 PrefixIDSoFar, FProperty* Prop, const FSpudClassMetadata& Meta);
 	static uint32 FindOrAddNestedPrefixID(uint32 PrefixIDSoFar, FProperty* Prop, FSpudClassMetadata& Meta);
-	static void RegisterProperty(uint32 PropNameID, uint32 PrefixID, uint16 DataType, TSharedPtr<FSpudClassDef> ClassDef, TArray<uint32>& PropertyOffsets, FArchive& Out);
-	static void RegisterProperty(const FString& Name,
+	/// Register a property at the current offset, returns the data type recorded in the class def, which might differ
+	/// in encoding flags (e.g. ESST_VarCount) from DataType if the property was already registered from older data
+	static uint16 RegisterProperty(uint32 PropNameID, uint32 PrefixID, uint16 DataType, TSharedPtr<FSpudClassDef> ClassDef, TArray<uint32>& PropertyOffsets, FArchive& Out);
+	static uint16 RegisterProperty(const FString& Name,
 	                             uint32 PrefixID,
 	                             uint16 DataType,
 	                             TSharedPtr<FSpudClassDef> ClassDef,
 	                             TArray<uint32>& PropertyOffsets,
 	                             FSpudClassMetadata& Meta,
 	                             FArchive& Out);
-	static void RegisterProperty(FProperty* Prop,
+	static uint16 RegisterProperty(FProperty* Prop,
 	                             uint32 PrefixID,
 	                             TSharedPtr<FSpudClassDef> ClassDef,
 	                             TArray<uint32>& PropertyOffsets,
@@ -216,10 +304,31 @@ public:
 	                             & Meta,
 	                             FArchive& Out);
 
+	/// Register a property at the current offset without writing any data, because its value is identical to the
+	/// archetype's. Returns the index of the property in the class def
+	static int RegisterUnchangedProperty(FProperty* Prop,
+	                                     uint32 PrefixID,
+	                                     TSharedPtr<FSpudClassDef> ClassDef,
+	                                     TArray<uint32>& PropertyOffsets,
+	                                     FSpudClassMetadata& Meta,
+	                                     FArchive& Out);
+	/// Whether a planned property can be left out of the data when it's identical to the archetype. Only values
+	/// (primitives, builtin structs & native containers of those), never object references or nested objects
+	static bool CanStoreAsArchetypeDelta(const FSpudPropertyPlanStep& Step);
+	/// Given a container which is part of RootObject's own memory (the object itself or a struct embedded in it),
+	/// get the equivalent container in Other, which must be of the same class. Returns null for containers anywhere
+	/// else, e.g. elements of arrays or instanced structs, since those aren't laid out the same in every instance
+	static const void* GetEquivalentContainerPtr(const UObject* RootObject, const void* ContainerPtr, const UObject* Other);
+
 	/// Visit all properties of a UObject
 	static void VisitPersistentProperties(UObject* RootObject, PropertyVisitor& Visitor, int StartDepth = 0);
 	/// Visit all properties of a class definition, with no instance
 	static void VisitPersistentProperties(const UStruct* Definition, PropertyVisitor& Visitor);
+
+	/// Get the cached property plan for a class or struct, building it on first use. Thread safe.
+	static FSpudPropertyPlanPtr GetPropertyPlan(const UStruct* Definition);
+	/// Discard all cached property plans, e.g. because class layouts changed after a hot reload or Blueprint compile
+	static void FlushPropertyPlans();
 	
 	static void StoreProperty(const UObject* RootObject,
 	                          FProperty* Property,
@@ -230,7 +339,18 @@ public:
 	                          TArray<uint32>& PropertyOffsets,
 	                          FSpudClassMetadata& Meta,
 	                          FSpudMemoryWriter& Out);
+	/// Store a property using the type information already resolved in a property plan
+	static void StoreProperty(const UObject* RootObject,
+	                          const FSpudPropertyPlanStep& Step,
+	                          uint32 PrefixID,
+	                          const void* ContainerPtr,
+	                          int Depth,
+	                          TSharedPtr<FSpudClassDef> ClassDef,
+	                          TArray<uint32>& PropertyOffsets,
+	                          FSpudClassMetadata& Meta,
+	                          FSpudMemoryWriter& Out);
 	static void StoreArrayProperty(FArrayProperty* AProp,
+	                               ESpudPropertyCodec ElementCodec,
 	                               const UObject* RootObject,
 	                               uint32 PrefixID,
 	                               const void* ContainerPtr,
@@ -239,7 +359,27 @@ public:
 	                               TArray<uint32>& PropertyOffsets,
 	                               FSpudClassMetadata& Meta,
 	                               FSpudMemoryWriter& Out);
+	static void StoreSetProperty(FSetProperty* SProp,
+	                             ESpudPropertyCodec ElementCodec,
+	                             uint32 PrefixID,
+	                             const void* ContainerPtr,
+	                             int Depth,
+	                             TSharedPtr<FSpudClassDef> ClassDef,
+	                             TArray<uint32>& PropertyOffsets,
+	                             FSpudClassMetadata& Meta,
+	                             FSpudMemoryWriter& Out);
+	static void StoreMapProperty(FMapProperty* MProp,
+	                             ESpudPropertyCodec KeyCodec,
+	                             ESpudPropertyCodec ValueCodec,
+	                             uint32 PrefixID,
+	                             const void* ContainerPtr,
+	                             int Depth,
+	                             TSharedPtr<FSpudClassDef> ClassDef,
+	                             TArray<uint32>& PropertyOffsets,
+	                             FSpudClassMetadata& Meta,
+	                             FSpudMemoryWriter& Out);
 	static void StoreContainerProperty(FProperty* Property,
+	                                   ESpudPropertyCodec Codec,
 	                                   const UObject* RootObject,
 	                                   uint32 PrefixID,
 	                                   const void* ContainerPtr,
@@ -251,20 +391,57 @@ public:
 	                                   FSpudMemoryWriter& Out);
 
 
-	typedef TMap<FGuid, UObject*> RuntimeObjectMap;
+	/// Objects which references can be resolved to during a restore. One instance is shared by every object restored
+	/// in a level, so any indexes built here are only built once per restore rather than once per reference.
+	/// Objects are held weakly since a restore can be spread over several frames
+	struct RuntimeObjectMap
+	{
+		/// Runtime-created objects, by their SpudGuid
+		TMap<FGuid, TWeakObjectPtr<UObject>> ObjectsByGuid;
+
+		/// Find an actor in any loaded level of the world, by name or by ISpudObject::OverrideName. The index is
+		/// built lazily on the first call, since most references resolve in their owning level without it
+		AActor* FindActorInWorld(const UWorld* World, const FString& Name) const;
+
+		/// Objects already resolved from entries in the restored level's FSpudClassMetadata::ObjectRefIndex, so each
+		/// entry is only resolved once however many properties refer to it
+		mutable TMap<uint32, TWeakObjectPtr<UObject>> ResolvedRefs;
+
+	private:
+		mutable TMap<FName, TWeakObjectPtr<AActor>> ActorsByName;
+		mutable TMap<FString, TWeakObjectPtr<AActor>> ActorsByOverrideName;
+		mutable bool bActorIndexBuilt = false;
+	};
 	
 	static void RestoreProperty(UObject* RootObject, FProperty* Property, void* ContainerPtr,
 	                            const FSpudPropertyDef& StoredProperty,
+	                            const FSpudEncodingProfile& Encoding,
 	                            const RuntimeObjectMap* RuntimeObjects,
 	                            const FSpudClassMetadata& Meta,
 	                            int Depth, FSpudMemoryReader& DataIn);
-	static void RestoreArrayProperty(UObject* RootObject, FArrayProperty* const AProp, void* ContainerPtr,
+	/// Restore a property using the type information already resolved in a property plan
+	static void RestoreProperty(UObject* RootObject, const FSpudPropertyPlanStep& Step, void* ContainerPtr,
+	                            const FSpudPropertyDef& StoredProperty,
+	                            const FSpudEncodingProfile& Encoding,
+	                            const RuntimeObjectMap* RuntimeObjects,
+	                            const FSpudClassMetadata& Meta,
+	                            int Depth, FSpudMemoryReader& DataIn);
+	static void RestoreArrayProperty(UObject* RootObject, FArrayProperty* const AProp, ESpudPropertyCodec ElementCodec,
+	                                 void* ContainerPtr,
 	                                 const FSpudPropertyDef& StoredProperty,
+	                                 const FSpudEncodingProfile& Encoding,
 	                                 const RuntimeObjectMap* RuntimeObjects,
 	                                 const FSpudClassMetadata& Meta,
 	                                 int Depth, FSpudMemoryReader& DataIn);
-	static void RestoreContainerProperty(UObject* RootObject, FProperty* const Property,
+	static void RestoreSetProperty(FSetProperty* const SProp, ESpudPropertyCodec ElementCodec, void* ContainerPtr,
+	                               const FSpudPropertyDef& StoredProperty, const FSpudEncodingProfile& Encoding,
+	                               int Depth, FSpudMemoryReader& DataIn);
+	static void RestoreMapProperty(FMapProperty* const MProp, ESpudPropertyCodec KeyCodec, ESpudPropertyCodec ValueCodec,
+	                               void* ContainerPtr, const FSpudPropertyDef& StoredProperty,
+	                               const FSpudEncodingProfile& Encoding, int Depth, FSpudMemoryReader& DataIn);
+	static void RestoreContainerProperty(UObject* RootObject, FProperty* const Property, ESpudPropertyCodec Codec,
 	                                     void* ContainerPtr, const FSpudPropertyDef& StoredProperty,
+	                                     const FSpudEncodingProfile& Encoding,
 	                                     const RuntimeObjectMap* RuntimeObjects,
 	                                     const FSpudClassMetadata& Meta,
 	                                     int Depth, FSpudMemoryReader& DataIn);
@@ -278,10 +455,47 @@ public:
 
 protected:
 	static bool IsNativelySupportedArrayType(const FArrayProperty* AProp);
+	/// Sets & maps are stored natively if their elements / keys & values are primitives or builtin structs
+	static bool IsNativelySupportedSetType(const FSetProperty* SProp);
+	static bool IsNativelySupportedMapType(const FMapProperty* MProp);
+	/// Read a variable length element count & check it's plausible given the remaining data
+	/// ElementsPerByte is the most elements which can be packed into a byte, e.g. 8 for bit-packed bools
+	static bool ReadElementCount(FProperty* Property, int32& OutCount, FArchive& In, int32 ElementsPerByte = 1);
 	/// General recursive visitation of properties, returns false to early-out, object/container can be null
 	static bool VisitPersistentProperties(UObject* RootObject, const UStruct* Definition, uint32 PrefixID,
 	                                      void* ContainerPtr, bool IsChildOfSaveGame, int Depth,
 	                                      PropertyVisitor& Visitor);
+	/// Cascade into the members of a custom struct property (including instanced structs), returns false to early-out
+	static bool VisitNestedStructProperties(UObject* RootObject, FStructProperty* SProp, uint32 PrefixID,
+	                                        void* ContainerPtr, int Depth, PropertyVisitor& Visitor);
+	/// Linear replay of a range of plan steps, returns false to early-out
+	static bool VisitPlannedProperties(UObject* RootObject, const FSpudPropertyPlan& Plan, int32 BeginStep, int32 EndStep,
+	                                   uint32 PrefixID, void* ContainerPtr, int Depth, PropertyVisitor& Visitor);
+	static void BuildPropertyPlan(const UStruct* Definition, bool IsChildOfSaveGame, FSpudPropertyPlan& Plan);
+
+	typedef void (*FCodecWriteFunc)(FProperty* Prop, uint32 PrefixID, const void* Data, bool bIsArrayElement, int Depth,
+	                                const TSharedPtr<FSpudClassDef>& ClassDef, TArray<uint32>& PropertyOffsets,
+	                                FSpudClassMetadata& Meta, FArchive& Out);
+	/// Read functions get the encoding explicitly, write functions use the one in ClassDef
+	typedef void (*FCodecReadFunc)(FProperty* Prop, void* Data, int Depth, const FSpudEncodingProfile& Encoding,
+	                               FArchive& In);
+	/// Entry in the codec dispatch table
+	struct FCodecFuncs
+	{
+		/// Storage type written by this codec, excluding ESST_ArrayOf
+		uint16 DataType;
+		FCodecWriteFunc Write;
+		FCodecReadFunc Read;
+	};
+	/// Get the standard codec functions. DataType is the same whatever the encoding
+	static const FCodecFuncs& GetCodecFuncs(ESpudPropertyCodec Codec);
+	/// Get the codec functions to use for data with a given encoding
+	static const FCodecFuncs& GetCodecFuncs(ESpudPropertyCodec Codec, const FSpudEncodingProfile& Encoding);
+	/// Get the compact encoding codec functions, or null if the codec is written the same as standard
+	static const FCodecFuncs* GetCompactCodecFuncs(ESpudPropertyCodec Codec);
+	/// Whether an array with elements of this codec can be written / read as one block of raw element memory
+	static bool CanBulkSerializeArray(ESpudPropertyCodec ElementCodec, const FSpudEncodingProfile& Encoding,
+	                                  const FArchive& Ar);
 
 	static FString ToString(int Val) { return FString::FromInt(Val); }
     static FString ToString(int64 Val) { return FString::Printf(TEXT("%lld"), Val); }
@@ -302,7 +516,7 @@ protected:
 		uint32 PrefixID,
 		const void* Data,
 		bool bIsArrayElement,
-		TSharedPtr<FSpudClassDef> ClassDef,
+		const TSharedPtr<FSpudClassDef>& ClassDef,
 		TArray<uint32>& PropertyOffsets,
 		FSpudClassMetadata& Meta,
 		FArchive& Out)
@@ -315,21 +529,6 @@ protected:
     }
 
 
-	template <class PropType, typename ValueType>
-	static bool TryWritePropertyData(FProperty* Prop, uint32 PrefixID, const void* Data, bool bIsArrayElement, int Depth,
-	                          TSharedPtr<FSpudClassDef> ClassDef, TArray<uint32>& PropertyOffsets, FSpudClassMetadata& Meta,
-	                          FArchive& Out)
-    {
-    	if (auto IProp = CastField<PropType>(Prop))
-    	{
-    		auto Val = WritePropertyData<PropType, ValueType>(IProp, PrefixID, Data, bIsArrayElement, ClassDef, PropertyOffsets, Meta, Out);
-			UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(Val));
-    		return true;
-    	}
-    	return false;
-	    
-    }
-
 	static uint16 WriteEnumPropertyData(FEnumProperty* EProp,
 	                                    uint32 PrefixID,
 	                                    const void* Data,
@@ -339,15 +538,6 @@ protected:
 	                                    FSpudClassMetadata& Meta,
 	                                    FArchive& Out);
 
-	static bool TryWriteEnumPropertyData(FProperty* Property,
-	                                     uint32 PrefixID,
-	                                     const void* Data,
-	                                     bool bIsArrayElement,
-	                                     int Depth,
-	                                     TSharedPtr<FSpudClassDef> ClassDef,
-	                                     TArray<uint32>& PropertyOffsets,
-	                                     FSpudClassMetadata& Meta,
-	                                     FArchive& Out);
 	static FString WriteActorRefPropertyData(::FProperty* OProp,
 	                                         AActor* Actor,
 	                                         FPlatformTypes::uint32 PrefixID,
@@ -403,22 +593,99 @@ protected:
     	Out << Val;
     	return Val;
     }
+
+
+	// Codec table entries. Property type has already been resolved so these can cast directly
+
+	template <class PropType, typename ValueType>
+	static void WritePropertyCodec(FProperty* Prop, uint32 PrefixID, const void* Data, bool bIsArrayElement, int Depth,
+	                               const TSharedPtr<FSpudClassDef>& ClassDef, TArray<uint32>& PropertyOffsets,
+	                               FSpudClassMetadata& Meta, FArchive& Out)
+	{
+		auto Val = WritePropertyData<PropType, ValueType>(static_cast<PropType*>(Prop), PrefixID, Data, bIsArrayElement,
+		                                                  ClassDef, PropertyOffsets, Meta, Out);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(Val));
+	}
+
 	template <typename ValueType>
-	static bool TryWriteBuiltinStructPropertyData(FStructProperty* Prop, uint32 PrefixID, const void* Data, bool bIsArrayElement,
-	                                       int Depth, TSharedPtr<FSpudClassDef> ClassDef, TArray<uint32>& PropertyOffsets, FSpudClassMetadata& Meta, FArchive& Out)
-    {
-    	// Check struct detail value matches
-    	if (Prop->Struct == TBaseStructure<ValueType>::Get())
-    	{
-    		if (!bIsArrayElement)
-    			RegisterProperty(Prop, PrefixID, ClassDef, PropertyOffsets, Meta, Out);
-    		ValueType Val = WriteStructPropertyData<ValueType>(Prop, PrefixID, Data, Out);
-    		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(&Val));
-    		return true;
-    	}
-    	return false;
-    }
+	static void WriteBuiltinStructCodec(FProperty* Prop, uint32 PrefixID, const void* Data, bool bIsArrayElement, int Depth,
+	                                    const TSharedPtr<FSpudClassDef>& ClassDef, TArray<uint32>& PropertyOffsets,
+	                                    FSpudClassMetadata& Meta, FArchive& Out)
+	{
+		if (!bIsArrayElement)
+			RegisterProperty(Prop, PrefixID, ClassDef, PropertyOffsets, Meta, Out);
+		ValueType Val = WriteStructPropertyData<ValueType>(static_cast<FStructProperty*>(Prop), PrefixID, Data, Out);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(&Val));
+	}
+
+	static void WriteEnumCodec(FProperty* Prop, uint32 PrefixID, const void* Data, bool bIsArrayElement, int Depth,
+	                           const TSharedPtr<FSpudClassDef>& ClassDef, TArray<uint32>& PropertyOffsets,
+	                           FSpudClassMetadata& Meta, FArchive& Out);
+
+	template <class PropType, typename ValueType>
+	static void ReadPropertyCodec(FProperty* Prop, void* Data, int Depth, const FSpudEncodingProfile& Encoding, FArchive& In)
+	{
+		auto Val = ReadPropertyData<PropType, ValueType>(static_cast<PropType*>(Prop), Data, In);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(Val));
+	}
+
+	template <typename ValueType>
+	static void ReadBuiltinStructCodec(FProperty* Prop, void* Data, int Depth, const FSpudEncodingProfile& Encoding, FArchive& In)
+	{
+		ValueType Val = ReadStructPropertyData<ValueType>(static_cast<FStructProperty*>(Prop), Data, In);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(&Val));
+	}
+
+	static void ReadEnumCodec(FProperty* Prop, void* Data, int Depth, const FSpudEncodingProfile& Encoding, FArchive& In);
 
+	// Compact encoding codec table entries
+
+	template <class PropType, typename ValueType>
+	static void WriteVarIntCodec(FProperty* Prop, uint32 PrefixID, const void* Data, bool bIsArrayElement, int Depth,
+	                             const TSharedPtr<FSpudClassDef>& ClassDef, TArray<uint32>& PropertyOffsets,
+	                             FSpudClassMetadata& Meta, FArchive& Out)
+	{
+		if (!bIsArrayElement)
+			RegisterProperty(Prop, PrefixID, ClassDef, PropertyOffsets, Meta, Out);
+		const ValueType Val = static_cast<PropType*>(Prop)->GetPropertyValue(Data);
+		if constexpr (std::is_signed_v<ValueType>)
+			WriteVarInt(Val, Out);
+		else
+			WriteVarUInt(Val, Out);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(Val));
+	}
+
+	template <class PropType, typename ValueType>
+	static void ReadVarIntCodec(FProperty* Prop, void* Data, int Depth, const FSpudEncodingProfile& Encoding, FArchive& In)
+	{
+		ValueType Val;
+		if constexpr (std::is_signed_v<ValueType>)
+			Val = static_cast<ValueType>(ReadVarInt(In));
+		else
+			Val = static_cast<ValueType>(ReadVarUInt(In));
+		static_cast<PropType*>(Prop)->SetPropertyValue(Data, Val);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(Val));
+	}
+
+	template <typename ValueType>
+	static void WriteQuantizedStructCodec(FProperty* Prop, uint32 PrefixID, const void* Data, bool bIsArrayElement, int Depth,
+	                                      const TSharedPtr<FSpudClassDef>& ClassDef, TArray<uint32>& PropertyOffsets,
+	                                      FSpudClassMetadata& Meta, FArchive& Out)
+	{
+		if (!bIsArrayElement)
+			RegisterProperty(Prop, PrefixID, ClassDef, PropertyOffsets, Meta, Out);
+		const ValueType& Val = *static_cast<const ValueType*>(Data);
+		WriteQuantized(Val, ClassDef->Encoding, Out);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(&Val));
+	}
+
+	template <typename ValueType>
+	static void ReadQuantizedStructCodec(FProperty* Prop, void* Data, int Depth, const FSpudEncodingProfile& Encoding, FArchive& In)
+	{
+		ValueType& Val = *static_cast<ValueType*>(Data);
+		ReadQuantized(Val, Encoding, In);
+		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(&Val));
+	}
 
 	template<typename ValueType>
     static ValueType ReadStructPropertyData(FStructProperty* SProp, void* Data, FArchive& In)
@@ -441,36 +708,14 @@ protected:
 	}
 
 
-	template <typename ValueType>
-    static bool TryReadBuiltinStructPropertyData(FStructProperty* Prop, void* Data, const FSpudPropertyDef& StoredProperty, int Depth, FArchive& In)
-	{
-		// Check runtime property and stored match 
-		if (Prop->Struct == TBaseStructure<ValueType>::Get() &&
-			StoredPropertyTypeMatchesRuntime(Prop, StoredProperty, true)) // we ignore array flag since we could be processing inner
-		{
-			ValueType Val = ReadStructPropertyData<ValueType>(Prop, Data, In);
-    		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(&Val));
-			return true;
-		}
-		return false;
-	}
-	template <class PropType, typename ValueType>
-    static bool TryReadPropertyData(FProperty* Prop, void* Data, const FSpudPropertyDef& StoredProperty, int Depth, FArchive& In)
-	{
-		auto IProp = CastField<PropType>(Prop);
-		if (IProp && StoredPropertyTypeMatchesRuntime(Prop, StoredProperty, true)) // we ignore array flag since we could be processing inner
-		{
-			auto Val = ReadPropertyData<PropType, ValueType>(IProp, Data, In);
-    		UE_LOG(LogSpudProps, Verbose, TEXT("%s = %s"), *GetLogPrefix(Prop, Depth), *ToString(Val));
-			return true;
-		}
-		return false;   
-	}
 
 	static uint16 ReadEnumPropertyData(FEnumProperty* EProp, void* Data, FArchive& In);
 	static bool TryReadEnumPropertyData(FProperty* Prop, void* Data, const FSpudPropertyDef& StoredProperty,
 	                                    int Depth, FArchive& In);
-	static FString ReadActorRefPropertyData(FProperty* OProp, void* Data, const RuntimeObjectMap* RuntimeObjects, ULevel* Level, FArchive& In);
+	static FString ReadActorRefPropertyData(FProperty* OProp, void* Data, const RuntimeObjectMap* RuntimeObjects, ULevel* Level,
+	                                        const FSpudClassMetadata& Meta, const FSpudEncodingProfile& Encoding, FArchive& In);
+	/// Find the actor a stored reference points to, or null (which is logged)
+	static UObject* ResolveActorRef(const FProperty* OProp, const FSpudObjectRef& Ref, const RuntimeObjectMap* RuntimeObjects, ULevel* Level);
 	static FString ReadNestedUObjectPropertyData(FObjectProperty* OProp,
 	                                             void* Data,
 	                                             const RuntimeObjectMap* RuntimeObjects,
@@ -490,7 +735,8 @@ protected:
 	                                          FArchive& In);
 	static bool TryReadUObjectPropertyData(::FProperty* Prop, void* Data, const ::FSpudPropertyDef& StoredProperty,
 	                                        const RuntimeObjectMap* RuntimeObjects,
-	                                        ULevel* Level, UObject* Outer, const FSpudClassMetadata& Meta, int Depth, FArchive& In);
+	                                        ULevel* Level, UObject* Outer, const FSpudClassMetadata& Meta,
+	                                        const FSpudEncodingProfile& Encoding, int Depth, FArchive& In);
 	static void SetObjectPropertyValue(FProperty* Property, void* Data, UObject* Obj);
 
 	static UObject* FindObjectWithOverridenName(const UWorld* World, const FString& RefString);
@@ -515,6 +761,30 @@ public:
 		Value = static_cast<T>(SerialisedVal);
 	}
 
+	/// Write an unsigned integer as a variable length (LEB128) value, 7 bits per byte
+	static void WriteVarUInt(uint64 Value, FArchive& Out);
+	/// Read an unsigned integer written by WriteVarUInt. Sets an error on the archive if the data is malformed
+	static uint64 ReadVarUInt(FArchive& In);
+	/// Write a signed integer as a zig-zag encoded variable length value, so small negative values stay small
+	static void WriteVarInt(int64 Value, FArchive& Out);
+	/// Read a signed integer written by WriteVarInt
+	static int64 ReadVarInt(FArchive& In);
+
+	/// Write a value rounded to a multiple of Quantum as a variable length integer, or at full precision if Quantum is 0
+	static void WriteQuantized(double Value, float Quantum, FArchive& Out);
+	/// Read a value written by WriteQuantized, Quantum must be the same as was written with
+	static double ReadQuantized(float Quantum, FArchive& In);
+	static void WriteQuantized(const FVector& Value, float Quantum, FArchive& Out);
+	static void ReadQuantized(FVector& Value, float Quantum, FArchive& In);
+	/// Vectors use the position quantum, rotators the rotation quantum
+	static void WriteQuantized(const FVector& Value, const FSpudEncodingProfile& Encoding, FArchive& Out);
+	static void ReadQuantized(FVector& Value, const FSpudEncodingProfile& Encoding, FArchive& In);
+	static void WriteQuantized(const FRotator& Value, const FSpudEncodingProfile& Encoding, FArchive& Out);
+	static void ReadQuantized(FRotator& Value, const FSpudEncodingProfile& Encoding, FArchive& In);
+	/// Transforms store rotation as a quantized rotator, or the full quaternion if the rotation quantum is 0
+	static void WriteQuantized(const FTransform& Value, const FSpudEncodingProfile& Encoding, FArchive& Out);
+	static void ReadQuantized(FTransform& Value, const FSpudEncodingProfile& Encoding, FArchive& In);
+
 	template <typename T>
 	void WriteProperty(const FString& Name, uint32 PrefixID, const T& Value, TSharedPtr<FSpudClassDef> ClassDef,
 	                   TArray<uint32>& PropertyOffsets, FSpudClassMetadata& Meta, FArchive& Out)
@@ -539,6 +809,8 @@ public:
 	static FStructProperty* FindGuidProperty(const UObject* Obj);
 	/// Get the unique name of an actor within a level
 	static FString GetLevelActorName(const AActor* Actor);
+	/// Same as GetLevelActorName but as an FName, which for actors not overriding their name needs no conversion
+	static FName GetLevelActorKey(const AActor* Actor);
 	/// Get the identifier to use for a global object 
 	static FString GetGlobalObjectID(const UObject* Obj);
 	/// Get the class name of an object 
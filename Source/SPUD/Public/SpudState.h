@@ -5,12 +5,18 @@
 #include "SpudCustomSaveInfo.h"
 #include "SpudData.h"
 #include "SpudPropertyUtil.h"
+#include "UObject/ObjectKey.h"
 
 #include "SpudState.generated.h"
 
 
 SPUD_API DECLARE_LOG_CATEGORY_EXTERN(LogSpudState, Verbose, Verbose);
 
+/// Whether top-level objects only store properties which differ from their archetype (@see USpudSubsystem::bStoreArchetypeDeltas)
+extern SPUD_API bool GSpudStoreArchetypeDeltas;
+/// Whether storing a level keeps existing records & only replaces those which changed (@see USpudSubsystem::bIncrementalLevelStore)
+extern SPUD_API bool GSpudIncrementalLevelStore;
+
 DECLARE_DELEGATE_OneParam(FSpudOnStateLevelStore, const FString&);
 
 /// Description of a save game for display in load game lists, finding latest
@@ -31,9 +37,13 @@ class SPUD_API USpudSaveGameInfo : public UObject
 	/// The name of the save game slot this refers to
 	UPROPERTY(BlueprintReadOnly)
 	FString SlotName;
-	/// Thumbnail screenshot (may be blank if one wasn't included in the save game)
+	/// Thumbnail screenshot (may be blank if one wasn't included in the save game, or if thumbnails weren't requested
+	/// when listing saves; use USpudSubsystem::LoadSaveThumbnail to load it on demand)
 	UPROPERTY(BlueprintReadOnly)
 	TObjectPtr<UTexture2D> Thumbnail;
+	/// Whether the save game includes a thumbnail screenshot, even if it hasn't been loaded
+	UPROPERTY(BlueprintReadOnly)
+	bool bHasThumbnail = false;
 	/// Custom fields that you chose to store with the save header information specifically for your game
 	UPROPERTY(BlueprintReadOnly)
 	TObjectPtr<USpudCustomSaveInfo> CustomInfo;
@@ -47,6 +57,34 @@ enum class ESpudObjectStoreFormat : uint8
 	AssetPath,
 };
 
+/// Result of stepping a level restore
+enum class ESpudLevelRestoreProgress : uint8
+{
+	InProgress,
+	Complete,
+	/// The level or its data was unloaded before the restore completed
+	Abandoned
+};
+
+/// Progress of a level restore, which can be stepped a slice at a time (@see USpudState::BeginIncrementalRestoreLevel)
+struct FSpudLevelRestore
+{
+	TWeakObjectPtr<ULevel> Level;
+	FString LevelName;
+	FSpudSaveData::TLevelDataPtr LevelData;
+	/// Shared by every actor restored, so reference lookups outside this level are indexed once per restore
+	SpudPropertyUtil::RuntimeObjectMap RuntimeObjects;
+	TMap<FGuid, TWeakObjectPtr<AActor>> RestoredRuntimeActors;
+	/// If set, level actors nearest this location are restored first
+	TOptional<FVector> ViewLocation;
+
+	TArray<FGuid> ActorsToRespawn;
+	int32 NextRespawn = 0;
+	TArray<TWeakObjectPtr<AActor>> ActorsToRestore;
+	int32 NextActor = 0;
+	bool bActorsGathered = false;
+};
+
 /// Holds the persistent state of a game.
 /// Persistent state is any state which should be restored on load; whether that's the load of a save
 /// game, or whether that's the loading of a streaming level section within an active game.
@@ -87,7 +125,7 @@ protected:
 
 	FString Source;
 
-	void WriteCoreActorData(AActor* Actor, FArchive& Out) const;
+	void WriteCoreActorData(AActor* Actor, const FSpudEncodingProfile& Encoding, FArchive& Out) const;
 
 	class StorePropertyVisitor : public SpudPropertyUtil::PropertyVisitor
 	{
@@ -97,11 +135,17 @@ protected:
 		TArray<uint32>& PropertyOffsets;
 		FSpudClassMetadata& Meta;
 		FSpudMemoryWriter& Out;
+		/// If set, values identical to this are not written, and are cleared in PresentProperties
+		const UObject* Archetype;
+		TBitArray<>* PresentProperties;
 	public:
-		StorePropertyVisitor(USpudState* ParentState, TSharedPtr<FSpudClassDef> InClassDef, TArray<uint32>& InPropertyOffsets, FSpudClassMetadata& InMeta, FSpudMemoryWriter& InOut);
+		StorePropertyVisitor(USpudState* ParentState, TSharedPtr<FSpudClassDef> InClassDef, TArray<uint32>& InPropertyOffsets, FSpudClassMetadata& InMeta, FSpudMemoryWriter& InOut,
+		                     const UObject* InArchetype = nullptr, TBitArray<>* InPresentProperties = nullptr);
 		void StoreNestedUObjectIfNeeded(UObject* RootObject, FProperty* Property, uint32 CurrentPrefixID, void* ContainerPtr, int Depth);
 		virtual bool VisitProperty(UObject* RootObject, FProperty* Property, uint32 CurrentPrefixID,
 		                           void* ContainerPtr, int Depth) override;
+		virtual bool VisitPlannedProperty(UObject* RootObject, const FSpudPropertyPlanStep& Step, uint32 CurrentPrefixID,
+		                                  void* ContainerPtr, int Depth) override;
 
 		virtual void UnsupportedProperty(UObject* RootObject, FProperty* Property, uint32 CurrentPrefixID,
 			int Depth) override;
@@ -113,37 +157,79 @@ protected:
 	FSpudSpawnedActorData* GetSpawnedActorData(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData, bool AutoCreate);
 	FSpudNamedObjectData* GetGlobalObjectData(const UObject* Obj, bool AutoCreate);
 	FSpudNamedObjectData* GetGlobalObjectData(const FString& ID, bool AutoCreate);
+	FSpudNamedObjectData* GetGlobalObjectData(FName Key, bool AutoCreate);
 
 	bool ShouldActorBeRespawnedOnRestore(AActor* Actor) const;
 	bool ShouldActorTransformBeRestored(AActor* Actor) const;
 	bool ShouldActorVelocityBeRestored(AActor* Actor) const;
-	void StoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData);
+	/// bSkipIfClean: if the actor uses dirty tracking and hasn't changed since its record was stored / restored,
+	/// only update its core data
+	void StoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData, bool bSkipIfClean = false);
 	void StoreLevelActorDestroyed(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData);
+	/// Whether the stored class definition of an actor (if any) still matches its runtime class, which is needed to
+	/// keep existing records while storing its level. Each class is only checked once per CheckedClasses
+	bool IsStoredClassDefCurrent(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData, TSet<const UClass*>& CheckedClasses) const;
 	void StoreGlobalObject(UObject* Obj, FSpudNamedObjectData* Data);
 	void StoreObjectProperties(UObject* Obj, FSpudPropertyData& Properties, FSpudClassMetadata& Meta, int StartDepth = 0);
-	void StoreObjectProperties(UObject* Obj, uint32 PrefixID, TArray<uint32>& PropertyOffsets, FSpudClassMetadata& Meta, FSpudMemoryWriter& Out, int StartDepth = 0);
+	void StoreObjectProperties(UObject* Obj, uint32 PrefixID, TArray<uint32>& PropertyOffsets, FSpudClassMetadata& Meta, FSpudMemoryWriter& Out, int StartDepth = 0,
+	                           TBitArray<>* OutPresentProperties = nullptr);
+
+	/// Actors are encoded into these first, then only copied to their records if different
+	TArray<uint8> ScratchCoreData;
+	FSpudPropertyData ScratchProperties;
+	TArray<uint8> ScratchCustomData;
+
+	/// Number of times objects using dirty tracking have been marked dirty (+1, since 0 means unknown in records).
+	/// Objects which have never been marked aren't in here
+	TMap<FObjectKey, uint32> DirtyGenerations;
+	uint32 GetDirtyGeneration(const UObject* Obj) const;
+	/// Drop the dirty generations of actors which are about to go away, e.g. with their level
+	void ForgetDirtyGenerations(const TArray<AActor*>& Actors);
+	/// Drop the dirty generations of objects which no longer exist
+	void PruneDirtyGenerations();
+
+	/// Level restores in progress, in the order they were begun
+	TArray<TSharedPtr<FSpudLevelRestore>> IncrementalRestores;
+	/// Start a restore of a level, but don't process any of it yet. Returns null if there's nothing to restore
+	TSharedPtr<FSpudLevelRestore> CreateLevelRestore(ULevel* Level, const TOptional<FVector>& ViewLocation);
+	/// Set while a level restore destroys the actors recorded as destroyed
+	bool bDestroyingRestoredActors = false;
+	/// Whether incremental restores which have finished succeeded, until collected by FinishIncrementalRestore
+	TMap<FString, bool> FinishedIncrementalRestores;
+	/// Continue a level restore until it's finished or EndTime (FPlatformTime::Seconds) is reached, always making
+	/// some progress
+	ESpudLevelRestoreProgress StepLevelRestore(FSpudLevelRestore& Restore, double EndTime);
+	/// Step the incremental restore at Index, removing it if it finishes. Returns whether it finished
+	bool StepIncrementalRestore(int32 Index, double EndTime);
+	/// Index of the incremental restore of a level in IncrementalRestores, or INDEX_NONE
+	int32 FindIncrementalRestore(const FString& LevelName) const;
+	/// Complete any restore in progress of this level before its state is stored, so half-restored actors aren't stored
+	void FinishIncrementalRestoreBeforeStore(const FString& LevelName);
 	
 	// Returns whether this is an actor which is not technically in a level, but is auto-created so doesn't need to be
 	// spawned by the restore process. E.g. GameMode, Pawns
 	bool ShouldRespawnRuntimeActor(const AActor* Actor) const;
 	void PreRestoreObject(UObject* Obj, uint32 StoredUserVersion);
 	void PostRestoreObject(UObject* Obj, const FSpudCustomData& FromCustomData, uint32 StoredUserVersion);
-	void RestoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData, const TMap<FGuid, UObject*>* RuntimeObjects);
+	void RestoreActor(AActor* Actor, FSpudSaveData::TLevelDataPtr LevelData, const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects);
 	void RestoreGlobalObject(UObject* Obj, const FSpudNamedObjectData* Data);
 	AActor* RespawnActor(const FSpudSpawnedActorData& SpawnedActor, const FSpudClassMetadata& Meta, ULevel* Level);
 	void DestroyActor(const FSpudDestroyedLevelActor& DestroyedActor, ULevel* Level);
-	void RestoreCoreActorData(AActor* Actor, const FSpudCoreActorData& FromData);
+	void RestoreCoreActorData(AActor* Actor, const FSpudCoreActorData& FromData, const FSpudEncodingProfile& Encoding);
 	void RestoreObjectProperties(UObject* Obj, const FSpudPropertyData& FromData, const FSpudClassMetadata& Meta, TSharedPtr<const FSpudClassDef> StoredClassDef,
-	                             const TMap<FGuid, UObject*>* RuntimeObjects, int StartDepth = 0);
+	                             const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects, int StartDepth = 0);
 	void RestoreObjectProperties(UObject* Obj, FSpudMemoryReader& In, const FSpudClassMetadata& Meta,
 								 TSharedPtr<const FSpudClassDef> StoredClassDef, const TArray<uint32>& PropertyOffsets,
-								 const TMap<FGuid, UObject*>* RuntimeObjects, int StartDepth = 0);
+								 const TBitArray<>* PresentProperties,
+								 const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects, int StartDepth = 0);
 	void RestoreObjectPropertiesFast(UObject* Obj, FSpudMemoryReader& In, const FSpudClassMetadata& Meta,
 	                                 TSharedPtr<const FSpudClassDef> ClassDef, const TArray<uint32>& PropertyOffsets,
-	                                 const TMap<FGuid, UObject*>* RuntimeObjects, int StartDepth = 0);
+	                                 const TBitArray<>* PresentProperties,
+	                                 const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects, int StartDepth = 0);
 	void RestoreObjectPropertiesSlow(UObject* Obj, FSpudMemoryReader& In, const FSpudClassMetadata& Meta,
 									 TSharedPtr<const FSpudClassDef> ClassDef, const TArray<uint32>& PropertyOffsets, 
-									 const TMap<FGuid, UObject*>* RuntimeObjects, int StartDepth = 0);
+									 const TBitArray<>* PresentProperties,
+									 const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects, int StartDepth = 0);
 
 	class RestorePropertyVisitor : public SpudPropertyUtil::PropertyVisitor
 	{
@@ -152,15 +238,27 @@ protected:
 		TSharedPtr<const FSpudClassDef> ClassDef;
 		const TArray<uint32>& PropertyOffsets;
 		const FSpudClassMetadata& Meta;
-		const TMap<FGuid, UObject*>* RuntimeObjects;
+		const SpudPropertyUtil::RuntimeObjectMap* RuntimeObjects;
 		FSpudMemoryReader& DataIn;
+		/// Only for data stored as an archetype delta, null otherwise
+		const TBitArray<>* PresentProperties;
+		const UObject* Archetype;
 	public:
 		RestorePropertyVisitor(USpudState* Parent, FSpudMemoryReader& InDataIn, TSharedPtr<const FSpudClassDef> InClassDef, const TArray<uint32>& InPropertyOffsets,
-							   const FSpudClassMetadata& InMeta, const TMap<FGuid, UObject*>* InRuntimeObjects):
-			ParentState(Parent), ClassDef(InClassDef), PropertyOffsets(InPropertyOffsets), Meta(InMeta), RuntimeObjects(InRuntimeObjects), DataIn(InDataIn) {}
+							   const TBitArray<>* InPresentProperties, const UObject* InArchetype,
+							   const FSpudClassMetadata& InMeta, const SpudPropertyUtil::RuntimeObjectMap* InRuntimeObjects):
+			ParentState(Parent), ClassDef(InClassDef), PropertyOffsets(InPropertyOffsets), Meta(InMeta), RuntimeObjects(InRuntimeObjects), DataIn(InDataIn),
+			PresentProperties(InPresentProperties), Archetype(InArchetype) {}
 
 		virtual uint32 GetNestedPrefix(FProperty* Prop, uint32 CurrentPrefixID) override;
 		virtual void RestoreNestedUObjectIfNeeded(UObject* RootObject, FProperty* Property, uint32 CurrentPrefixID, void* ContainerPtr, int Depth);
+		/// Whether the stored property at this index has data, or was left out because it was identical to the archetype
+		bool IsPropertyPresent(int Index) const
+		{
+			return !PresentProperties || !PresentProperties->IsValidIndex(Index) || (*PresentProperties)[Index];
+		}
+		/// Restore a property which was identical to the archetype when stored
+		void RestoreUnchangedProperty(UObject* RootObject, FProperty* Property, void* ContainerPtr, int Depth);
 	};
 
 
@@ -172,14 +270,17 @@ protected:
 	public:
 		RestoreFastPropertyVisitor(USpudState* Parent, const TArray<FSpudPropertyDef>::TConstIterator& InStoredPropertyIterator,
 		                           FSpudMemoryReader& InDataIn, TSharedPtr<const FSpudClassDef> InClassDef, const TArray<uint32>& InPropertyOffsets,
-		                           const FSpudClassMetadata& InMeta, const TMap<FGuid, UObject*>* InRuntimeObjects)
-			: RestorePropertyVisitor(Parent, InDataIn, InClassDef, InPropertyOffsets, InMeta, InRuntimeObjects),
+		                           const TBitArray<>* InPresentProperties, const UObject* InArchetype,
+		                           const FSpudClassMetadata& InMeta, const SpudPropertyUtil::RuntimeObjectMap* InRuntimeObjects)
+			: RestorePropertyVisitor(Parent, InDataIn, InClassDef, InPropertyOffsets, InPresentProperties, InArchetype, InMeta, InRuntimeObjects),
 			  StoredPropertyIterator(InStoredPropertyIterator)
 		{
 		}
 
 		virtual bool VisitProperty(UObject* RootObject, FProperty* Property, uint32 CurrentPrefixID,
 		                           void* ContainerPtr, int Depth) override;
+		virtual bool VisitPlannedProperty(UObject* RootObject, const FSpudPropertyPlanStep& Step, uint32 CurrentPrefixID,
+		                                  void* ContainerPtr, int Depth) override;
 	};
 	
 	// Slow path restoration when runtime class is the same as stored class
@@ -187,8 +288,9 @@ protected:
 	{
 	public:
 		RestoreSlowPropertyVisitor(USpudState* Parent, FSpudMemoryReader& InDataIn, TSharedPtr<const FSpudClassDef> InClassDef, const TArray<uint32>& InPropertyOffsets,
-								   const FSpudClassMetadata& InMeta, const TMap<FGuid, UObject*>* InRuntimeObjects)
-			: RestorePropertyVisitor(Parent, InDataIn, InClassDef, InPropertyOffsets, InMeta, InRuntimeObjects) {}
+								   const TBitArray<>* InPresentProperties, const UObject* InArchetype,
+								   const FSpudClassMetadata& InMeta, const SpudPropertyUtil::RuntimeObjectMap* InRuntimeObjects)
+			: RestorePropertyVisitor(Parent, InDataIn, InClassDef, InPropertyOffsets, InPresentProperties, InArchetype, InMeta, InRuntimeObjects) {}
 
 		virtual bool VisitProperty(UObject* RootObject, FProperty* Property, uint32 CurrentPrefixID,
 		                           void* ContainerPtr, int Depth) override;
@@ -240,6 +342,9 @@ public:
 	/// Will page in the level data concerned from disk if necessary and will retain it in memory
 	void StoreLevelActorDestroyed(AActor* Actor);
 
+	/// Record that the persistent state of an object which uses dirty tracking has changed (@see ISpudObject::MarkSpudDirty)
+	void MarkObjectDirty(const UObject* Obj);
+
 	/// Stores any data for all levels to disk and releases the memory being used to store persistent state
 	void ReleaseAllLevelData();
 
@@ -265,10 +370,36 @@ public:
 	/// Specialised function for restoring a specific level by reference
 	void RestoreLevel(ULevel* Level);
 
+	/// Begin restoring a level a slice at a time instead of all at once; call UpdateIncrementalRestores to make
+	/// progress. Respawned actors come first as with RestoreLevel, then level actors nearest ViewLocation if supplied.
+	/// Actors aren't fully restored until the restore completes, so anything which stores the level first completes it.
+	/// Returns false if there was nothing to restore
+	bool BeginIncrementalRestoreLevel(ULevel* Level, const TOptional<FVector>& ViewLocation);
+
+	/// Make progress on incremental level restores, oldest first, for up to BudgetSeconds.
+	/// @returns The names of levels whose restore completed in this call
+	TArray<FString> UpdateIncrementalRestores(double BudgetSeconds);
+
+	/// Immediately complete an incremental restore of a level, if one is in progress
+	/// @returns Whether the restore succeeded, including one which already finished (e.g. because the level was
+	/// stored). False if it was abandoned, or there was no restore of the level
+	bool FinishIncrementalRestore(const FString& LevelName);
+
+	/// Abandon all incremental restores in progress, e.g. because the map is changing
+	void CancelIncrementalRestores();
+
+	/// Whether a level is part way through an incremental restore
+	bool IsIncrementalRestoreInProgress(const FString& LevelName) const;
+
 	/// Request that data for a level is loaded in the calling thread
 	/// Useful for pre-caching before RestoreLevel
 	bool PreLoadLevelData(const FString& LevelName);
 
+	/// Get the classes & assets referenced by a level's data which aren't loaded yet. Loading these together
+	/// (e.g. with FStreamableManager) before RestoreLevel avoids it having to load each one synchronously.
+	/// Must be called on the game thread
+	TArray<FSoftObjectPath> GetLevelAssetsToPreload(const FString& LevelName);
+
 	// Restores the world and all levels currently in it, on the assumption that it's already loaded into the correct map
 	void RestoreLoadedWorld(UWorld* World);
 
@@ -297,13 +428,38 @@ public:
 	/// This includes all paged out level data, which will be recombined
 	virtual void SaveToArchive(FArchive& SPUDAr);
 
+	/// Take a copy of the state in memory, which can be written with SaveSnapshotToArchive in another thread while
+	/// this state continues to be used. Paged out level data isn't copied, it's piped from the level files when written.
+	TSharedRef<FSpudSaveData, ESPMode::ThreadSafe> CreateSaveSnapshot();
+
+	/// Write a snapshot created by CreateSaveSnapshot to an archive, including all paged out level data.
+	/// Safe to call from any thread.
+	void SaveSnapshotToArchive(FSpudSaveData& Snapshot, FArchive& SPUDAr);
+
 	/**
 	 * @brief 
 	 * @param SPUDAr The save file archive
 	 * @param bFullyLoadAllLevelData If true, load all data into memory including all data for all levels. If false,
 	 * only load global data and enumerate levels, piping level data to separate disk files instead for loading individually later
+	 * @param ProgressCallback Optional callback for progress updates. Called on the thread doing the loading.
+	 * @param SourceFilePath Optional path of the file SPUDAr is reading. If supplied, level data which isn't loaded is
+	 * left in this file and paged in from there when needed, instead of being split into separate files. Only levels
+	 * which have been loaded and released again are written out separately. You must call ReleaseSourceFile before
+	 * overwriting or deleting this file.
 	 */
-	virtual void LoadFromArchive(FArchive& SPUDAr, bool bFullyLoadAllLevelData);
+	virtual void LoadFromArchive(FArchive& SPUDAr, bool bFullyLoadAllLevelData, const FSpudReadProgressCallback& ProgressCallback = nullptr,
+	                             const FString& SourceFilePath = FString());
+
+	/// If level data is being paged from the given save file (see LoadFromArchive), copy whatever is still needed from
+	/// it so that it's safe to overwrite or delete the file.
+	/// @returns False if level data couldn't be copied, in which case the file is still needed
+	bool ReleaseSourceFile(const FString& Filename);
+
+	/// If level data is being paged from the given save file, copy whatever is still needed from it into the level
+	/// cache, so that the file can be replaced. Unlike ReleaseSourceFile this is safe to call from another thread
+	/// while the game thread uses this state, but ReleaseSourceFile must still be called afterwards.
+	/// @returns False if level data couldn't be copied, in which case the file mustn't be replaced
+	bool ExtractLevelsFromSourceFile(const FString& Filename);
 
 	/// Get the name of the persistent level which the player is on in this state
 	FString GetPersistentLevel() const { return SaveData.GlobalData.CurrentLevel; }
@@ -374,7 +530,11 @@ public:
 
 	/// Utility method to read *just* the information part of a save game from the start of an archive
 	/// This only reads the minimum needed to describe the save file and doesn't load any other data.
-	static bool LoadSaveInfoFromArchive(FArchive& SPUDAr, USpudSaveGameInfo& OutInfo);
+	/// If bIncludeThumbnail is false, the thumbnail image is skipped over rather than loaded & decoded
+	static bool LoadSaveInfoFromArchive(FArchive& SPUDAr, USpudSaveGameInfo& OutInfo, bool bIncludeThumbnail = true);
+	/// Populate a Blueprint save game description from the stored info chunk of a save. The thumbnail is only
+	/// decoded if the image data was loaded.
+	static void PopulateSaveGameInfo(const FSpudSaveInfo& StorageInfo, USpudSaveGameInfo& OutInfo);
 
 	bool bTestRequireSlowPath = false;
 	bool bTestRequireFastPath = false;
@@ -8,6 +8,10 @@
 #include "Tickable.h"
 #include "Engine/World.h"
 
+#include "Async/Future.h"
+#include "Engine/StreamableManager.h"
+#include <atomic>
+
 #include "SpudSubsystem.generated.h"
 
 class USpudRuntimeStoredActorComponent;
@@ -15,6 +19,7 @@ DECLARE_LOG_CATEGORY_EXTERN(LogSpudSubsystem, Verbose, Verbose);
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FSpudPreLoadGame, const FString&, SlotName);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FSpudPostLoadGame, const FString&, SlotName, bool, bSuccess);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FSpudLoadGameProgress, const FString&, SlotName, int64, BytesProcessed, int64, TotalBytes, int32, LevelsProcessed);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FSpudPreSaveGame, const FString&, SlotName);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FSpudPostSaveGame, const FString&, SlotName, bool, bSuccess);
 
@@ -63,6 +68,17 @@ enum class ESpudSaveSorting : uint8
 	Title
 };
 
+UENUM(BlueprintType)
+enum class ESpudScreenshotFormat : uint8
+{
+	/// PNG; smallest lossless option, but the slowest to encode
+	PNG,
+	/// PNG without compression; much quicker to encode but a bigger file
+	UncompressedPNG,
+	/// JPEG; quick to encode and small, but lossy
+	JPEG
+};
+
 UCLASS(Transient)
 class SPUD_API USpudStreamingLevelWrapper : public UObject
 {
@@ -93,6 +109,10 @@ public:
 	/// Event fired just after a game has finished loading
 	UPROPERTY(BlueprintAssignable)
 	FSpudPostLoadGame PostLoadGame;
+	/// Event fired periodically while a save game is being read when bAsyncLoadGame is enabled
+	/// Always fired on the game thread, at most once per frame
+	UPROPERTY(BlueprintAssignable)
+	FSpudLoadGameProgress LoadGameProgress;
 	/// Event fired just before a game is saved
 	UPROPERTY(BlueprintAssignable)
 	FSpudPreSaveGame PreSaveGame;
@@ -146,6 +166,10 @@ public:
 	/// The desired height of screenshots taken for save games
 	UPROPERTY(BlueprintReadWrite, Config)
 	int32 ScreenshotHeight = 135;
+	/// The image format screenshots are stored in. Saves can always be listed whatever this is set to.
+	/// Screenshots are resized & encoded in a background thread either way.
+	UPROPERTY(BlueprintReadWrite, Config)
+	ESpudScreenshotFormat ScreenshotFormat = ESpudScreenshotFormat::PNG;
 
 	FDelegateHandle OnScreenshotCapturedHandle;
 	FDelegateHandle OnScreenshotRequestProcessedHandle;
@@ -164,6 +188,99 @@ public:
 	UPROPERTY(BlueprintReadWrite, Config)
 	TArray<FString> ExcludeLevelNamePatterns;
 
+	/// If true, LoadGame reads the save file & splits level data in a background thread, and loads the persistent map
+	/// package asynchronously, before travelling to the map. The game thread is not blocked while this happens, so
+	/// you can keep a loading screen animating; use LoadGameProgress to display progress.
+	/// PostLoadGame still fires once the map has been loaded & restored, as with synchronous loading.
+	/// Not used for platforms which use the SaveGameSystem.
+	UPROPERTY(BlueprintReadWrite, Config)
+	bool bAsyncLoadGame = false;
+
+	/// If true (the default), classes & assets referenced by a level's saved data which aren't loaded yet (e.g.
+	/// Blueprint classes of runtime spawned actors) are loaded together asynchronously when a streaming level is
+	/// loaded, and the level is only restored once they're all resident. If false, each one is loaded synchronously
+	/// during the restore. When a map is loaded they're always loaded together, but synchronously.
+	UPROPERTY(BlueprintReadWrite, Config)
+	bool bPreloadLevelAssets = true;
+
+	/// If true, streaming levels are restored a slice at a time over several frames rather than all at once, so large
+	/// levels don't cause a hitch. Actors nearest the player's view are restored first. The level is made visible
+	/// straight away, but PostLevelRestore only fires (and destroyed actors are only tracked) once it's complete;
+	/// anything which stores the level before then completes the restore first. Maps loaded by LoadGame or travel
+	/// are always restored all at once.
+	UPROPERTY(BlueprintReadWrite, Config)
+	bool bTimeSlicedLevelRestore = false;
+
+	/// The time in milliseconds per frame to spend restoring levels when bTimeSlicedLevelRestore is enabled. At
+	/// least one actor is restored each frame however small this is.
+	UPROPERTY(BlueprintReadWrite, Config)
+	float LevelRestoreBudgetMs = 2.f;
+
+	/// If true, SaveGame only takes a copy of the state on the game thread, and serializing it, re-combining the
+	/// paged out level data and writing the file all happen in a background thread. PostSaveGame fires when the file
+	/// has been written. Not used for platforms which use the SaveGameSystem.
+	UPROPERTY(BlueprintReadWrite, Config)
+	bool bBackgroundSaveGame = false;
+
+	/// If true, when a game is loaded the level data is left in the save file and paged in from there when each level
+	/// is loaded, rather than all being split out into separate files in the level cache first. Levels only go into
+	/// the cache once they've been loaded and unloaded again. Makes loading much cheaper for games with lots of levels.
+	/// The save file being played from must not be changed outside of SPUD while this is in use.
+	/// Not used for platforms which use the SaveGameSystem.
+	UPROPERTY(BlueprintReadWrite, Config)
+	bool bPageLevelsFromSaveFile = false;
+
+	/// Compression format for level data, used both in save files and paged out level files. Can be any format
+	/// supported by FCompression: Zlib, Gzip, LZ4 or Oodle. None (the default) means no compression.
+	/// Each level is compressed separately so it can be paged in or piped into a save without recompressing. Saves
+	/// can always be loaded whatever this is set to. Use SetLevelDataCompressionFormat to change this at runtime.
+	UPROPERTY(BlueprintReadOnly, Config)
+	FName LevelDataCompressionFormat = NAME_None;
+
+	/// If true, classes first stored from now on use a compact encoding for their property & core actor data: variable
+	/// length integers, bit-packed bool arrays, zero velocities omitted, and optionally quantized vectors, rotators &
+	/// transforms (see the Compact*Quantum settings). The encoding is recorded per class in the save, so saves can
+	/// always be loaded whatever this is set to. Use SetCompactEncoding to change this at runtime.
+	UPROPERTY(BlueprintReadOnly, Config)
+	bool bCompactEncoding = false;
+
+	/// Quantization step for vectors, transform translations & velocities with compact encoding, e.g. 0.01 (0.1mm).
+	/// 0 (the default) keeps full precision
+	UPROPERTY(BlueprintReadOnly, Config)
+	float CompactPositionQuantum = 0;
+
+	/// Quantization step in degrees for rotators & transform rotations with compact encoding, e.g. 0.01.
+	/// 0 (the default) keeps full precision
+	UPROPERTY(BlueprintReadOnly, Config)
+	float CompactRotationQuantum = 0;
+
+	/// Quantization step for transform scale with compact encoding, e.g. 0.001. 0 (the default) keeps full precision
+	UPROPERTY(BlueprintReadOnly, Config)
+	float CompactScaleQuantum = 0;
+
+	/// If true, classes first stored from now on write actor references as indexes into a per-level
+	/// table of referenced actors, holding binary GUIDs for runtime actors and names for level actors. Each referenced
+	/// actor is then only stored and resolved once per level rather than once per reference. Recorded per class like
+	/// bCompactEncoding, so saves can always be loaded whatever this is set to.
+	UPROPERTY(BlueprintReadOnly, Config)
+	bool bIndexedObjectReferences = false;
+
+	/// If true, actors & global objects only store the properties whose values differ from their archetype (usually
+	/// the class defaults), and a bitmap of which ones those are. Unchanged properties are set back to the archetype
+	/// value on restore. Much smaller saves when most state is untouched, but if you change a class default, objects
+	/// which were saved with the old default will pick up the new one. Nested UObjects & object references are always
+	/// stored in full. Saves can always be loaded whatever this is set to. Use SetStoreArchetypeDeltas to change this
+	/// at runtime.
+	UPROPERTY(BlueprintReadOnly, Config)
+	bool bStoreArchetypeDeltas = false;
+
+	/// If true, storing a level (on save, or when a streaming level unloads) keeps the existing actor records and
+	/// only replaces those whose data changed, instead of rebuilding the level data from scratch. Level data which
+	/// turns out not to have changed at all isn't written back to the level cache when released. Falls back to a
+	/// full store if the stored class definitions don't match the runtime classes any more.
+	UPROPERTY(BlueprintReadOnly, Config)
+	bool bIncrementalLevelStore = false;
+
 	UPROPERTY(BlueprintReadOnly)
 	TSet<TObjectPtr<USpudRuntimeStoredActorComponent>> RegisteredRuntimeStoredActorComponents;
 
@@ -190,6 +307,27 @@ protected:
 	TMap<FString, TWeakObjectPtr<UObject>> NamedGlobalObjects;
 	UPROPERTY(Transient)
 	TObjectPtr<UWorld> WorldToLoad;
+	FString TravelOptionsInProgress;
+
+	/// Result of the background save file read when loading asynchronously, valid only while in progress
+	TFuture<bool> AsyncLoadGameResult;
+	/// Progress of the background read, written by the loading thread & broadcast on the game thread
+	std::atomic<int64> AsyncLoadBytesProcessed { 0 };
+	std::atomic<int64> AsyncLoadTotalBytes { 0 };
+	std::atomic<int32> AsyncLoadLevelsProcessed { 0 };
+	int32 AsyncLoadLastBroadcastLevels = -1;
+	/// Loads the classes & assets a level's data needs before it's restored (@see bPreloadLevelAssets)
+	FStreamableManager StreamableManager;
+	/// The latest preload request for each streaming level waiting for its assets. Older requests for the same level
+	/// (if it was unloaded & loaded again meanwhile) are ignored when they complete
+	TMap<FName, uint32> PendingLevelPreloads;
+	uint32 LevelPreloadCounter = 0;
+	/// Streaming levels part way through a time sliced restore (@see bTimeSlicedLevelRestore)
+	TSet<FName> LevelsRestoringTimeSliced;
+	/// Result of the background save file write when saving in the background, valid only while in progress
+	TFuture<bool> AsyncSaveGameResult;
+	/// Encoded screenshot for the save in progress, resized & encoded in the background. Valid only while in progress
+	TFuture<TArray<uint8>> AsyncScreenshotResult;
 	
 	UPROPERTY(BlueprintReadOnly)
 	ESpudSystemState CurrentState = ESpudSystemState::RunningIdle;
@@ -237,6 +375,8 @@ protected:
 	TMap<TObjectPtr<ULevelStreaming>, TObjectPtr<USpudStreamingLevelWrapper>> MonitoredStreamingLevels;
 
 	bool ServerCheck(bool LogWarning) const;
+	/// Copy the compact encoding settings to the profile used for new class definitions
+	void UpdateEncodingProfile();
 
 	UFUNCTION()
 	void OnPreLoadMap(const FString& MapName);
@@ -258,6 +398,16 @@ protected:
     void PostUnloadStreamLevel(int32 LinkID);
 	UFUNCTION(BlueprintCallable)
     void PostLoadStreamLevelGameThread(FName LevelName);
+	void RestoreStreamLevel(FName LevelName);
+	/// Restore a level still waiting for its preload now, without waiting for the rest of its assets
+	void FinishLevelPreload(FName LevelName);
+	/// Continue time sliced level restores, and complete those which have finished
+	void UpdateTimeSlicedRestores();
+	/// Complete a time sliced restore of a level now if one is in progress, then fire PostLevelRestore with its result
+	void FinishTimeSlicedRestore(FName LevelName);
+	void CancelTimeSlicedRestores();
+	/// Where restores should prioritise actors from, if there's a player to get it from
+	TOptional<FVector> GetRestoreViewLocation() const;
 	UFUNCTION(BlueprintCallable)
     void PostUnloadStreamLevelGameThread(FName LevelName);
 
@@ -273,6 +423,13 @@ protected:
 	void ResetScreenshotState();
 
 	void FinishSaveGame(const FString& SlotName, const FText& Title, const USpudCustomSaveInfo* ExtraInfo, TArray<uint8>* ScreenshotData);
+	void StartAsyncLoadGame(const FString& SlotName, const FString& TravelOptions);
+	void UpdateAsyncLoadGame();
+	void UpdateAsyncSaveGame();
+	void UpdateAsyncScreenshot();
+	void WaitForAsyncOperations();
+	void OnAsyncLoadGameWorldPackageLoaded(const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result);
+	void FinishLoadGame(const FString& SlotName, const FString& TravelOptions);
 	void LoadComplete(const FString& SlotName, bool bSuccess);
 	void SaveComplete(const FString& SlotName, bool bSuccess);
 
@@ -436,8 +593,34 @@ public:
 	void WithdrawRequestForStreamingLevel(UObject* Requester, FName LevelName);
 
 	/// Get the list of the save games with metadata
+	/// If bIncludeThumbnails is false, thumbnails are not loaded; use LoadSaveThumbnail to load the ones you display
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly)
-	TArray<USpudSaveGameInfo*> GetSaveGameList(bool bIncludeQuickSave = true, bool bIncludeAutoSave = true, ESpudSaveSorting Sorting = ESpudSaveSorting::None);
+	TArray<USpudSaveGameInfo*> GetSaveGameList(bool bIncludeQuickSave = true, bool bIncludeAutoSave = true, ESpudSaveSorting Sorting = ESpudSaveSorting::None, bool bIncludeThumbnails = true);
+
+	/**
+	 * Get the list of the save games with metadata, without blocking the game thread (asynchronously)
+	 * The slot index is brought up to date in a background thread, reading only saves which have changed since it
+	 * was last written. Use this for save / load menus so they don't hitch when there are lots of saves.
+	 * @param bIncludeQuickSave Whether to include the quick save slot
+	 * @param bIncludeAutoSave Whether to include the auto save slot
+	 * @param Sorting How to sort the list
+	 * @param bIncludeThumbnails Whether to load thumbnails. It's better not to if you have lots of saves, and use
+	 * LoadSaveThumbnail for only those on screen instead.
+	 * @param SaveGames The list of save games, populated on completion
+	 * @param LatentInfo Completion callback
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, meta=(Latent, LatentInfo = "LatentInfo"), Category="SPUD")
+	void GetSaveGameListAsync(bool bIncludeQuickSave, bool bIncludeAutoSave, ESpudSaveSorting Sorting, bool bIncludeThumbnails, TArray<USpudSaveGameInfo*>& SaveGames, FLatentActionInfo LatentInfo);
+
+	/**
+	 * Load the thumbnail screenshot of a save game (asynchronously)
+	 * Only the thumbnail image is read from the save, and it's decoded in a background thread.
+	 * @param SlotName The save game slot
+	 * @param Thumbnail The thumbnail texture, populated on completion. Null if the save has no thumbnail.
+	 * @param LatentInfo Completion callback
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, meta=(Latent, LatentInfo = "LatentInfo"), Category="SPUD")
+	void LoadSaveThumbnail(const FString& SlotName, UTexture2D*& Thumbnail, FLatentActionInfo LatentInfo);
 
 	/// Get info about the latest save game
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly)
@@ -490,6 +673,35 @@ public:
 	UFUNCTION(BlueprintCallable)
     int32 GetUserDataModelVersion() const;
 
+	/// Change the compression format used when level data is next written (@see LevelDataCompressionFormat)
+	UFUNCTION(BlueprintCallable)
+	void SetLevelDataCompressionFormat(FName Format);
+
+	/// Change whether classes first stored from now on use the compact encoding (@see bCompactEncoding)
+	UFUNCTION(BlueprintCallable)
+	void SetCompactEncoding(bool bCompact);
+
+	/// Change whether classes first stored from now on use a reference table for actor references (@see bIndexedObjectReferences)
+	UFUNCTION(BlueprintCallable)
+	void SetIndexedObjectReferences(bool bIndexed);
+
+	/// Change whether objects stored from now on only store properties which differ from their archetype (@see bStoreArchetypeDeltas)
+	UFUNCTION(BlueprintCallable)
+	void SetStoreArchetypeDeltas(bool bDeltas);
+
+	/// Change whether levels are stored incrementally from now on (@see bIncrementalLevelStore)
+	UFUNCTION(BlueprintCallable)
+	void SetIncrementalLevelStore(bool bIncremental);
+
+	/// Whether a streaming level is still part way through a time sliced restore (@see bTimeSlicedLevelRestore)
+	UFUNCTION(BlueprintCallable)
+	bool IsLevelRestoreInProgress(const FString& LevelName) const;
+
+	/// Tell SPUD that the persistent state of an object which uses dirty tracking has changed, so it needs storing
+	/// again (@see ISpudObject::UsesSpudDirtyTracking)
+	UFUNCTION(BlueprintCallable)
+	void MarkSpudDirty(UObject* Obj);
+
 	/**
 	 * Triggers the upgrade process for all save games (asynchronously)
 	 * 
@@ -560,6 +772,19 @@ public:
 	static FString GetSaveGameFilePath(const FString& SlotName);
 	// Lists saves: note that this is only the filenames, not the directory
 	static void ListSaveGameFiles(TArray<FString>& OutSaveFileList);
+	static FString GetSlotIndexFilePath();
+	/// Bring the slot index up to date with the saves present, and get the entries for all of them. Only saves which
+	/// are new or have changed since the index was written are read. Can be called from any thread.
+	/// Screenshot image data is only loaded into the entries if bIncludeScreenshots is true.
+	static void GetSlotIndexEntries(TArray<FSpudSlotIndexEntry>& OutEntries, bool bIncludeScreenshots = false);
+	/// Read just the (encoded) thumbnail image of a save. Can be called from any thread.
+	static bool ReadSaveThumbnailData(const FString& SlotName, TArray<uint8>& OutImageData);
+	/// Record the info of a save which has just been written in the slot index
+	static void UpdateSlotIndex(const FString& SlotName, const FSpudSaveInfo& Info);
+	/// Remove a deleted save from the slot index
+	static void RemoveFromSlotIndex(const FString& SlotName);
+	/// Create save game descriptions from slot index entries
+	static TArray<USpudSaveGameInfo*> MakeSaveGameList(const TArray<FSpudSlotIndexEntry>& Entries, bool bIncludeQuickSave, bool bIncludeAutoSave, ESpudSaveSorting Sorting);
 	static FString GetActiveGameFolder();
 	static FString GetActiveGameFilePath(const FString& Name);
 
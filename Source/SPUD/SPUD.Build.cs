@@ -50,6 +50,7 @@ public class SPUD : ModuleRules
 			{
 				"StructUtils",
 				"ImageCore",
+				"ImageWrapper",
 			}
 			);
 		
@@ -1,8 +1,12 @@
 ﻿#include "Misc/AutomationTest.h"
 #include "SpudState.h"
 #include "TestSaveObject.h"
+#include "Engine/Engine.h"
 #include "Engine/PointLight.h"
 #include "Engine/StaticMeshActor.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Engine/World.h"
 
 
 template<typename T>
@@ -235,6 +239,51 @@ void CheckAllTypes(FAutomationTestBase* Test, const FString& Prefix, const T1& A
 
 }
 
+/// A game world with no map, for tests which need actors in a level. Destroyed when this goes out of scope
+class FSpudTestWorld
+{
+public:
+	UWorld* World;
+
+	FSpudTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+		FWorldContext& Context = GEngine->CreateNewWorldContext(EWorldType::Game);
+		Context.SetCurrentWorld(World);
+	}
+
+	~FSpudTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	ULevel* GetLevel() const { return World->PersistentLevel; }
+	FString GetLevelName() const { return USpudState::GetLevelName(World->PersistentLevel); }
+
+	ATestSaveActor* SpawnTestActor(int IntVal, bool bDirtyTracking = false, const FVector& Location = FVector::ZeroVector) const
+	{
+		auto Actor = World->SpawnActor<ATestSaveActor>(Location, FRotator::ZeroRotator);
+		Actor->IntVal = IntVal;
+		Actor->bDirtyTracking = bDirtyTracking;
+		return Actor;
+	}
+};
+
+/// The level data for a level as it would be written to a save
+TArray<uint8> GetLevelDataBytes(USpudState* State, const FString& LevelName)
+{
+	TArray<uint8> Bytes;
+	auto LevelData = State->SaveData.GetLevelData(LevelName, false, "");
+	if (LevelData.IsValid())
+	{
+		FMemoryWriter Writer(Bytes);
+		FSpudChunkedDataArchive Ar(Writer);
+		LevelData->WriteToArchive(Ar);
+	}
+	return Bytes;
+}
+
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestBasicAllTypes, "SPUDTest.BasicAllTypes",
                                  EAutomationTestFlags::EditorContext |
                                  EAutomationTestFlags::ClientContext |
@@ -542,3 +591,537 @@ bool FTestSlowPath_DifferentPropertyOrder::RunTest(const FString& Parameters)
 
 	return true;
 }
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestTableOfContents, "SPUDTest.TableOfContents",
+	EAutomationTestFlags::EditorContext |
+	EAutomationTestFlags::ClientContext |
+	EAutomationTestFlags::ProductFilter)
+
+bool FTestTableOfContents::RunTest(const FString& Parameters)
+{
+	FSpudSaveData SaveData;
+	SaveData.PrepareForWrite();
+	SaveData.GlobalData.CurrentLevel = "LevelB";
+	SaveData.CreateLevelData("LevelA")->DestroyedActors.Add("ActorA");
+	SaveData.CreateLevelData("LevelB")->DestroyedActors.Add("ActorB");
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	FSpudChunkedDataArchive WriteAr(Writer);
+	SaveData.WriteToArchive(WriteAr);
+
+	FMemoryReader Reader(Bytes);
+	FSpudChunkedDataArchive ReadAr(Reader);
+	FSpudTableOfContents Toc;
+	if (TestTrue("TOC should be read", FSpudSaveData::ReadTableOfContents(ReadAr, Toc)))
+	{
+		TestNotNull("TOC should have global data", Toc.FindEntry(SPUDDATA_GLOBALDATA_MAGIC));
+		const FSpudTocEntry* EntryB = Toc.FindLevel("LevelB");
+		if (TestNotNull("TOC should have LevelB", EntryB))
+		{
+			TestTrue("LevelB should have metadata", EntryB->MetadataOffset > EntryB->Offset);
+		}
+
+		FSpudLevelData LevelB;
+		if (TestTrue("LevelB should be read directly", FSpudSaveData::ReadLevelFromArchive(ReadAr, Toc, "LevelB", LevelB)))
+		{
+			if (TestEqual("LevelB destroyed actors", LevelB.DestroyedActors.Values.Num(), 1))
+				TestEqual("LevelB destroyed actor name", LevelB.DestroyedActors.Values[0]->Name, FString("ActorB"));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestCompressedLevelData, "SPUDTest.CompressedLevelData",
+	EAutomationTestFlags::EditorContext |
+	EAutomationTestFlags::ClientContext |
+	EAutomationTestFlags::ProductFilter)
+
+bool FTestCompressedLevelData::RunTest(const FString& Parameters)
+{
+	FSpudSaveData SaveData;
+	SaveData.PrepareForWrite();
+	SaveData.CreateLevelData("LevelA")->DestroyedActors.Add("ActorA");
+
+	const FName OldFormat = GSpudLevelDataCompressionFormat;
+	GSpudLevelDataCompressionFormat = NAME_Zlib;
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	FSpudChunkedDataArchive WriteAr(Writer);
+	SaveData.WriteToArchive(WriteAr);
+	GSpudLevelDataCompressionFormat = OldFormat;
+
+	FMemoryReader Reader(Bytes);
+	FSpudChunkedDataArchive ReadAr(Reader);
+	FSpudTableOfContents Toc;
+	if (TestTrue("TOC should be read", FSpudSaveData::ReadTableOfContents(ReadAr, Toc)))
+	{
+		const FSpudTocEntry* EntryA = Toc.FindLevel("LevelA");
+		if (TestNotNull("TOC should have LevelA", EntryA))
+		{
+			TestEqual("LevelA should be compressed", EntryA->Magic, FSpudChunkHeader::EncodeMagic(SPUDDATA_COMPRESSEDLEVELDATA_MAGIC));
+		}
+	}
+
+	FSpudSaveData LoadedData;
+	LoadedData.ReadFromArchive(ReadAr, true, "");
+	auto LevelA = LoadedData.GetLevelData("LevelA", false, "");
+	if (TestTrue("LevelA should be loaded", LevelA.IsValid()))
+	{
+		if (TestEqual("LevelA destroyed actors", LevelA->DestroyedActors.Values.Num(), 1))
+			TestEqual("LevelA destroyed actor name", LevelA->DestroyedActors.Values[0]->Name, FString("ActorA"));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestLargeArrays, "SPUDTest.LargeArrays",
+	EAutomationTestFlags::EditorContext |
+	EAutomationTestFlags::ClientContext |
+	EAutomationTestFlags::ProductFilter)
+
+bool FTestLargeArrays::RunTest(const FString& Parameters)
+{
+	// More elements than fit in the old 16-bit array count
+	constexpr int32 NumElems = 70000;
+	auto SavedObj = NewObject<UTestSaveObjectBasic>();
+	for (int32 i = 0; i < NumElems; ++i)
+	{
+		SavedObj->IntArray.Add(i);
+		SavedObj->NameArray.Add(FName("Elem", i));
+	}
+
+	auto State = NewObject<USpudState>();
+	State->StoreGlobalObject(SavedObj, "LargeArrays");
+
+	auto LoadedObj = NewObject<UTestSaveObjectBasic>();
+	State->RestoreGlobalObject(LoadedObj, "LargeArrays");
+
+	if (TestEqual("IntArray count", LoadedObj->IntArray.Num(), NumElems))
+		TestEqual("IntArray last", LoadedObj->IntArray.Last(), NumElems - 1);
+	if (TestEqual("NameArray count", LoadedObj->NameArray.Num(), NumElems))
+		TestEqual("NameArray last", LoadedObj->NameArray.Last(), FName("Elem", NumElems - 1));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestMapsAndSets, "SPUDTest.MapsAndSets",
+	EAutomationTestFlags::EditorContext |
+	EAutomationTestFlags::ClientContext |
+	EAutomationTestFlags::ProductFilter)
+
+bool FTestMapsAndSets::RunTest(const FString& Parameters)
+{
+	auto SavedObj = NewObject<UTestSaveObjectBasic>();
+	SavedObj->IntSet = { 3, 7, 11 };
+	const FGuid Guid = FGuid::NewGuid();
+	SavedObj->GuidSet.Add(Guid);
+	SavedObj->NameToIntMap.Add("One", 1);
+	SavedObj->NameToIntMap.Add("Two", 2);
+	SavedObj->IntToVectorMap.Add(5, FVector(1, 2, 3));
+	// Leave a hole in the sparse storage
+	SavedObj->IntSet.Add(99);
+	SavedObj->IntSet.Remove(7);
+
+	auto State = NewObject<USpudState>();
+	State->StoreGlobalObject(SavedObj, "MapsAndSets");
+
+	auto LoadedObj = NewObject<UTestSaveObjectBasic>();
+	LoadedObj->IntSet.Add(1000); // should be replaced
+	State->RestoreGlobalObject(LoadedObj, "MapsAndSets");
+
+	TestEqual("IntSet count", LoadedObj->IntSet.Num(), 3);
+	TestTrue("IntSet contents", LoadedObj->IntSet.Contains(3) && LoadedObj->IntSet.Contains(11) && LoadedObj->IntSet.Contains(99));
+	TestTrue("GuidSet contents", LoadedObj->GuidSet.Num() == 1 && LoadedObj->GuidSet.Contains(Guid));
+	TestEqual("NameToIntMap count", LoadedObj->NameToIntMap.Num(), 2);
+	const int* Two = LoadedObj->NameToIntMap.Find("Two");
+	TestTrue("NameToIntMap value", Two && *Two == 2);
+	const FVector* Vec = LoadedObj->IntToVectorMap.Find(5);
+	TestTrue("IntToVectorMap value", Vec && Vec->Equals(FVector(1, 2, 3)));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestCompactEncoding, "SPUDTest.CompactEncoding",
+	EAutomationTestFlags::EditorContext |
+	EAutomationTestFlags::ClientContext |
+	EAutomationTestFlags::ProductFilter)
+
+bool FTestCompactEncoding::RunTest(const FString& Parameters)
+{
+	const FSpudEncodingProfile OldProfile = GSpudEncodingProfile;
+
+	auto SavedObj = NewObject<UTestSaveObjectBasic>();
+	PopulateAllTypes(*SavedObj);
+
+	// Without quantization everything should come back exactly
+	GSpudEncodingProfile = FSpudEncodingProfile();
+	GSpudEncodingProfile.bCompact = true;
+	auto State = NewObject<USpudState>();
+	State->StoreGlobalObject(SavedObj, "TestObject");
+
+	auto LoadedObj = NewObject<UTestSaveObjectBasic>();
+	State->RestoreGlobalObject(LoadedObj, "TestObject");
+	CheckAllTypes(this, "CompactObject|", *LoadedObj, *SavedObj);
+
+	// Quantized values are within a step
+	GSpudEncodingProfile.PositionQuantum = 0.01f;
+	GSpudEncodingProfile.RotationQuantum = 0.01f;
+	GSpudEncodingProfile.ScaleQuantum = 0.001f;
+	auto QuantizedState = NewObject<USpudState>();
+	QuantizedState->StoreGlobalObject(SavedObj, "TestObject");
+
+	LoadedObj = NewObject<UTestSaveObjectBasic>();
+	QuantizedState->RestoreGlobalObject(LoadedObj, "TestObject");
+	TestTrue("Quantized VectorVal should be close", LoadedObj->VectorVal.Equals(SavedObj->VectorVal, 0.01));
+	TestTrue("Quantized RotatorVal should be close", LoadedObj->RotatorVal.Equals(SavedObj->RotatorVal, 0.01));
+	TestTrue("Quantized TransformVal should be close", LoadedObj->TransformVal.Equals(SavedObj->TransformVal, 0.01));
+	TestEqual("Int64Val should be exact", LoadedObj->Int64Val, SavedObj->Int64Val);
+
+	GSpudEncodingProfile = OldProfile;
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestArchetypeDeltas, "SPUDTest.ArchetypeDeltas",
+	EAutomationTestFlags::EditorContext |
+	EAutomationTestFlags::ClientContext |
+	EAutomationTestFlags::ProductFilter)
+
+bool FTestArchetypeDeltas::RunTest(const FString& Parameters)
+{
+	const bool bOldDeltas = GSpudStoreArchetypeDeltas;
+	GSpudStoreArchetypeDeltas = true;
+
+	// Fully changed object should come back exactly
+	auto SavedObj = NewObject<UTestSaveObjectBasic>();
+	PopulateAllTypes(*SavedObj);
+	auto State = NewObject<USpudState>();
+	State->StoreGlobalObject(SavedObj, "TestObject");
+
+	auto LoadedObj = NewObject<UTestSaveObjectBasic>();
+	State->RestoreGlobalObject(LoadedObj, "TestObject");
+	CheckAllTypes(this, "DeltaObject|", *LoadedObj, *SavedObj);
+
+	// Mostly default object; unchanged properties must go back to the defaults, not keep what was there
+	auto DefaultObj = NewObject<UTestSaveObjectBasic>();
+	DefaultObj->IntVal = 42;
+	auto DefaultState = NewObject<USpudState>();
+	DefaultState->StoreGlobalObject(DefaultObj, "TestObject");
+
+	LoadedObj = NewObject<UTestSaveObjectBasic>();
+	PopulateAllTypes(*LoadedObj);
+	DefaultState->RestoreGlobalObject(LoadedObj, "TestObject");
+	TestEqual("IntVal should be restored", LoadedObj->IntVal, 42);
+	TestEqual("StringVal should be reset to default", LoadedObj->StringVal, DefaultObj->StringVal);
+	TestEqual("FloatVal should be reset to default", LoadedObj->FloatVal, DefaultObj->FloatVal);
+	TestEqual("IntArray should be reset to default", LoadedObj->IntArray.Num(), DefaultObj->IntArray.Num());
+
+	GSpudStoreArchetypeDeltas = bOldDeltas;
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestIncrementalLevelStore, "SPUDTest.IncrementalLevelStore",
+	EAutomationTestFlags::EditorContext |
+	EAutomationTestFlags::ClientContext |
+	EAutomationTestFlags::ProductFilter)
+
+bool FTestIncrementalLevelStore::RunTest(const FString& Parameters)
+{
+	const bool bOldIncremental = GSpudIncrementalLevelStore;
+
+	FSpudTestWorld TestWorld;
+	auto Tracked = TestWorld.SpawnTestActor(1, true);
+	auto Untracked = TestWorld.SpawnTestActor(2);
+	auto Removed = TestWorld.SpawnTestActor(3);
+
+	GSpudIncrementalLevelStore = true;
+	auto State = NewObject<USpudState>();
+	State->StoreLevel(TestWorld.GetLevel(), false, true);
+
+	// Change things between stores; only the tracked actor needs to say so
+	Tracked->StringVal = "Tracked change";
+	State->MarkObjectDirty(Tracked);
+	Untracked->StringVal = "Untracked change";
+	Untracked->SetActorLocation(FVector(100, 200, 300));
+	Removed->Destroy();
+	TestWorld.SpawnTestActor(4);
+	State->StoreLevel(TestWorld.GetLevel(), false, true);
+
+	GSpudIncrementalLevelStore = false;
+	auto FullState = NewObject<USpudState>();
+	FullState->StoreLevel(TestWorld.GetLevel(), false, true);
+
+	GSpudIncrementalLevelStore = bOldIncremental;
+
+	const TArray<uint8> IncrementalBytes = GetLevelDataBytes(State, TestWorld.GetLevelName());
+	const TArray<uint8> FullBytes = GetLevelDataBytes(FullState, TestWorld.GetLevelName());
+	TestTrue("Level data should have been stored", FullBytes.Num() > 0);
+	TestTrue("Incremental store should produce the same level data as a full store", IncrementalBytes == FullBytes);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestDirtyTracking, "SPUDTest.DirtyTracking",
+	EAutomationTestFlags::EditorContext |
+	EAutomationTestFlags::ClientContext |
+	EAutomationTestFlags::ProductFilter)
+
+bool FTestDirtyTracking::RunTest(const FString& Parameters)
+{
+	const bool bOldIncremental = GSpudIncrementalLevelStore;
+	GSpudIncrementalLevelStore = true;
+
+	FSpudTestWorld TestWorld;
+	auto Tracked = TestWorld.SpawnTestActor(1, true);
+	Tracked->StringVal = "Stored";
+
+	auto State = NewObject<USpudState>();
+	State->StoreLevel(TestWorld.GetLevel(), false, true);
+	const TArray<uint8> FirstBytes = GetLevelDataBytes(State, TestWorld.GetLevelName());
+
+	// Not marked dirty, so the properties are skipped and the record kept as it was
+	Tracked->StringVal = "Changed without marking";
+	State->StoreLevel(TestWorld.GetLevel(), false, true);
+	TestTrue("Clean actor's record should be kept", GetLevelDataBytes(State, TestWorld.GetLevelName()) == FirstBytes);
+
+	// Marked dirty, so re-encoded the same as a full store would
+	Tracked->StringVal = "Changed and marked";
+	State->MarkObjectDirty(Tracked);
+	State->StoreLevel(TestWorld.GetLevel(), false, true);
+
+	GSpudIncrementalLevelStore = false;
+	auto FullState = NewObject<USpudState>();
+	FullState->StoreLevel(TestWorld.GetLevel(), false, true);
+	GSpudIncrementalLevelStore = bOldIncremental;
+
+	const TArray<uint8> DirtyBytes = GetLevelDataBytes(State, TestWorld.GetLevelName());
+	TestFalse("Dirty actor's record should be replaced", DirtyBytes == FirstBytes);
+	TestTrue("Dirty actor's record should be re-encoded", DirtyBytes == GetLevelDataBytes(FullState, TestWorld.GetLevelName()));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestObjectRefIndex, "SPUDTest.ObjectRefIndex",
+	EAutomationTestFlags::EditorContext |
+	EAutomationTestFlags::ClientContext |
+	EAutomationTestFlags::ProductFilter)
+
+bool FTestObjectRefIndex::RunTest(const FString& Parameters)
+{
+	const FSpudEncodingProfile OldProfile = GSpudEncodingProfile;
+
+	// Same references with and without the reference table
+	for (const bool bIndexed : { true, false })
+	{
+		const FString Prefix = bIndexed ? "Indexed|" : "Strings|";
+		GSpudEncodingProfile = FSpudEncodingProfile();
+		GSpudEncodingProfile.bIndexedObjectRefs = bIndexed;
+
+		FSpudTestWorld TestWorld;
+		// Pretend this came from the level, so it's referenced by name rather than GUID
+		auto LevelActor = TestWorld.SpawnTestActor(1);
+		LevelActor->SetFlags(RF_WasLoaded);
+		auto RuntimeActor = TestWorld.SpawnTestActor(2);
+		LevelActor->ActorRefs = { RuntimeActor, nullptr, RuntimeActor };
+		RuntimeActor->ActorRefs = { LevelActor };
+
+		auto State = NewObject<USpudState>();
+		State->StoreLevel(TestWorld.GetLevel(), false, true);
+
+		auto LevelData = State->SaveData.GetLevelData(TestWorld.GetLevelName(), false, "");
+		if (!TestTrue(Prefix + "Level should have been stored", LevelData.IsValid()))
+			continue;
+
+		const auto& Refs = LevelData->Metadata.ObjectRefIndex.UniqueValues;
+		if (bIndexed)
+		{
+			// Each actor once, however many times it's referenced; nulls aren't in the table
+			if (TestEqual(Prefix + "Reference table size", Refs.Num(), 2))
+			{
+				TestTrue(Prefix + "Runtime actor referenced by GUID",
+					Refs.Contains(FSpudObjectRef(SpudPropertyUtil::GetGuidProperty(RuntimeActor))));
+				TestTrue(Prefix + "Level actor referenced by name",
+					Refs.Contains(FSpudObjectRef(SpudPropertyUtil::GetLevelActorName(LevelActor))));
+			}
+		}
+		else
+		{
+			TestEqual(Prefix + "Reference table should be unused", Refs.Num(), 0);
+		}
+
+		// Reference table & class def flags survive being written out
+		TArray<uint8> Bytes = GetLevelDataBytes(State, TestWorld.GetLevelName());
+		FMemoryReader Reader(Bytes);
+		FSpudChunkedDataArchive ReadAr(Reader);
+		FSpudLevelData LoadedData;
+		LoadedData.ReadFromArchive(ReadAr, SPUD_CURRENT_SYSTEM_VERSION);
+		TestTrue(Prefix + "Reference table should be read back", LoadedData.Metadata.ObjectRefIndex.UniqueValues == Refs);
+		const auto ClassDef = LoadedData.Metadata.GetClassDef(SpudPropertyUtil::GetClassName(LevelActor));
+		if (TestNotNull(Prefix + "Class def should be read back", ClassDef.Get()))
+			TestEqual(Prefix + "Class def reference encoding", ClassDef->Encoding.bIndexedObjectRefs, bIndexed);
+
+		// Runtime actor is respawned, and references to & from it resolved again
+		RuntimeActor->Destroy();
+		LevelActor->ActorRefs = { LevelActor };
+		State->RestoreLevel(TestWorld.GetLevel());
+
+		ATestSaveActor* Respawned = nullptr;
+		for (auto Actor : TestWorld.GetLevel()->Actors)
+		{
+			auto TestActor = Cast<ATestSaveActor>(Actor);
+			if (IsValid(TestActor) && TestActor->IntVal == 2)
+				Respawned = TestActor;
+		}
+		if (TestNotNull(Prefix + "Runtime actor should be respawned", Respawned))
+		{
+			if (TestEqual(Prefix + "Level actor refs", LevelActor->ActorRefs.Num(), 3))
+			{
+				TestTrue(Prefix + "Level actor ref 0", LevelActor->ActorRefs[0] == Respawned);
+				TestTrue(Prefix + "Level actor ref 1 should be null", LevelActor->ActorRefs[1] == nullptr);
+				TestTrue(Prefix + "Level actor ref 2", LevelActor->ActorRefs[2] == Respawned);
+			}
+			if (TestEqual(Prefix + "Runtime actor refs", Respawned->ActorRefs.Num(), 1))
+				TestTrue(Prefix + "Runtime actor ref 0", Respawned->ActorRefs[0] == LevelActor);
+		}
+	}
+
+	// Class defs written before the reference table have no trailer, and must be read as using strings
+	FSpudClassDef LegacyDef;
+	LegacyDef.ClassName = "LegacyClass";
+	LegacyDef.Encoding.bIndexedObjectRefs = false;
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	FSpudChunkedDataArchive WriteAr(Writer);
+	LegacyDef.WriteToArchive(WriteAr);
+
+	FMemoryReader Reader(Bytes);
+	FSpudChunkedDataArchive ReadAr(Reader);
+	FSpudClassDef LoadedDef;
+	LoadedDef.Encoding.bIndexedObjectRefs = true;
+	LoadedDef.ReadFromArchive(ReadAr, SPUD_CURRENT_SYSTEM_VERSION);
+	TestEqual("Legacy class def name", LoadedDef.ClassName, LegacyDef.ClassName);
+	TestFalse("Legacy class def should not use the reference table", LoadedDef.Encoding.bIndexedObjectRefs);
+
+	GSpudEncodingProfile = OldProfile;
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTestTimeSlicedRestore, "SPUDTest.TimeSlicedRestore",
+	EAutomationTestFlags::EditorContext |
+	EAutomationTestFlags::ClientContext |
+	EAutomationTestFlags::ProductFilter)
+
+bool FTestTimeSlicedRestore::RunTest(const FString& Parameters)
+{
+	FSpudTestWorld TestWorld;
+	ULevel* Level = TestWorld.GetLevel();
+	const FString LevelName = TestWorld.GetLevelName();
+
+	// Level actors at 300, 200, 100 from the origin, so nearest last in level order
+	TArray<ATestSaveActor*> LevelActors;
+	for (int i = 0; i < 3; ++i)
+	{
+		auto Actor = TestWorld.SpawnTestActor(i + 1, false, FVector((3 - i) * 100, 0, 0));
+		Actor->SetFlags(RF_WasLoaded);
+		LevelActors.Add(Actor);
+	}
+	auto RuntimeActor = TestWorld.SpawnTestActor(10, false, FVector(1000, 0, 0));
+	LevelActors[0]->ActorRefs = { RuntimeActor };
+
+	auto State = NewObject<USpudState>();
+	State->StoreLevel(Level, false, true);
+
+	// Lose everything a restore should bring back
+	auto Scramble = [&]()
+	{
+		TArray<AActor*> RuntimeActors;
+		for (auto Actor : Level->Actors)
+		{
+			if (IsValid(Actor) && Actor->IsA<ATestSaveActor>() && !Actor->HasAnyFlags(RF_WasLoaded))
+				RuntimeActors.Add(Actor);
+		}
+		for (auto Actor : RuntimeActors)
+			Actor->Destroy();
+		for (auto Actor : LevelActors)
+		{
+			Actor->IntVal = -1;
+			Actor->ActorRefs.Empty();
+		}
+	};
+	auto StoreFresh = [&]()
+	{
+		auto FreshState = NewObject<USpudState>();
+		FreshState->StoreLevel(Level, false, true);
+		return GetLevelDataBytes(FreshState, LevelName);
+	};
+
+	Scramble();
+	State->RestoreLevel(Level);
+	const TArray<uint8> RestoredBytes = StoreFresh();
+	TestEqual("RestoreLevel should restore level actors", LevelActors[0]->IntVal, 1);
+
+	// Stepped with no budget, so one actor at a time
+	Scramble();
+	if (TestTrue("Time sliced restore should begin", State->BeginIncrementalRestoreLevel(Level, FVector::ZeroVector)))
+	{
+		TArray<int> RestoreOrder;
+		int Steps = 0;
+		while (State->IsIncrementalRestoreInProgress(LevelName) && Steps < 100)
+		{
+			State->UpdateIncrementalRestores(0);
+			++Steps;
+			for (auto Actor : LevelActors)
+			{
+				if (Actor->IntVal != -1 && !RestoreOrder.Contains(Actor->IntVal))
+					RestoreOrder.Add(Actor->IntVal);
+			}
+		}
+		TestFalse("Time sliced restore should complete", State->IsIncrementalRestoreInProgress(LevelName));
+		TestTrue("Time sliced restore should take several steps", Steps > LevelActors.Num());
+		TestTrue("Level actors should be restored nearest first", RestoreOrder == TArray<int>({ 3, 2, 1 }));
+		TestTrue("Time sliced restore should succeed", State->FinishIncrementalRestore(LevelName));
+		TestTrue("Time sliced restore should match RestoreLevel", StoreFresh() == RestoredBytes);
+	}
+
+	// Storing the level completes the restore first
+	Scramble();
+	if (TestTrue("Restore before store should begin", State->BeginIncrementalRestoreLevel(Level, FVector::ZeroVector)))
+	{
+		State->UpdateIncrementalRestores(0);
+		TestTrue("Restore before store should be in progress", State->IsIncrementalRestoreInProgress(LevelName));
+		State->StoreLevel(Level, false, true);
+		TestFalse("Store should complete the restore", State->IsIncrementalRestoreInProgress(LevelName));
+		TestTrue("Restore completed by store should succeed", State->FinishIncrementalRestore(LevelName));
+		TestTrue("Restore completed by store should match RestoreLevel", StoreFresh() == RestoredBytes);
+	}
+
+	// Cancelled, as when loading a game
+	Scramble();
+	if (TestTrue("Cancelled restore should begin", State->BeginIncrementalRestoreLevel(Level, FVector::ZeroVector)))
+	{
+		State->UpdateIncrementalRestores(0);
+		State->CancelIncrementalRestores();
+		TestFalse("Cancelled restore should not be in progress", State->IsIncrementalRestoreInProgress(LevelName));
+		State->UpdateIncrementalRestores(0);
+		TestEqual("Cancelled restore should not continue", LevelActors[0]->IntVal, -1);
+		TestFalse("Cancelled restore should not succeed", State->FinishIncrementalRestore(LevelName));
+	}
+
+	// Abandoned because the level data went away
+	if (TestTrue("Abandoned restore should begin", State->BeginIncrementalRestoreLevel(Level, FVector::ZeroVector)))
+	{
+		auto LevelData = State->SaveData.GetLevelData(LevelName, false, "");
+		const auto OldStatus = LevelData->Status;
+		LevelData->Status = LDS_Unloaded;
+		State->UpdateIncrementalRestores(0);
+		LevelData->Status = OldStatus;
+		TestFalse("Abandoned restore should not be in progress", State->IsIncrementalRestoreInProgress(LevelName));
+		TestFalse("Abandoned restore should not succeed", State->FinishIncrementalRestore(LevelName));
+	}
+
+	return true;
+}
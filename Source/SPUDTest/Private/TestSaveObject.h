@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "ISpudObject.h"
+#include "GameFramework/Actor.h"
 #if ENGINE_MAJOR_VERSION==5&&ENGINE_MINOR_VERSION>=5
 #include "StructUtils/InstancedStruct.h"
 #else
@@ -278,6 +279,16 @@ public:
 	TArray<FString> StringArray;
 	UPROPERTY(SaveGame)
 	TArray<FText> TextArray;
+
+	// Maps & sets of primitive / builtin struct types
+	UPROPERTY(SaveGame)
+	TSet<int> IntSet;
+	UPROPERTY(SaveGame)
+	TSet<FGuid> GuidSet;
+	UPROPERTY(SaveGame)
+	TMap<FName, int> NameToIntMap;
+	UPROPERTY(SaveGame)
+	TMap<int, FVector> IntToVectorMap;
 };
 
 
@@ -544,4 +555,29 @@ public:
 	
 	UPROPERTY(SaveGame)
 	TMap<int, TObjectPtr<UObject>> UObjectMap;
-};
\ No newline at end of file
+};
+
+/// Actor for tests which store & restore levels. Spawned at runtime, so respawned on restore
+UCLASS()
+class SPUDTEST_API ATestSaveActor : public AActor, public ISpudObject
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(SaveGame)
+	FGuid SpudGuid;
+
+	UPROPERTY(SaveGame)
+	int IntVal;
+
+	UPROPERTY(SaveGame)
+	FString StringVal;
+
+	UPROPERTY(SaveGame)
+	TArray<TObjectPtr<AActor>> ActorRefs;
+
+	/// Whether this actor promises to call MarkSpudDirty when it changes
+	bool bDirtyTracking = false;
+
+	virtual bool UsesSpudDirtyTracking_Implementation() const override { return bDirtyTracking; }
+};